@@ -0,0 +1,245 @@
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "lib/cache-eviction-policy.h"
+#include "lib/udp-traffic-cache-cp-helper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Compares the runtime-polymorphic UdpCacheServer with the BasicUdpCacheServer
+// instantiations:
+//  1. a Zipf trace replayed through each policy, once through a
+//     CacheEvictionPolicy reference and once through the final policy type,
+//     with the same lookup/evict/insert sequence as the cache server;
+//  2. the same simulation run with ns3::UdpCacheServer and with the
+//     specialized TypeId, timing the wall clock of Simulator::Run(). The
+//     clients draw Zipf ids over the catalogue and the cache is larger than
+//     SmallCacheThreshold, so both variants evict through the same policy.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CacheServerBench");
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+std::vector<uint32_t>
+MakeZipfTrace(uint32_t requests, uint32_t catalogue, double alpha)
+{
+    std::vector<double> cdf(catalogue);
+    double sum = 0;
+    for (uint32_t i = 0; i < catalogue; i++)
+    {
+        sum += 1.0 / std::pow(i + 1, alpha);
+        cdf[i] = sum;
+    }
+
+    Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+    uniform->SetStream(1);
+    std::vector<uint32_t> trace(requests);
+    for (auto& id : trace)
+    {
+        double u = uniform->GetValue(0, sum);
+        id = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin() + 1;
+    }
+    return trace;
+}
+
+template <typename Cache>
+uint64_t
+Replay(Cache& cache, const std::vector<uint32_t>& trace)
+{
+    uint64_t hits = 0;
+    for (uint32_t id : trace)
+    {
+        if (cache.Lookup(id))
+        {
+            hits++;
+            continue;
+        }
+        while (cache.GetSize() >= cache.GetCapacity())
+        {
+            cache.Remove(cache.SelectVictim(id));
+        }
+        cache.Insert(id);
+    }
+    return hits;
+}
+
+template <typename Policy>
+void
+CompareReplay(CacheEvictionPolicy::PolicyType type,
+              uint32_t cacheSize,
+              const std::vector<uint32_t>& trace)
+{
+    Ptr<CacheEvictionPolicy> dynamicPolicy = CacheEvictionPolicy::CreatePolicy(type, cacheSize);
+    auto start = Clock::now();
+    uint64_t hits = Replay<CacheEvictionPolicy>(*dynamicPolicy, trace);
+    double dynamicNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    Ptr<Policy> staticPolicy = Create<Policy>(cacheSize);
+    start = Clock::now();
+    uint64_t staticHits = Replay<Policy>(*staticPolicy, trace);
+    double staticNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    NS_ABORT_MSG_IF(hits != staticHits, "The two variants diverged");
+    std::cout << std::left << std::setw(10) << dynamicPolicy->GetName() << std::right
+              << std::setw(10) << std::fixed << std::setprecision(4)
+              << double(hits) / trace.size() << std::setw(14) << std::setprecision(1)
+              << dynamicNs / trace.size() << std::setw(14) << staticNs / trace.size()
+              << std::setw(10) << std::setprecision(2) << dynamicNs / staticNs << std::endl;
+}
+
+double
+RunSimulation(std::string typeId,
+              std::string policy,
+              uint32_t cacheSize,
+              uint32_t catalogue,
+              double alpha,
+              uint32_t requests,
+              uint32_t clients)
+{
+    NodeContainer nodes;
+    nodes.Create(3);
+    NodeContainer clientCache(nodes.Get(0), nodes.Get(1));
+    NodeContainer cacheServer(nodes.Get(1), nodes.Get(2));
+
+    InternetStackHelper internet;
+    internet.Install(nodes);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", DataRateValue(DataRate("1Gb/s")));
+    p2p.SetChannelAttribute("Delay", TimeValue(MilliSeconds(5)));
+    NetDeviceContainer devClientCache = p2p.Install(clientCache);
+    NetDeviceContainer devCacheServer = p2p.Install(cacheServer);
+
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer ipClientCache = ipv4.Assign(devClientCache);
+    ipv4.SetBase("10.1.2.0", "255.255.255.0");
+    Ipv4InterfaceContainer ipCacheServer = ipv4.Assign(devCacheServer);
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    uint16_t contentPort = 15;
+    uint16_t cachePort = 9;
+    UdpContentProviderHelper contentServer(contentPort);
+    contentServer.Install(nodes.Get(2)).Start(Seconds(0.0));
+
+    UdpCacheServerHelper cache(Address(ipCacheServer.GetAddress(1)), contentPort, cachePort);
+    cache.SetTypeId(typeId);
+    cache.SetAttribute("CacheSize", UintegerValue(cacheSize));
+    cache.SetAttribute("EvictionPolicy", StringValue(policy));
+    cache.Install(nodes.Get(1)).Start(Seconds(0.5));
+
+    UdpTrafficGeneratorHelper client(Address(ipClientCache.GetAddress(1)), cachePort);
+    client.SetAttribute("MaxPackets", UintegerValue(requests));
+    client.SetAttribute("Interval", TimeValue(MicroSeconds(100)));
+    // the same popularity as the trace, so the cache also evicts in the simulations
+    client.SetAttribute("Popularity", StringValue("ZIPF"));
+    client.SetAttribute("CatalogueSize", UintegerValue(catalogue));
+    client.SetAttribute("ZipfExponent", DoubleValue(alpha));
+    ApplicationContainer apps;
+    for (uint32_t i = 0; i < clients; i++)
+    {
+        apps.Add(client.Install(nodes.Get(0)));
+    }
+    apps.Start(Seconds(1.0));
+
+    auto start = Clock::now();
+    Simulator::Run();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    Simulator::Destroy();
+    return seconds;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t requests = 2000000;
+    uint32_t catalogue = 1000000;
+    uint32_t cacheSize = 100000;
+    double alpha = 0.8;
+    uint32_t simRequests = 20000;
+    uint32_t simCacheSize = 1000;
+    uint32_t clients = 4;
+    bool simulate = true;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("requests", "Requests in the replayed trace", requests);
+    cmd.AddValue("catalogue", "Number of distinct ids in the replayed trace", catalogue);
+    cmd.AddValue("cacheSize", "Cache size in ids", cacheSize);
+    cmd.AddValue("alpha", "Zipf exponent of the replayed trace", alpha);
+    cmd.AddValue("simulate", "Also time full simulations", simulate);
+    cmd.AddValue("simRequests", "Requests per client in the simulations", simRequests);
+    cmd.AddValue("simCacheSize", "Cache size in ids in the simulations", simCacheSize);
+    cmd.AddValue("clients", "Clients in the simulations", clients);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(catalogue <= std::max(cacheSize, simCacheSize),
+                    "The catalogue must be larger than the cache, or no policy ever evicts");
+
+    std::vector<uint32_t> trace = MakeZipfTrace(requests, catalogue, alpha);
+
+    std::cout << "Trace replay: " << requests << " requests, " << catalogue << " ids, cache "
+              << cacheSize << ", alpha " << alpha << std::endl;
+    std::cout << std::left << std::setw(10) << "policy" << std::right << std::setw(10) << "hit"
+              << std::setw(14) << "virtual ns" << std::setw(14) << "static ns" << std::setw(10)
+              << "speedup" << std::endl;
+    CompareReplay<FifoCachePolicy>(CacheEvictionPolicy::FIFO, cacheSize, trace);
+    CompareReplay<LruCachePolicy>(CacheEvictionPolicy::LRU, cacheSize, trace);
+    CompareReplay<LfuCachePolicy>(CacheEvictionPolicy::LFU, cacheSize, trace);
+    CompareReplay<TwoQueueCachePolicy>(CacheEvictionPolicy::TWO_Q, cacheSize, trace);
+    CompareReplay<ArcCachePolicy>(CacheEvictionPolicy::ARC, cacheSize, trace);
+    CompareReplay<SieveCachePolicy>(CacheEvictionPolicy::SIEVE, cacheSize, trace);
+    CompareReplay<S3FifoCachePolicy>(CacheEvictionPolicy::S3_FIFO, cacheSize, trace);
+    CompareReplay<GdsfCachePolicy>(CacheEvictionPolicy::GDSF, cacheSize, trace);
+
+    if (simulate)
+    {
+        const std::vector<std::pair<std::string, std::string>> variants = {
+            {"FIFO", "ns3::FifoUdpCacheServer"},
+            {"LRU", "ns3::LruUdpCacheServer"},
+            {"S3-FIFO", "ns3::S3FifoUdpCacheServer"},
+        };
+        if (system("mkdir -p output") != 0)
+        {
+            NS_LOG_WARN("Could not create the output directory");
+        }
+        std::cout << std::endl
+                  << "Simulation: " << clients << " clients x " << simRequests << " requests, "
+                  << catalogue << " ids, cache " << simCacheSize << std::endl;
+        std::cout << std::left << std::setw(10) << "policy" << std::right << std::setw(14)
+                  << "runtime s" << std::setw(14) << "specialized s" << std::endl;
+        for (const auto& variant : variants)
+        {
+            double dynamicTime = RunSimulation("ns3::UdpCacheServer",
+                                               variant.first,
+                                               simCacheSize,
+                                               catalogue,
+                                               alpha,
+                                               simRequests,
+                                               clients);
+            double staticTime = RunSimulation(variant.second,
+                                              variant.first,
+                                              simCacheSize,
+                                              catalogue,
+                                              alpha,
+                                              simRequests,
+                                              clients);
+            std::cout << std::left << std::setw(10) << variant.first << std::right
+                      << std::setw(14) << std::setprecision(3) << dynamicTime << std::setw(14)
+                      << staticTime << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "bloom-filter.h"
+
+#include "hash-util.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+BloomFilter::BloomFilter()
+    : m_bits(0),
+      m_hashes(0)
+{
+}
+
+void
+BloomFilter::Configure(uint32_t bits, uint32_t hashes)
+{
+    m_bits = std::max<uint32_t>(bits, 1);
+    m_hashes = std::max<uint32_t>(hashes, 1);
+    m_words.assign((m_bits + 63) / 64, 0);
+}
+
+bool
+BloomFilter::IsEmpty() const
+{
+    return m_bits == 0;
+}
+
+void
+BloomFilter::Insert(uint32_t id)
+{
+    for (uint32_t i = 0; i < m_hashes; i++)
+    {
+        SetBit(Position(id, i, m_bits));
+    }
+}
+
+bool
+BloomFilter::Contains(uint32_t id) const
+{
+    if (m_bits == 0)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < m_hashes; i++)
+    {
+        uint32_t position = Position(id, i, m_bits);
+        if (!(m_words[position / 64] & (uint64_t(1) << (position % 64))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+double
+BloomFilter::GetFillRatio() const
+{
+    if (m_bits == 0)
+    {
+        return 0;
+    }
+    uint32_t set = 0;
+    for (uint64_t word : m_words)
+    {
+        set += __builtin_popcountll(word);
+    }
+    return double(set) / m_bits;
+}
+
+void
+BloomFilter::Serialize(std::vector<uint8_t>& buffer) const
+{
+    uint32_t rawSize = (m_bits + 7) / 8;
+    buffer.assign(PREAMBLE, 0);
+    buffer[0] = GAPS;
+    buffer[1] = static_cast<uint8_t>(m_hashes);
+    buffer[2] = static_cast<uint8_t>(m_bits >> 24);
+    buffer[3] = static_cast<uint8_t>(m_bits >> 16);
+    buffer[4] = static_cast<uint8_t>(m_bits >> 8);
+    buffer[5] = static_cast<uint8_t>(m_bits);
+
+    // a sparse filter is smaller as the gaps between its set bits
+    uint32_t next = 0;
+    bool sparse = true;
+    for (uint32_t w = 0; w < m_words.size() && sparse; w++)
+    {
+        uint64_t word = m_words[w];
+        while (word)
+        {
+            uint32_t position = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+            uint32_t gap = position - next;
+            next = position + 1;
+            while (gap >= 0x80)
+            {
+                buffer.push_back(static_cast<uint8_t>(gap | 0x80));
+                gap >>= 7;
+            }
+            buffer.push_back(static_cast<uint8_t>(gap));
+            if (buffer.size() - PREAMBLE >= rawSize)
+            {
+                sparse = false;
+                break;
+            }
+        }
+    }
+    if (sparse)
+    {
+        return;
+    }
+
+    buffer.resize(PREAMBLE);
+    buffer[0] = RAW;
+    for (uint32_t i = 0; i < rawSize; i++)
+    {
+        buffer.push_back(static_cast<uint8_t>(m_words[i / 8] >> (8 * (i % 8))));
+    }
+}
+
+bool
+BloomFilter::Deserialize(const uint8_t* data, uint32_t size)
+{
+    m_bits = 0;
+    m_hashes = 0;
+    m_words.clear();
+    if (size < PREAMBLE || data[1] == 0)
+    {
+        return false;
+    }
+    uint32_t bits = uint32_t(data[2]) << 24 | uint32_t(data[3]) << 16 | uint32_t(data[4]) << 8 | data[5];
+    if (bits == 0)
+    {
+        return false;
+    }
+    Configure(bits, data[1]);
+
+    if (data[0] == RAW && size - PREAMBLE == (bits + 7) / 8)
+    {
+        for (uint32_t i = 0; i < size - PREAMBLE; i++)
+        {
+            m_words[i / 8] |= uint64_t(data[PREAMBLE + i]) << (8 * (i % 8));
+        }
+        // padding bits past the end are ignored
+        if (bits % 64)
+        {
+            m_words.back() &= (uint64_t(1) << (bits % 64)) - 1;
+        }
+        return true;
+    }
+
+    if (data[0] == GAPS)
+    {
+        uint64_t next = 0;
+        uint32_t i = PREAMBLE;
+        bool valid = true;
+        while (i < size && valid)
+        {
+            uint64_t gap = 0;
+            uint32_t shift = 0;
+            while (i < size && (data[i] & 0x80) && shift < 35)
+            {
+                gap |= uint64_t(data[i++] & 0x7f) << shift;
+                shift += 7;
+            }
+            valid = i < size && shift < 35;
+            if (valid)
+            {
+                next += gap | uint64_t(data[i++]) << shift;
+                valid = next < bits;
+            }
+            if (valid)
+            {
+                SetBit(static_cast<uint32_t>(next++));
+            }
+        }
+        if (valid)
+        {
+            return true;
+        }
+    }
+
+    // truncated or unknown encoding
+    m_words.clear();
+    m_bits = 0;
+    m_hashes = 0;
+    return false;
+}
+
+uint32_t
+BloomFilter::Position(uint32_t id, uint32_t i, uint32_t bits)
+{
+    // Kirsch-Mitzenmacher double hashing, the second hash odd so it never vanishes
+    uint64_t hash = SplitMix64(id);
+    uint64_t h1 = hash & 0xffffffff;
+    uint64_t h2 = (hash >> 32) | 1;
+    return static_cast<uint32_t>((h1 + i * h2) % bits);
+}
+
+void
+BloomFilter::SetBit(uint32_t position)
+{
+    m_words[position / 64] |= uint64_t(1) << (position % 64);
+}
+
+CountingBloomFilter::CountingBloomFilter()
+    : m_hashes(1),
+      m_items(0)
+{
+}
+
+void
+CountingBloomFilter::Configure(uint32_t bits, uint32_t hashes)
+{
+    m_counters.assign(std::max<uint32_t>(bits, 1), 0);
+    m_hashes = std::max<uint32_t>(hashes, 1);
+    m_items = 0;
+}
+
+void
+CountingBloomFilter::Insert(uint32_t id)
+{
+    for (uint32_t i = 0; i < m_hashes; i++)
+    {
+        uint8_t& counter = m_counters[BloomFilter::Position(id, i, m_counters.size())];
+        if (counter < MAX_COUNT)
+        {
+            counter++;
+        }
+    }
+    m_items++;
+}
+
+void
+CountingBloomFilter::Remove(uint32_t id)
+{
+    for (uint32_t i = 0; i < m_hashes; i++)
+    {
+        uint8_t& counter = m_counters[BloomFilter::Position(id, i, m_counters.size())];
+        if (counter > 0 && counter < MAX_COUNT)
+        {
+            counter--;
+        }
+    }
+    if (m_items > 0)
+    {
+        m_items--;
+    }
+}
+
+uint32_t
+CountingBloomFilter::GetItems() const
+{
+    return m_items;
+}
+
+void
+CountingBloomFilter::Export(BloomFilter& summary) const
+{
+    summary.Configure(m_counters.size(), m_hashes);
+    for (uint32_t position = 0; position < m_counters.size(); position++)
+    {
+        if (m_counters[position] > 0)
+        {
+            summary.SetBit(position);
+        }
+    }
+}
+
+} // namespace ns3
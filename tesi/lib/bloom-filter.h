@@ -0,0 +1,146 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Bloom filter summarizing the ids cached by a sibling cache.
+ *
+ * The k positions of an id come from double hashing of its splitmix64
+ * finalizer. The filter travels between caches in a compact form: either
+ * the raw bit array or, for sparse filters, the gaps between consecutive
+ * set bits as variable-length integers, whichever is smaller.
+ */
+class BloomFilter
+{
+  public:
+    BloomFilter();
+
+    /**
+     * \brief Size the filter and clear it.
+     * \param bits bits of the filter
+     * \param hashes positions set per id
+     */
+    void Configure(uint32_t bits, uint32_t hashes);
+
+    /**
+     * \return true if the filter was never configured or received
+     */
+    bool IsEmpty() const;
+
+    /**
+     * \param id the object id
+     */
+    void Insert(uint32_t id);
+
+    /**
+     * \param id the object id
+     * \return true if the id may have been inserted, false if it surely was not
+     */
+    bool Contains(uint32_t id) const;
+
+    /**
+     * \return the share of bits set, whose power of the hash count is the false positive probability
+     */
+    double GetFillRatio() const;
+
+    /**
+     * \brief Write the filter in its compact form.
+     * \param[out] buffer the serialized filter, replaced
+     */
+    void Serialize(std::vector<uint8_t>& buffer) const;
+
+    /**
+     * \brief Replace the filter with a serialized one.
+     * \param data the serialized filter
+     * \param size bytes of data
+     * \return false if the data is malformed, leaving the filter empty
+     */
+    bool Deserialize(const uint8_t* data, uint32_t size);
+
+    /**
+     * \param id the object id
+     * \param i index of the hash function
+     * \param bits bits of the filter
+     * \return the position of the id for the hash function
+     */
+    static uint32_t Position(uint32_t id, uint32_t i, uint32_t bits);
+
+  private:
+    friend class CountingBloomFilter;
+
+    /// Encodings of a serialized filter
+    enum Encoding : uint8_t
+    {
+        RAW = 0,  //!< The bit array, least significant bit first
+        GAPS = 1, //!< The unset bits before each set bit, as LEB128 integers
+    };
+
+    static constexpr uint32_t PREAMBLE = 6; //!< Encoding (1), hashes (1) and bits (4) before the data
+
+    /**
+     * \param position the bit to set
+     */
+    void SetBit(uint32_t position);
+
+    std::vector<uint64_t> m_words; //!< Bit array
+    uint32_t m_bits;               //!< Bits of the filter
+    uint32_t m_hashes;             //!< Positions set per id
+};
+
+/**
+ * \brief Bloom filter of counters, kept by a cache over its own contents.
+ *
+ * As in Summary Cache, each position holds an 8-bit counter so that evicted
+ * ids can be removed; the bit summary sent to the siblings is the set of
+ * non-zero counters. A counter reaching its maximum is never decremented
+ * again, which can only add false positives.
+ */
+class CountingBloomFilter
+{
+  public:
+    CountingBloomFilter();
+
+    /**
+     * \brief Size the filter and clear it.
+     * \param bits counters of the filter, also the bits of its summary
+     * \param hashes positions incremented per id
+     */
+    void Configure(uint32_t bits, uint32_t hashes);
+
+    /**
+     * \param id the object id, not already in the filter
+     */
+    void Insert(uint32_t id);
+
+    /**
+     * \param id the object id, previously inserted
+     */
+    void Remove(uint32_t id);
+
+    /**
+     * \return the ids in the filter
+     */
+    uint32_t GetItems() const;
+
+    /**
+     * \brief Build the bit summary of the filter.
+     * \param[out] summary the summary, replaced
+     */
+    void Export(BloomFilter& summary) const;
+
+  private:
+    static constexpr uint8_t MAX_COUNT = 255; //!< Saturation value of a counter
+
+    std::vector<uint8_t> m_counters; //!< Counter of every position
+    uint32_t m_hashes;               //!< Positions incremented per id
+    uint32_t m_items;                //!< Ids in the filter
+};
+
+} // namespace ns3
+
+#endif /* BLOOM_FILTER_H */
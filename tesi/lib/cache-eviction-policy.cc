@@ -0,0 +1,620 @@
+#include "cache-eviction-policy.h"
+
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+Ptr<CacheEvictionPolicy>
+CacheEvictionPolicy::CreatePolicy(PolicyType type, uint32_t capacity)
+{
+    switch (type)
+    {
+    case FIFO:
+        return Create<FifoCachePolicy>(capacity);
+    case LRU:
+        return Create<LruCachePolicy>(capacity);
+    case LFU:
+        return Create<LfuCachePolicy>(capacity);
+    case TWO_Q:
+        return Create<TwoQueueCachePolicy>(capacity);
+    case ARC:
+        return Create<ArcCachePolicy>(capacity);
+    case SIEVE:
+        return Create<SieveCachePolicy>(capacity);
+    case S3_FIFO:
+        return Create<S3FifoCachePolicy>(capacity);
+    case GDSF:
+        return Create<GdsfCachePolicy>(capacity);
+    }
+    NS_FATAL_ERROR("Unknown cache eviction policy " << type);
+    return nullptr;
+}
+
+CacheEvictionPolicy::CacheEvictionPolicy(uint32_t capacity)
+    : m_capacity(capacity),
+      m_victim(0),
+      m_evicting(false)
+{
+}
+
+CacheEvictionPolicy::~CacheEvictionPolicy()
+{
+}
+
+uint32_t
+CacheEvictionPolicy::GetCapacity() const
+{
+    return m_capacity;
+}
+
+bool
+CacheEvictionPolicy::IsFull() const
+{
+    return GetSize() >= m_capacity;
+}
+
+bool
+CacheEvictionPolicy::Push(uint32_t id, uint32_t* evicted)
+{
+    if (m_capacity == 0 || Contains(id))
+    {
+        return false;
+    }
+
+    bool hasEvicted = false;
+    while (IsFull())
+    {
+        uint32_t victim = SelectVictim(id);
+        Remove(victim);
+        if (evicted)
+        {
+            *evicted = victim;
+        }
+        hasEvicted = true;
+    }
+    Insert(id);
+    return hasEvicted;
+}
+
+void
+CacheEvictionPolicy::KeepVictim()
+{
+    m_evicting = false;
+}
+
+void
+CacheEvictionPolicy::SetObjectCost(uint32_t id, double cost, uint32_t size)
+{
+}
+
+uint32_t
+CacheEvictionPolicy::MarkVictim(uint32_t id)
+{
+    m_victim = id;
+    m_evicting = true;
+    return id;
+}
+
+bool
+CacheEvictionPolicy::TakeVictim(uint32_t id)
+{
+    bool evicted = m_evicting && id == m_victim;
+    m_evicting = false;
+    return evicted;
+}
+
+/* FIFO */
+
+FifoCachePolicy::FifoCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity)
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+FifoCachePolicy::GetName() const
+{
+    return "FIFO";
+}
+
+uint32_t
+FifoCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_queue.IsEmpty());
+    return m_queue.Front()->id;
+}
+
+void
+FifoCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    m_queue.Remove(&it->second);
+    m_index.erase(it);
+}
+
+void
+FifoCachePolicy::Insert(uint32_t id)
+{
+    CacheEntry& entry = m_index[id];
+    entry.id = id;
+    m_queue.PushBack(&entry);
+}
+
+/* LRU */
+
+LruCachePolicy::LruCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity)
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+LruCachePolicy::GetName() const
+{
+    return "LRU";
+}
+
+uint32_t
+LruCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_queue.IsEmpty());
+    return m_queue.Front()->id;
+}
+
+void
+LruCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    m_queue.Remove(&it->second);
+    m_index.erase(it);
+}
+
+void
+LruCachePolicy::Insert(uint32_t id)
+{
+    CacheEntry& entry = m_index[id];
+    entry.id = id;
+    m_queue.PushBack(&entry);
+}
+
+/* LFU */
+
+LfuCachePolicy::LfuCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_occupied()
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+LfuCachePolicy::GetName() const
+{
+    return "LFU";
+}
+
+uint32_t
+LfuCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_index.empty());
+    // the lowest set bit of the bitmap is the lowest non empty count
+    uint32_t w = 0;
+    while (m_occupied[w] == 0)
+    {
+        w++;
+    }
+    return m_buckets[w * 64 + __builtin_ctzll(m_occupied[w])].Front()->id;
+}
+
+void
+LfuCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    Unlink(&it->second);
+    m_index.erase(it);
+}
+
+void
+LfuCachePolicy::Insert(uint32_t id)
+{
+    Entry& entry = m_index[id];
+    entry.id = id;
+    entry.freq = 1;
+    Link(&entry);
+}
+
+/* 2Q */
+
+TwoQueueCachePolicy::TwoQueueCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_out(std::max<uint32_t>(1, capacity / 2)),
+      m_inCapacity(std::max<uint32_t>(1, capacity / 4))
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+TwoQueueCachePolicy::GetName() const
+{
+    return "2Q";
+}
+
+uint32_t
+TwoQueueCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_index.empty());
+    if (m_main.IsEmpty() || (!m_in.IsEmpty() && m_in.GetSize() >= m_inCapacity))
+    {
+        return MarkVictim(m_in.Front()->id);
+    }
+    return MarkVictim(m_main.Front()->id);
+}
+
+void
+TwoQueueCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    bool evicted = TakeVictim(id);
+    if (it->second.inMain)
+    {
+        m_main.Remove(&it->second);
+    }
+    else
+    {
+        m_in.Remove(&it->second);
+        if (evicted)
+        {
+            m_out.Insert(id);
+        }
+    }
+    m_index.erase(it);
+}
+
+void
+TwoQueueCachePolicy::Insert(uint32_t id)
+{
+    Entry& entry = m_index[id];
+    entry.id = id;
+    entry.inMain = m_out.Erase(id);
+    if (entry.inMain)
+    {
+        m_main.PushBack(&entry);
+    }
+    else
+    {
+        m_in.PushBack(&entry);
+    }
+}
+
+/* ARC */
+
+ArcCachePolicy::ArcCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_recentGhost(capacity),
+      m_frequentGhost(2 * capacity),
+      m_target(0)
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+ArcCachePolicy::GetName() const
+{
+    return "ARC";
+}
+
+uint32_t
+ArcCachePolicy::AdaptedTarget(uint32_t incoming) const
+{
+    uint32_t b1 = m_recentGhost.GetSize();
+    uint32_t b2 = m_frequentGhost.GetSize();
+    if (m_recentGhost.Contains(incoming))
+    {
+        uint32_t delta = std::max<uint32_t>(1, b2 / b1);
+        return std::min(GetCapacity(), m_target + delta);
+    }
+    if (m_frequentGhost.Contains(incoming))
+    {
+        uint32_t delta = std::max<uint32_t>(1, b1 / b2);
+        return m_target > delta ? m_target - delta : 0;
+    }
+    return m_target;
+}
+
+uint32_t
+ArcCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_index.empty());
+    uint32_t target = AdaptedTarget(incoming);
+    uint32_t t1 = m_recent.GetSize();
+    bool fromRecent =
+        t1 > 0 && (t1 > target || (t1 == target && m_frequentGhost.Contains(incoming)) ||
+                   m_frequent.IsEmpty());
+    return MarkVictim(fromRecent ? m_recent.Front()->id : m_frequent.Front()->id);
+}
+
+void
+ArcCachePolicy::TrimGhosts()
+{
+    while (m_recent.GetSize() + m_recentGhost.GetSize() > GetCapacity() && m_recentGhost.GetSize() > 0)
+    {
+        m_recentGhost.EvictFront();
+    }
+    // with |T1| + |B1| <= c and |T2| <= c, trimming B2 is enough
+    while (m_index.size() + m_recentGhost.GetSize() + m_frequentGhost.GetSize() > 2 * GetCapacity() &&
+           m_frequentGhost.GetSize() > 0)
+    {
+        m_frequentGhost.EvictFront();
+    }
+}
+
+void
+ArcCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    bool evicted = TakeVictim(id);
+    if (it->second.frequent)
+    {
+        m_frequent.Remove(&it->second);
+        if (evicted)
+        {
+            m_frequentGhost.Insert(id);
+        }
+    }
+    else
+    {
+        m_recent.Remove(&it->second);
+        if (evicted)
+        {
+            m_recentGhost.Insert(id);
+        }
+    }
+    m_index.erase(it);
+}
+
+void
+ArcCachePolicy::Insert(uint32_t id)
+{
+    m_target = AdaptedTarget(id);
+    Entry& entry = m_index[id];
+    entry.id = id;
+    entry.frequent = m_recentGhost.Erase(id) || m_frequentGhost.Erase(id);
+    if (entry.frequent)
+    {
+        m_frequent.PushBack(&entry);
+    }
+    else
+    {
+        m_recent.PushBack(&entry);
+    }
+    TrimGhosts();
+}
+
+/* SIEVE */
+
+SieveCachePolicy::SieveCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_hand(nullptr)
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+SieveCachePolicy::GetName() const
+{
+    return "SIEVE";
+}
+
+uint32_t
+SieveCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_queue.IsEmpty());
+    Entry* entry = m_hand ? m_hand : static_cast<Entry*>(m_queue.Front());
+    while (entry->visited)
+    {
+        entry->visited = false;
+        CacheEntry* next = m_queue.Next(entry);
+        entry = static_cast<Entry*>(next ? next : m_queue.Front());
+    }
+    m_hand = entry;
+    return entry->id;
+}
+
+void
+SieveCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    Entry* entry = &it->second;
+    if (m_hand == entry)
+    {
+        m_hand = static_cast<Entry*>(m_queue.Next(entry));
+    }
+    m_queue.Remove(entry);
+    m_index.erase(it);
+}
+
+void
+SieveCachePolicy::Insert(uint32_t id)
+{
+    Entry& entry = m_index[id];
+    entry.id = id;
+    entry.visited = false;
+    m_queue.PushBack(&entry);
+}
+
+/* S3-FIFO */
+
+S3FifoCachePolicy::S3FifoCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_ghost(std::max<uint32_t>(1, capacity - capacity / 10)),
+      m_smallCapacity(std::max<uint32_t>(1, capacity / 10))
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+S3FifoCachePolicy::GetName() const
+{
+    return "S3-FIFO";
+}
+
+uint32_t
+S3FifoCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_index.empty());
+    // Promotions and reinsertions move entries between the queues without
+    // changing the resident set; each pass consumes a frequency bit or a
+    // promotion, so the loop ends.
+    while (true)
+    {
+        if (!m_small.IsEmpty() && (m_small.GetSize() >= m_smallCapacity || m_main.IsEmpty()))
+        {
+            Entry* entry = static_cast<Entry*>(m_small.Front());
+            if (entry->freq == 0)
+            {
+                return MarkVictim(entry->id);
+            }
+            m_small.Remove(entry);
+            entry->freq = 0;
+            entry->inMain = true;
+            m_main.PushBack(entry);
+        }
+        else
+        {
+            Entry* entry = static_cast<Entry*>(m_main.Front());
+            if (entry->freq == 0)
+            {
+                return MarkVictim(entry->id);
+            }
+            m_main.Remove(entry);
+            entry->freq--;
+            m_main.PushBack(entry);
+        }
+    }
+}
+
+void
+S3FifoCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    bool evicted = TakeVictim(id);
+    if (it->second.inMain)
+    {
+        m_main.Remove(&it->second);
+    }
+    else
+    {
+        m_small.Remove(&it->second);
+        if (evicted)
+        {
+            m_ghost.Insert(id);
+        }
+    }
+    m_index.erase(it);
+}
+
+void
+S3FifoCachePolicy::Insert(uint32_t id)
+{
+    Entry& entry = m_index[id];
+    entry.id = id;
+    entry.freq = 0;
+    entry.inMain = m_ghost.Erase(id);
+    if (entry.inMain)
+    {
+        m_main.PushBack(&entry);
+    }
+    else
+    {
+        m_small.PushBack(&entry);
+    }
+}
+
+/* GDSF */
+
+GdsfCachePolicy::GdsfCachePolicy(uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_inflation(0),
+      m_stamp(0)
+{
+    m_index.reserve(capacity);
+}
+
+std::string
+GdsfCachePolicy::GetName() const
+{
+    return "GDSF";
+}
+
+void
+GdsfCachePolicy::Enqueue(uint32_t id, Entry& entry)
+{
+    double priority = m_inflation + entry.freq * entry.cost / entry.size;
+    entry.key = Key(priority, ++m_stamp, id);
+    m_queue.insert(entry.key);
+}
+
+uint32_t
+GdsfCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(!m_queue.empty());
+    return MarkVictim(std::get<2>(*m_queue.begin()));
+}
+
+void
+GdsfCachePolicy::Remove(uint32_t id)
+{
+    auto it = m_index.find(id);
+    NS_ASSERT(it != m_index.end());
+    // L only rises on evictions, not when the lowest entry is invalidated or expires
+    if (TakeVictim(id))
+    {
+        m_inflation = std::get<0>(it->second.key);
+    }
+    m_queue.erase(it->second.key);
+    m_index.erase(it);
+}
+
+void
+GdsfCachePolicy::Insert(uint32_t id)
+{
+    Entry& entry = m_index[id];
+    entry.freq = 1;
+    entry.cost = 1;
+    entry.size = 1;
+    auto pending = m_pending.find(id);
+    if (pending != m_pending.end())
+    {
+        entry.cost = pending->second.cost;
+        entry.size = std::max<uint32_t>(1, pending->second.size);
+        m_pending.erase(pending);
+    }
+    Enqueue(id, entry);
+}
+
+void
+GdsfCachePolicy::SetObjectCost(uint32_t id, double cost, uint32_t size)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        m_pending[id] = {cost, size};
+        return;
+    }
+    m_queue.erase(it->second.key);
+    it->second.cost = cost;
+    it->second.size = std::max<uint32_t>(1, size);
+    Enqueue(id, it->second);
+}
+
+} // namespace ns3
@@ -0,0 +1,699 @@
+#ifndef CACHE_EVICTION_POLICY_H
+#define CACHE_EVICTION_POLICY_H
+
+#include "cache-store.h"
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <algorithm>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * \brief Replacement policy of a bounded cache of object ids.
+ *
+ * A policy owns the set of resident ids together with the metadata it needs
+ * to pick a victim. Eviction is split in two steps, SelectVictim() and
+ * Remove(), so that callers can inspect the victim before it is dropped.
+ * Every operation is O(1) amortized, except for GDSF which keeps a priority
+ * order and is O(log n).
+ */
+class CacheEvictionPolicy : public SimpleRefCount<CacheEvictionPolicy>
+{
+  public:
+    /// Replacement policies shipped with the cache server
+    enum PolicyType
+    {
+        FIFO,
+        LRU,
+        LFU,
+        TWO_Q,
+        ARC,
+        SIEVE,
+        S3_FIFO,
+        GDSF,
+    };
+
+    /**
+     * \brief Create a policy.
+     * \param type the replacement policy
+     * \param capacity maximum number of resident ids
+     * \return the new policy
+     */
+    static Ptr<CacheEvictionPolicy> CreatePolicy(PolicyType type, uint32_t capacity);
+
+    /**
+     * \param capacity maximum number of resident ids
+     */
+    explicit CacheEvictionPolicy(uint32_t capacity);
+    virtual ~CacheEvictionPolicy();
+
+    /**
+     * \return the maximum number of resident ids
+     */
+    uint32_t GetCapacity() const;
+
+    /**
+     * \return true if no more ids fit without an eviction
+     */
+    bool IsFull() const;
+
+    /**
+     * \brief Store an id, evicting as many victims as needed.
+     * \param id the object id, ignored if already resident
+     * \param evicted if not null, receives the id of the last evicted entry
+     * \return true if an entry was evicted
+     */
+    bool Push(uint32_t id, uint32_t* evicted = nullptr);
+
+    /**
+     * \return the name of the policy
+     */
+    virtual std::string GetName() const = 0;
+
+    /**
+     * \return the number of resident ids
+     */
+    virtual uint32_t GetSize() const = 0;
+
+    /**
+     * \brief Check residency without touching the replacement state.
+     * \param id the object id
+     * \return true if the id is resident
+     */
+    virtual bool Contains(uint32_t id) const = 0;
+
+    /**
+     * \brief Check residency and record an access on a hit.
+     * \param id the object id
+     * \return true if the id is resident
+     */
+    virtual bool Lookup(uint32_t id) = 0;
+
+    /**
+     * \brief Pick the entry to evict to make room for a new id.
+     *
+     * The policy may reorganize its queues, but the set of resident ids is
+     * not changed: the victim stays resident until Remove() is called.
+     *
+     * \param incoming the id that is going to be inserted
+     * \return the id of the victim, the policy must not be empty
+     */
+    virtual uint32_t SelectVictim(uint32_t incoming) = 0;
+
+    /**
+     * \brief Drop a resident id.
+     *
+     * Only the Remove() of the id the last SelectVictim() returned is an
+     * eviction, which ghost-aware policies remember; ids invalidated or
+     * expired were not pushed out by the policy.
+     *
+     * \param id a resident object id
+     */
+    virtual void Remove(uint32_t id) = 0;
+
+    /**
+     * \brief Keep the victim of the last SelectVictim() resident, e.g. when
+     * the incoming id is not admitted: a later Remove() of it is no eviction.
+     */
+    void KeepVictim();
+
+    /**
+     * \brief Store an id that is not resident while the policy is not full.
+     * \param id the object id
+     */
+    virtual void Insert(uint32_t id) = 0;
+
+    /**
+     * \brief Record what it costs to fetch an id again.
+     *
+     * Cost-aware policies use it for the next Insert() of the id, or to
+     * reprioritize it if it is resident; the others ignore it.
+     *
+     * \param id the object id
+     * \param cost the fetch cost, e.g. the measured fetch latency
+     * \param size the object size in bytes
+     */
+    virtual void SetObjectCost(uint32_t id, double cost, uint32_t size);
+
+  protected:
+    /**
+     * \brief Record the victim SelectVictim() returns.
+     * \param id the victim
+     * \return id
+     */
+    uint32_t MarkVictim(uint32_t id);
+
+    /**
+     * \brief Tell whether the Remove() of an id evicts it, forgetting the victim.
+     * \param id the removed id
+     * \return true if id is the victim of the last SelectVictim()
+     */
+    bool TakeVictim(uint32_t id);
+
+  private:
+    uint32_t m_capacity; //!< Maximum number of resident ids
+    uint32_t m_victim;   //!< Id returned by the last SelectVictim
+    bool m_evicting;     //!< Whether m_victim is about to be removed
+};
+
+/**
+ * \brief First in, first out: hits do not change the eviction order.
+ */
+class FifoCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit FifoCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    std::unordered_map<uint32_t, CacheEntry> m_index; //!< id -> node
+    CacheEntryList m_queue;                           //!< Nodes in insertion order
+};
+
+/**
+ * \brief Least recently used.
+ */
+class LruCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit LruCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    std::unordered_map<uint32_t, CacheEntry> m_index; //!< id -> node
+    CacheEntryList m_queue;                           //!< Nodes from least to most recently used
+};
+
+/**
+ * \brief Least frequently used, ties broken by recency.
+ *
+ * Entries are chained in one list per access count, as in the constant time
+ * LFU of Shah, Mitra and Matani, and a bitmap of the non empty lists gives
+ * the lowest count after any removal, evictions or not. Counts saturate at
+ * MAX_COUNT, like the 8-bit counts of the flat LFU, after which further hits
+ * only refresh the recency of the entry.
+ */
+class LfuCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    static constexpr uint32_t MAX_COUNT = 255; //!< Highest access count of an entry
+
+    explicit LfuCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /// Resident entry with its access count
+    struct Entry : CacheEntry
+    {
+        uint32_t freq; //!< Number of accesses
+    };
+
+    /// Words of the bitmap of the non empty buckets
+    static constexpr uint32_t BITMAP_WORDS = (MAX_COUNT + 64) / 64;
+
+    /**
+     * \brief Link an entry as the newest one of the bucket of its access count.
+     * \param entry a resident entry
+     */
+    void Link(Entry* entry);
+
+    /**
+     * \brief Unlink an entry from the bucket of its access count.
+     * \param entry a resident entry
+     */
+    void Unlink(Entry* entry);
+
+    std::unordered_map<uint32_t, Entry> m_index;   //!< id -> node
+    CacheEntryList m_buckets[MAX_COUNT + 1];       //!< access count -> entries, 0 unused
+    uint64_t m_occupied[BITMAP_WORDS];             //!< Bit f set if bucket f is not empty
+};
+
+/**
+ * \brief Full 2Q of Johnson and Shasha.
+ *
+ * New ids enter the FIFO A1in, ids evicted from A1in are remembered in the
+ * ghost queue A1out, and an id that comes back while in A1out is promoted to
+ * the LRU queue Am. Ids invalidated or expired leave no ghost.
+ */
+class TwoQueueCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit TwoQueueCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /// Resident entry tagged with its queue
+    struct Entry : CacheEntry
+    {
+        bool inMain; //!< True if the entry is in Am, false if in A1in
+    };
+
+    std::unordered_map<uint32_t, Entry> m_index; //!< id -> node
+    CacheEntryList m_in;                         //!< A1in, FIFO
+    CacheEntryList m_main;                       //!< Am, LRU
+    CacheStore m_out;                            //!< A1out, ghost ids
+    uint32_t m_inCapacity;                       //!< Kin, target size of A1in
+};
+
+/**
+ * \brief Adaptive Replacement Cache of Megiddo and Modha.
+ *
+ * T1 holds ids seen once and T2 ids seen at least twice; the ghost lists B1
+ * and B2 remember their recent victims and steer the target size of T1.
+ * Only evictions, a Remove of the id returned by SelectVictim, leave a ghost:
+ * ids invalidated or expired were not pushed out by the policy. As in the
+ * paper, |T1| + |B1| stays within the capacity c and the four lists within 2c.
+ */
+class ArcCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit ArcCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /// Resident entry tagged with its list
+    struct Entry : CacheEntry
+    {
+        bool frequent; //!< True if the entry is in T2, false if in T1
+    };
+
+    /**
+     * \param incoming the id about to be inserted
+     * \return the target size of T1 after a possible ghost hit of incoming
+     */
+    uint32_t AdaptedTarget(uint32_t incoming) const;
+
+    /**
+     * \brief Drop the oldest ghosts beyond |T1| + |B1| = c and a total of 2c.
+     */
+    void TrimGhosts();
+
+    std::unordered_map<uint32_t, Entry> m_index; //!< id -> node
+    CacheEntryList m_recent;                     //!< T1, LRU
+    CacheEntryList m_frequent;                   //!< T2, LRU
+    CacheStore m_recentGhost;                    //!< B1
+    CacheStore m_frequentGhost;                  //!< B2
+    uint32_t m_target;                           //!< p, target size of T1
+};
+
+/**
+ * \brief SIEVE of Zhang et al.
+ *
+ * A FIFO queue with one visited bit per entry and a hand that sweeps from the
+ * oldest entry towards the newest one, clearing the bits it crosses.
+ */
+class SieveCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit SieveCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /// Resident entry with its visited bit
+    struct Entry : CacheEntry
+    {
+        bool visited; //!< Accessed since the hand last crossed it
+    };
+
+    std::unordered_map<uint32_t, Entry> m_index; //!< id -> node
+    CacheEntryList m_queue;                      //!< Nodes in insertion order
+    Entry* m_hand;                               //!< Next candidate, nullptr for the oldest
+};
+
+/**
+ * \brief S3-FIFO of Yang et al.
+ *
+ * A small FIFO filters one-hit wonders, entries accessed while in it move to
+ * the main FIFO, which reinserts entries with a non zero (2-bit) frequency.
+ * A ghost FIFO remembers ids evicted from the small queue, not the ones
+ * invalidated or expired there.
+ */
+class S3FifoCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit S3FifoCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /// Resident entry with its queue and saturating frequency
+    struct Entry : CacheEntry
+    {
+        uint8_t freq; //!< Accesses since insertion, saturated at 3
+        bool inMain;  //!< True if the entry is in the main queue
+    };
+
+    std::unordered_map<uint32_t, Entry> m_index; //!< id -> node
+    CacheEntryList m_small;                      //!< Small FIFO
+    CacheEntryList m_main;                       //!< Main FIFO
+    CacheStore m_ghost;                          //!< Ghost ids evicted from the small FIFO
+    uint32_t m_smallCapacity;                    //!< Target size of the small FIFO
+};
+
+/**
+ * \brief GreedyDual-Size-Frequency of Cherkasova.
+ *
+ * Every entry has priority L + frequency * cost / size, where L is the
+ * priority of the last evicted entry, so entries that are cheap to fetch again or
+ * large age out first. Entries are kept in a priority ordered tree, making
+ * insertion and eviction O(log n).
+ */
+class GdsfCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    explicit GdsfCachePolicy(uint32_t capacity);
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+    void SetObjectCost(uint32_t id, double cost, uint32_t size) override;
+
+  private:
+    /// Position in the priority order: priority, insertion stamp for ties, id
+    typedef std::tuple<double, uint64_t, uint32_t> Key;
+
+    /// Resident entry
+    struct Entry
+    {
+        uint32_t freq; //!< Number of accesses
+        double cost;   //!< Fetch cost
+        uint32_t size; //!< Size in bytes, at least 1
+        Key key;       //!< Position in m_queue
+    };
+
+    /// Fetch cost and size of an object
+    struct Cost
+    {
+        double cost;   //!< Fetch cost
+        uint32_t size; //!< Size in bytes
+    };
+
+    /**
+     * \brief Compute the priority of an entry and (re)queue it.
+     * \param id the object id
+     * \param entry the resident entry
+     */
+    void Enqueue(uint32_t id, Entry& entry);
+
+    std::unordered_map<uint32_t, Entry> m_index;  //!< id -> entry
+    std::unordered_map<uint32_t, Cost> m_pending; //!< Costs of ids not yet inserted
+    std::set<Key> m_queue;                        //!< Entries by increasing priority
+    double m_inflation;                           //!< L, priority of the last evicted entry
+    uint64_t m_stamp;                             //!< Stamp of the last (re)queued entry
+};
+
+/*
+ * The lookup path of the final policies is defined here so that callers
+ * holding the concrete type (see BasicUdpCacheServer) get it inlined.
+ */
+
+inline uint32_t
+FifoCachePolicy::GetSize() const
+{
+    return m_queue.GetSize();
+}
+
+inline bool
+FifoCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+FifoCachePolicy::Lookup(uint32_t id)
+{
+    return Contains(id);
+}
+
+inline uint32_t
+LruCachePolicy::GetSize() const
+{
+    return m_queue.GetSize();
+}
+
+inline bool
+LruCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+LruCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    m_queue.Remove(&it->second);
+    m_queue.PushBack(&it->second);
+    return true;
+}
+
+inline uint32_t
+LfuCachePolicy::GetSize() const
+{
+    return m_index.size();
+}
+
+inline bool
+LfuCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline void
+LfuCachePolicy::Link(Entry* entry)
+{
+    m_buckets[entry->freq].PushBack(entry);
+    m_occupied[entry->freq / 64] |= uint64_t(1) << (entry->freq % 64);
+}
+
+inline void
+LfuCachePolicy::Unlink(Entry* entry)
+{
+    CacheEntryList& bucket = m_buckets[entry->freq];
+    bucket.Remove(entry);
+    if (bucket.IsEmpty())
+    {
+        m_occupied[entry->freq / 64] &= ~(uint64_t(1) << (entry->freq % 64));
+    }
+}
+
+inline bool
+LfuCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    Entry* entry = &it->second;
+    Unlink(entry);
+    entry->freq = std::min(entry->freq + 1, MAX_COUNT);
+    Link(entry);
+    return true;
+}
+
+inline uint32_t
+TwoQueueCachePolicy::GetSize() const
+{
+    return m_index.size();
+}
+
+inline bool
+TwoQueueCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+TwoQueueCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    if (it->second.inMain)
+    {
+        m_main.Remove(&it->second);
+        m_main.PushBack(&it->second);
+    }
+    return true;
+}
+
+inline uint32_t
+ArcCachePolicy::GetSize() const
+{
+    return m_index.size();
+}
+
+inline bool
+ArcCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+ArcCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    Entry* entry = &it->second;
+    if (entry->frequent)
+    {
+        m_frequent.Remove(entry);
+    }
+    else
+    {
+        m_recent.Remove(entry);
+        entry->frequent = true;
+    }
+    m_frequent.PushBack(entry);
+    return true;
+}
+
+inline uint32_t
+SieveCachePolicy::GetSize() const
+{
+    return m_queue.GetSize();
+}
+
+inline bool
+SieveCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+SieveCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    it->second.visited = true;
+    return true;
+}
+
+inline uint32_t
+S3FifoCachePolicy::GetSize() const
+{
+    return m_index.size();
+}
+
+inline bool
+S3FifoCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+S3FifoCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    if (it->second.freq < 3)
+    {
+        it->second.freq++;
+    }
+    return true;
+}
+
+inline uint32_t
+GdsfCachePolicy::GetSize() const
+{
+    return m_index.size();
+}
+
+inline bool
+GdsfCachePolicy::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+inline bool
+GdsfCachePolicy::Lookup(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    m_queue.erase(it->second.key);
+    it->second.freq++;
+    Enqueue(id, it->second);
+    return true;
+}
+
+} // namespace ns3
+
+#endif /* CACHE_EVICTION_POLICY_H */
@@ -0,0 +1,450 @@
+#include "cache-protocol-header.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("CacheProtocolHeader");
+
+NS_OBJECT_ENSURE_REGISTERED(CacheProtocolHeader);
+NS_OBJECT_ENSURE_REGISTERED(CacheSegmentHeader);
+NS_OBJECT_ENSURE_REGISTERED(CacheTtlHeader);
+NS_OBJECT_ENSURE_REGISTERED(CacheVersionHeader);
+
+TypeId
+CacheProtocolHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CacheProtocolHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<CacheProtocolHeader>();
+    return tid;
+}
+
+CacheProtocolHeader::CacheProtocolHeader()
+    : m_type(REQUEST),
+      m_role(CLIENT),
+      m_flags(0),
+      m_seq(0),
+      m_id(0)
+{
+}
+
+bool
+CacheProtocolHeader::IsBinary(Ptr<const Packet> packet)
+{
+    uint8_t first = 0;
+    return packet->CopyData(&first, 1) == 1 && first != '{';
+}
+
+Ptr<Packet>
+CacheProtocolHeader::CreateTextPacket(const char* sender, const char* type, uint32_t id)
+{
+    char message[96];
+    int length = std::snprintf(message,
+                               sizeof(message),
+                               "{ \"sender\": \"%s\", \"type\": \"%s\", \"id\": %u }",
+                               sender,
+                               type,
+                               id);
+    NS_ASSERT(length > 0 && length < int(sizeof(message)));
+    return Create<Packet>(reinterpret_cast<const uint8_t*>(message), length + 1);
+}
+
+void
+CacheProtocolHeader::ReadTextIds(Ptr<const Packet> packet,
+                                 std::vector<uint8_t>& buffer,
+                                 std::vector<uint32_t>& ids)
+{
+    ids.clear();
+    buffer.resize(packet->GetSize());
+    packet->CopyData(buffer.data(), buffer.size());
+    ScanTextIds(buffer.data(), buffer.size(), &ids);
+}
+
+uint32_t
+CacheProtocolHeader::ReadTextId(Ptr<const Packet> packet, std::vector<uint8_t>& buffer)
+{
+    buffer.resize(packet->GetSize());
+    packet->CopyData(buffer.data(), buffer.size());
+    return ScanTextIds(buffer.data(), buffer.size(), nullptr);
+}
+
+bool
+CacheProtocolHeader::IsTextBusy(Ptr<const Packet> packet, std::vector<uint8_t>& buffer)
+{
+    static const char busy[] = "\"type\": \"busy\"";
+    buffer.resize(packet->GetSize());
+    packet->CopyData(buffer.data(), buffer.size());
+    return std::search(buffer.begin(), buffer.end(), busy, busy + sizeof(busy) - 1) != buffer.end();
+}
+
+uint32_t
+CacheProtocolHeader::ScanTextIds(const uint8_t* data, uint32_t size, std::vector<uint32_t>* ids)
+{
+    auto isWord = [](uint8_t c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               c == '_';
+    };
+
+    uint32_t first = 0;
+    bool found = false;
+    uint32_t i = 0;
+    while (i < size)
+    {
+        if (!isWord(data[i]))
+        {
+            i++;
+            continue;
+        }
+        // a word: an id if it is made of 1 to 10 digits only and fits 32 bits
+        uint32_t start = i;
+        uint64_t value = 0;
+        bool digits = true;
+        for (; i < size && isWord(data[i]); i++)
+        {
+            digits = digits && data[i] >= '0' && data[i] <= '9';
+            if (digits && i - start < 10)
+            {
+                value = value * 10 + (data[i] - '0');
+            }
+        }
+        if (!digits || i - start > 10 || value > UINT32_MAX)
+        {
+            continue;
+        }
+        if (!ids)
+        {
+            return static_cast<uint32_t>(value);
+        }
+        if (!found)
+        {
+            first = static_cast<uint32_t>(value);
+            found = true;
+        }
+        ids->push_back(static_cast<uint32_t>(value));
+    }
+    return first;
+}
+
+void
+CacheProtocolHeader::SetMessageType(MessageType type)
+{
+    m_type = type;
+}
+
+CacheProtocolHeader::MessageType
+CacheProtocolHeader::GetMessageType() const
+{
+    return static_cast<MessageType>(m_type);
+}
+
+void
+CacheProtocolHeader::SetRole(Role role)
+{
+    m_role = role;
+}
+
+CacheProtocolHeader::Role
+CacheProtocolHeader::GetRole() const
+{
+    return static_cast<Role>(m_role);
+}
+
+void
+CacheProtocolHeader::SetFlags(uint16_t flags)
+{
+    m_flags = flags;
+}
+
+uint16_t
+CacheProtocolHeader::GetFlags() const
+{
+    return m_flags;
+}
+
+void
+CacheProtocolHeader::SetSequence(uint32_t seq)
+{
+    m_seq = seq;
+}
+
+uint32_t
+CacheProtocolHeader::GetSequence() const
+{
+    return m_seq;
+}
+
+void
+CacheProtocolHeader::SetObjectId(uint64_t id)
+{
+    m_id = id;
+}
+
+uint64_t
+CacheProtocolHeader::GetObjectId() const
+{
+    return m_id;
+}
+
+TypeId
+CacheProtocolHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+CacheProtocolHeader::Print(std::ostream& os) const
+{
+    os << "type="
+       << (m_type == REQUEST      ? "request"
+           : m_type == RESPONSE   ? "response"
+           : m_type == INVALIDATE ? "invalidate"
+                                  : "summary")
+       << " role="
+       << (m_role == CLIENT ? "client" : m_role == CACHE ? "cache" : "server") << " flags=0x"
+       << std::hex << m_flags << std::dec << " seq=" << m_seq << " id=" << m_id;
+}
+
+uint32_t
+CacheProtocolHeader::GetSerializedSize() const
+{
+    return 16;
+}
+
+void
+CacheProtocolHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(m_type);
+    i.WriteU8(m_role);
+    i.WriteHtonU16(m_flags);
+    i.WriteHtonU32(m_seq);
+    i.WriteHtonU64(m_id);
+}
+
+uint32_t
+CacheProtocolHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_type = i.ReadU8();
+    m_role = i.ReadU8();
+    m_flags = i.ReadNtohU16();
+    m_seq = i.ReadNtohU32();
+    m_id = i.ReadNtohU64();
+    return GetSerializedSize();
+}
+
+TypeId
+CacheSegmentHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CacheSegmentHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<CacheSegmentHeader>();
+    return tid;
+}
+
+CacheSegmentHeader::CacheSegmentHeader()
+    : m_objectSize(0),
+      m_offset(0)
+{
+}
+
+void
+CacheSegmentHeader::SetObjectSize(uint32_t size)
+{
+    m_objectSize = size;
+}
+
+uint32_t
+CacheSegmentHeader::GetObjectSize() const
+{
+    return m_objectSize;
+}
+
+void
+CacheSegmentHeader::SetOffset(uint32_t offset)
+{
+    m_offset = offset;
+}
+
+uint32_t
+CacheSegmentHeader::GetOffset() const
+{
+    return m_offset;
+}
+
+TypeId
+CacheSegmentHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+CacheSegmentHeader::Print(std::ostream& os) const
+{
+    os << "size=" << m_objectSize << " offset=" << m_offset;
+}
+
+uint32_t
+CacheSegmentHeader::GetSerializedSize() const
+{
+    return 8;
+}
+
+void
+CacheSegmentHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU32(m_objectSize);
+    i.WriteHtonU32(m_offset);
+}
+
+uint32_t
+CacheSegmentHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_objectSize = i.ReadNtohU32();
+    m_offset = i.ReadNtohU32();
+    return GetSerializedSize();
+}
+
+TypeId
+CacheTtlHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CacheTtlHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<CacheTtlHeader>();
+    return tid;
+}
+
+CacheTtlHeader::CacheTtlHeader()
+    : m_ttl(0)
+{
+}
+
+void
+CacheTtlHeader::SetTtl(Time ttl)
+{
+    m_ttl = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(ttl.GetMilliSeconds(), 0), UINT32_MAX));
+}
+
+Time
+CacheTtlHeader::GetTtl() const
+{
+    return MilliSeconds(m_ttl);
+}
+
+TypeId
+CacheTtlHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+CacheTtlHeader::Print(std::ostream& os) const
+{
+    os << "ttl=" << m_ttl << "ms";
+}
+
+uint32_t
+CacheTtlHeader::GetSerializedSize() const
+{
+    return 4;
+}
+
+void
+CacheTtlHeader::Serialize(Buffer::Iterator start) const
+{
+    start.WriteHtonU32(m_ttl);
+}
+
+uint32_t
+CacheTtlHeader::Deserialize(Buffer::Iterator start)
+{
+    m_ttl = start.ReadNtohU32();
+    return GetSerializedSize();
+}
+
+TypeId
+CacheVersionHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CacheVersionHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<CacheVersionHeader>();
+    return tid;
+}
+
+CacheVersionHeader::CacheVersionHeader()
+    : m_version(0),
+      m_updated(0)
+{
+}
+
+void
+CacheVersionHeader::SetVersion(uint32_t version)
+{
+    m_version = version;
+}
+
+uint32_t
+CacheVersionHeader::GetVersion() const
+{
+    return m_version;
+}
+
+void
+CacheVersionHeader::SetUpdated(Time updated)
+{
+    m_updated = updated.GetTimeStep();
+}
+
+Time
+CacheVersionHeader::GetUpdated() const
+{
+    return TimeStep(m_updated);
+}
+
+TypeId
+CacheVersionHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+CacheVersionHeader::Print(std::ostream& os) const
+{
+    os << "version=" << m_version << " updated=" << GetUpdated().As(Time::S);
+}
+
+uint32_t
+CacheVersionHeader::GetSerializedSize() const
+{
+    return 12;
+}
+
+void
+CacheVersionHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU32(m_version);
+    i.WriteHtonU64(m_updated);
+}
+
+uint32_t
+CacheVersionHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_version = i.ReadNtohU32();
+    m_updated = i.ReadNtohU64();
+    return GetSerializedSize();
+}
+
+} // namespace ns3
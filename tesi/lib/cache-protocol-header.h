@@ -0,0 +1,339 @@
+#ifndef CACHE_PROTOCOL_HEADER_H
+#define CACHE_PROTOCOL_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Binary message of the client / cache / content server protocol.
+ *
+ * Fixed 16-byte layout, in network byte order:
+ * type (1), role (1), flags (2), sequence number (4), object id (8).
+ * A batched request or response is a sequence of headers in one datagram,
+ * each followed by the optional headers its flags announce.
+ *
+ * The original text format, a JSON-like string whose first byte is '{', is
+ * kept as a compatibility mode; since no message type starts with that
+ * byte, receivers tell the two formats apart from the first byte alone.
+ */
+class CacheProtocolHeader : public Header
+{
+  public:
+    /// Encoding of the messages sent by an application
+    enum Format
+    {
+        TEXT,
+        BINARY,
+    };
+
+    /// Message types
+    enum MessageType : uint8_t
+    {
+        REQUEST = 1,
+        RESPONSE = 2,
+        INVALIDATE = 3, //!< Object changed at the origin, followed by a CacheVersionHeader
+        SUMMARY = 4,    //!< Contents of a sibling cache, followed by a serialized BloomFilter
+    };
+
+    /// Role of the sender
+    enum Role : uint8_t
+    {
+        CLIENT = 1,
+        CACHE = 2,
+        SERVER = 3,
+    };
+
+    /// Flag bits
+    enum Flags : uint16_t
+    {
+        RETRANSMISSION = 0x0001, //!< Request sent again after a timeout
+        PREFETCH = 0x0002,       //!< Request issued by the prefetcher, not by a client miss
+        SEGMENT = 0x0004,        //!< Response followed by a CacheSegmentHeader and object bytes
+        TTL = 0x0008,            //!< Response followed by a CacheTtlHeader, before any CacheSegmentHeader
+        REFRESH = 0x0010,        //!< Request revalidating an expired cached object
+        VERSION = 0x0020,        //!< Response followed by a CacheVersionHeader, after any CacheTtlHeader
+        UPDATE = 0x0040,         //!< Response pushed by the origin after the object changed
+        CACHED = 0x0080,         //!< Response served from the cache of a cache, not relayed from upstream
+        SIBLING = 0x0100,        //!< Request of a sibling cache, answered from the cache only
+        MISS = 0x0200,           //!< Response of a sibling cache that does not hold the object
+        BUSY = 0x0400,           //!< Response of an overloaded content server that shed the request
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    CacheProtocolHeader();
+
+    /**
+     * \param packet a received datagram
+     * \return true if the datagram is made of binary headers, false if it is text
+     */
+    static bool IsBinary(Ptr<const Packet> packet);
+
+    /**
+     * \brief Build a single-id text message.
+     *
+     * The message is formatted on the stack and copied once into the packet.
+     *
+     * \param sender the sender field, e.g. "cache"
+     * \param type the type field, "request", "response" or "busy"
+     * \param id the object id
+     * \return the packet, null terminator included
+     */
+    static Ptr<Packet> CreateTextPacket(const char* sender, const char* type, uint32_t id);
+
+    /**
+     * \brief Extract the ids of a text message.
+     *
+     * Ids are the words made of 1 to 10 digits whose value fits 32 bits, as
+     * matched by the former \b\d{1,6}\b regular expression widened to the
+     * whole id space, scanned in place without building a string or a regex.
+     *
+     * \param packet a text datagram
+     * \param buffer scratch buffer the payload is copied to, reused across calls
+     * \param[out] ids the ids, replaced
+     */
+    static void ReadTextIds(Ptr<const Packet> packet,
+                            std::vector<uint8_t>& buffer,
+                            std::vector<uint32_t>& ids);
+
+    /**
+     * \brief Extract the first id of a text message.
+     * \param packet a text datagram
+     * \param buffer scratch buffer the payload is copied to, reused across calls
+     * \return the first id, 0 if there is none
+     */
+    static uint32_t ReadTextId(Ptr<const Packet> packet, std::vector<uint8_t>& buffer);
+
+    /**
+     * \brief Tell a text BUSY response, sent by an overloaded content server.
+     * \param packet a text datagram
+     * \param buffer scratch buffer the payload is copied to, reused across calls
+     * \return true if the type field of the message is "busy"
+     */
+    static bool IsTextBusy(Ptr<const Packet> packet, std::vector<uint8_t>& buffer);
+
+    /**
+     * \param type the message type
+     */
+    void SetMessageType(MessageType type);
+
+    /**
+     * \return the message type
+     */
+    MessageType GetMessageType() const;
+
+    /**
+     * \param role the role of the sender
+     */
+    void SetRole(Role role);
+
+    /**
+     * \return the role of the sender
+     */
+    Role GetRole() const;
+
+    /**
+     * \param flags the flag bits
+     */
+    void SetFlags(uint16_t flags);
+
+    /**
+     * \return the flag bits
+     */
+    uint16_t GetFlags() const;
+
+    /**
+     * \param seq the sequence number, echoed in the response
+     */
+    void SetSequence(uint32_t seq);
+
+    /**
+     * \return the sequence number
+     */
+    uint32_t GetSequence() const;
+
+    /**
+     * \param id the object id
+     */
+    void SetObjectId(uint64_t id);
+
+    /**
+     * \return the object id
+     */
+    uint64_t GetObjectId() const;
+
+    TypeId GetInstanceTypeId() const override;
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+  private:
+    /**
+     * \brief Scan the ids of a text payload.
+     * \param data the payload
+     * \param size the payload size
+     * \param[out] ids the ids are appended here, or null to stop at the first one
+     * \return the first id, 0 if there is none
+     */
+    static uint32_t ScanTextIds(const uint8_t* data, uint32_t size, std::vector<uint32_t>* ids);
+
+    uint8_t m_type;   //!< Message type
+    uint8_t m_role;   //!< Role of the sender
+    uint16_t m_flags; //!< Flag bits
+    uint32_t m_seq;   //!< Sequence number
+    uint64_t m_id;    //!< Object id
+};
+
+/**
+ * \brief Position of a datagram within a segmented object.
+ *
+ * Follows a CacheProtocolHeader carrying the SEGMENT flag; the rest of the
+ * datagram is object bytes. Fixed 8-byte layout, in network byte order:
+ * object size (4), offset of the first byte of the datagram (4).
+ */
+class CacheSegmentHeader : public Header
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    CacheSegmentHeader();
+
+    /**
+     * \param size the size of the whole object, in bytes
+     */
+    void SetObjectSize(uint32_t size);
+
+    /**
+     * \return the size of the whole object, in bytes
+     */
+    uint32_t GetObjectSize() const;
+
+    /**
+     * \param offset the offset of the segment within the object
+     */
+    void SetOffset(uint32_t offset);
+
+    /**
+     * \return the offset of the segment within the object
+     */
+    uint32_t GetOffset() const;
+
+    TypeId GetInstanceTypeId() const override;
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+  private:
+    uint32_t m_objectSize; //!< Size of the whole object
+    uint32_t m_offset;     //!< Offset of the segment
+};
+
+/**
+ * \brief Time to live of the object carried by a response.
+ *
+ * Follows a CacheProtocolHeader carrying the TTL flag. Fixed 4-byte layout,
+ * in network byte order: TTL in milliseconds (4), 0 leaving the choice to
+ * the cache.
+ */
+class CacheTtlHeader : public Header
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    CacheTtlHeader();
+
+    /**
+     * \param ttl the time to live, rounded down to milliseconds
+     */
+    void SetTtl(Time ttl);
+
+    /**
+     * \return the time to live
+     */
+    Time GetTtl() const;
+
+    TypeId GetInstanceTypeId() const override;
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+  private:
+    uint32_t m_ttl; //!< Time to live in milliseconds
+};
+
+/**
+ * \brief Version of an object at the origin.
+ *
+ * Follows a CacheProtocolHeader of type INVALIDATE, or carrying the VERSION
+ * flag. Fixed 12-byte layout, in network byte order: version (4), time of
+ * the update that produced the version, in simulator time steps (8), as
+ * SeqTsHeader does for its timestamp.
+ */
+class CacheVersionHeader : public Header
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    CacheVersionHeader();
+
+    /**
+     * \param version the object version, 0 for the one before any update
+     */
+    void SetVersion(uint32_t version);
+
+    /**
+     * \return the object version
+     */
+    uint32_t GetVersion() const;
+
+    /**
+     * \param updated the time of the update that produced the version
+     */
+    void SetUpdated(Time updated);
+
+    /**
+     * \return the time of the update that produced the version
+     */
+    Time GetUpdated() const;
+
+    TypeId GetInstanceTypeId() const override;
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+  private:
+    uint32_t m_version; //!< Object version
+    uint64_t m_updated; //!< Time of the update, in time steps
+};
+
+} // namespace ns3
+
+#endif /* CACHE_PROTOCOL_HEADER_H */
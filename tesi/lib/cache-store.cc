@@ -0,0 +1,101 @@
+#include "cache-store.h"
+
+#include "ns3/assert.h"
+
+namespace ns3
+{
+
+CacheStore::CacheStore(uint32_t capacity)
+    : m_capacity(capacity)
+{
+    m_index.reserve(capacity);
+}
+
+void
+CacheStore::SetCapacity(uint32_t capacity)
+{
+    m_capacity = capacity;
+    m_index.reserve(capacity);
+    while (m_order.GetSize() > m_capacity)
+    {
+        EvictFront();
+    }
+}
+
+uint32_t
+CacheStore::GetCapacity() const
+{
+    return m_capacity;
+}
+
+uint32_t
+CacheStore::GetSize() const
+{
+    return m_order.GetSize();
+}
+
+bool
+CacheStore::Contains(uint32_t id) const
+{
+    return m_index.find(id) != m_index.end();
+}
+
+bool
+CacheStore::Insert(uint32_t id, uint32_t* evicted)
+{
+    if (m_capacity == 0 || Contains(id))
+    {
+        return false;
+    }
+
+    bool hasEvicted = false;
+    if (m_order.GetSize() >= m_capacity)
+    {
+        uint32_t victim = EvictFront();
+        if (evicted)
+        {
+            *evicted = victim;
+        }
+        hasEvicted = true;
+    }
+
+    CacheEntry& entry = m_index[id];
+    entry.id = id;
+    m_order.PushBack(&entry);
+    return hasEvicted;
+}
+
+bool
+CacheStore::Erase(uint32_t id)
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+    {
+        return false;
+    }
+    m_order.Remove(&it->second);
+    m_index.erase(it);
+    return true;
+}
+
+void
+CacheStore::Clear()
+{
+    while (!m_order.IsEmpty())
+    {
+        m_order.PopFront();
+    }
+    m_index.clear();
+}
+
+uint32_t
+CacheStore::EvictFront()
+{
+    CacheEntry* entry = m_order.PopFront();
+    NS_ASSERT(entry);
+    uint32_t id = entry->id;
+    m_index.erase(id);
+    return id;
+}
+
+} // namespace ns3
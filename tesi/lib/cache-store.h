@@ -0,0 +1,243 @@
+#ifndef CACHE_STORE_H
+#define CACHE_STORE_H
+
+#include "ns3/assert.h"
+
+#include <stdint.h>
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * \brief Node of an intrusive list of cached object ids.
+ *
+ * The node is owned by the hash index of the cache, the list only links it.
+ */
+struct CacheEntry
+{
+    uint32_t id;      //!< Object id
+    CacheEntry* prev; //!< Previous entry in the list
+    CacheEntry* next; //!< Next entry in the list
+};
+
+/**
+ * \brief Intrusive doubly linked list of CacheEntry nodes.
+ *
+ * Every operation is O(1) and none of them allocates. The front of the list
+ * holds the oldest entry, the back the newest one.
+ */
+class CacheEntryList
+{
+  public:
+    CacheEntryList();
+
+    CacheEntryList(const CacheEntryList&) = delete;
+    CacheEntryList& operator=(const CacheEntryList&) = delete;
+
+    /**
+     * \return true if the list has no entries
+     */
+    bool IsEmpty() const;
+
+    /**
+     * \return the number of linked entries
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \return the oldest entry, nullptr if the list is empty
+     */
+    CacheEntry* Front() const;
+
+    /**
+     * \return the newest entry, nullptr if the list is empty
+     */
+    CacheEntry* Back() const;
+
+    /**
+     * \param entry an entry linked in this list
+     * \return the entry inserted right after the given one, nullptr if it is the newest
+     */
+    CacheEntry* Next(const CacheEntry* entry) const;
+
+    /**
+     * \brief Link an entry as the newest one.
+     * \param entry an entry not linked in any list
+     */
+    void PushBack(CacheEntry* entry);
+
+    /**
+     * \brief Link an entry as the oldest one.
+     * \param entry an entry not linked in any list
+     */
+    void PushFront(CacheEntry* entry);
+
+    /**
+     * \brief Unlink an entry from this list.
+     * \param entry an entry linked in this list
+     */
+    void Remove(CacheEntry* entry);
+
+    /**
+     * \brief Unlink the oldest entry.
+     * \return the unlinked entry, nullptr if the list is empty
+     */
+    CacheEntry* PopFront();
+
+  private:
+    CacheEntry m_head; //!< Sentinel, m_head.next is the front and m_head.prev the back
+    uint32_t m_size;   //!< Number of linked entries
+};
+
+/**
+ * \brief Bounded store of object ids with FIFO replacement.
+ *
+ * A hash index maps every id to its node and the nodes are chained in
+ * insertion order, so lookup, insertion and eviction are all O(1).
+ */
+class CacheStore
+{
+  public:
+    /**
+     * \param capacity maximum number of ids kept in the store
+     */
+    explicit CacheStore(uint32_t capacity = 0);
+
+    /**
+     * \brief Set the maximum number of ids, evicting the oldest ones if needed.
+     * \param capacity maximum number of ids kept in the store
+     */
+    void SetCapacity(uint32_t capacity);
+
+    /**
+     * \return the maximum number of ids kept in the store
+     */
+    uint32_t GetCapacity() const;
+
+    /**
+     * \return the number of ids currently stored
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \param id the object id
+     * \return true if the id is stored
+     */
+    bool Contains(uint32_t id) const;
+
+    /**
+     * \brief Store an id as the newest entry, evicting the oldest one when full.
+     * \param id the object id, ignored if already stored
+     * \param evicted if not null, receives the id of the evicted entry
+     * \return true if an entry was evicted
+     */
+    bool Insert(uint32_t id, uint32_t* evicted = nullptr);
+
+    /**
+     * \brief Remove an id from the store.
+     * \param id the object id
+     * \return true if the id was stored
+     */
+    bool Erase(uint32_t id);
+
+    /**
+     * \brief Remove every id.
+     */
+    void Clear();
+
+    /**
+     * \brief Drop the oldest entry, the store must not be empty.
+     * \return the id of the dropped entry
+     */
+    uint32_t EvictFront();
+
+  private:
+    std::unordered_map<uint32_t, CacheEntry> m_index; //!< id -> node, nodes never move on rehash
+    CacheEntryList m_order;                           //!< Nodes in insertion order
+    uint32_t m_capacity;                              //!< Maximum number of ids
+};
+
+inline CacheEntryList::CacheEntryList()
+    : m_size(0)
+{
+    m_head.id = 0;
+    m_head.prev = &m_head;
+    m_head.next = &m_head;
+}
+
+inline bool
+CacheEntryList::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+inline uint32_t
+CacheEntryList::GetSize() const
+{
+    return m_size;
+}
+
+inline CacheEntry*
+CacheEntryList::Front() const
+{
+    return m_size == 0 ? nullptr : m_head.next;
+}
+
+inline CacheEntry*
+CacheEntryList::Back() const
+{
+    return m_size == 0 ? nullptr : m_head.prev;
+}
+
+inline CacheEntry*
+CacheEntryList::Next(const CacheEntry* entry) const
+{
+    return entry->next == &m_head ? nullptr : entry->next;
+}
+
+inline void
+CacheEntryList::PushBack(CacheEntry* entry)
+{
+    entry->prev = m_head.prev;
+    entry->next = &m_head;
+    m_head.prev->next = entry;
+    m_head.prev = entry;
+    m_size++;
+}
+
+inline void
+CacheEntryList::PushFront(CacheEntry* entry)
+{
+    entry->prev = &m_head;
+    entry->next = m_head.next;
+    m_head.next->prev = entry;
+    m_head.next = entry;
+    m_size++;
+}
+
+inline void
+CacheEntryList::Remove(CacheEntry* entry)
+{
+    NS_ASSERT(m_size > 0);
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = nullptr;
+    entry->next = nullptr;
+    m_size--;
+}
+
+inline CacheEntry*
+CacheEntryList::PopFront()
+{
+    CacheEntry* entry = Front();
+    if (entry)
+    {
+        Remove(entry);
+    }
+    return entry;
+}
+
+} // namespace ns3
+
+#endif /* CACHE_STORE_H */
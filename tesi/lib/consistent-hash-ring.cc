@@ -0,0 +1,91 @@
+#include "consistent-hash-ring.h"
+
+#include "hash-util.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Seed of the ring points, so that point p of shard 0 is not where id p lands
+const uint64_t g_pointSeed = 0x3c6ef372fe94f82bULL;
+
+/// Seed of the object ids
+const uint64_t g_idSeed = 0xa54ff53a5f1d36f1ULL;
+
+} // namespace
+
+ConsistentHashRing::ConsistentHashRing(uint32_t virtualNodes)
+    : m_virtualNodes(std::max<uint32_t>(virtualNodes, 1))
+{
+}
+
+uint32_t
+ConsistentHashRing::AddShard(const Address& address)
+{
+    uint32_t shard = m_addresses.size();
+    m_addresses.push_back(address);
+    m_active.push_back(true);
+    for (uint32_t point = 0; point < m_virtualNodes; point++)
+    {
+        m_points.emplace_back(SplitMix64(uint64_t(shard) << 32 | point, g_pointSeed), shard);
+    }
+    std::sort(m_points.begin(), m_points.end());
+    return shard;
+}
+
+bool
+ConsistentHashRing::RemoveShard(uint32_t shard)
+{
+    if (!IsActive(shard))
+    {
+        return false;
+    }
+    m_active[shard] = false;
+    m_points.erase(std::remove_if(m_points.begin(),
+                                  m_points.end(),
+                                  [shard](const std::pair<uint64_t, uint32_t>& point) {
+                                      return point.second == shard;
+                                  }),
+                   m_points.end());
+    return true;
+}
+
+uint32_t
+ConsistentHashRing::GetShardCount() const
+{
+    return std::count(m_active.begin(), m_active.end(), true);
+}
+
+bool
+ConsistentHashRing::IsActive(uint32_t shard) const
+{
+    return shard < m_active.size() && m_active[shard];
+}
+
+uint32_t
+ConsistentHashRing::GetShard(uint32_t id) const
+{
+    NS_ASSERT_MSG(!m_points.empty(), "No shard on the ring");
+    uint64_t hash = SplitMix64(id, g_idSeed);
+    auto it = std::lower_bound(m_points.begin(),
+                               m_points.end(),
+                               hash,
+                               [](const std::pair<uint64_t, uint32_t>& point, uint64_t value) {
+                                   return point.first < value;
+                               });
+    return it == m_points.end() ? m_points.front().second : it->second;
+}
+
+const Address&
+ConsistentHashRing::GetAddress(uint32_t shard) const
+{
+    return m_addresses[shard];
+}
+
+} // namespace ns3
@@ -0,0 +1,84 @@
+#ifndef CONSISTENT_HASH_RING_H
+#define CONSISTENT_HASH_RING_H
+
+#include "ns3/address.h"
+#include "ns3/simple-ref-count.h"
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Consistent-hash ring mapping object ids to the shards of a cluster.
+ *
+ * Each shard owns VirtualNodes points of a 64-bit ring, at the hash of its
+ * number and of the point index; an id belongs to the shard of the first
+ * point at or after its own hash, wrapping around. Points and ids are hashed
+ * with different seeds, or the small ids would all fall on the points of the
+ * first shard. Adding or removing a
+ * shard only moves the ids falling between its points and their
+ * predecessors, about 1/K of them for K shards, and the virtual nodes spread
+ * the load evenly. Lookups are a binary search over the sorted points.
+ *
+ * The ring is shared, through a Ptr, by the cluster that changes it and by
+ * the clients routing with it, so membership changes apply to every client
+ * at once.
+ */
+class ConsistentHashRing : public SimpleRefCount<ConsistentHashRing>
+{
+  public:
+    /**
+     * \param virtualNodes points of the ring owned by each shard
+     */
+    explicit ConsistentHashRing(uint32_t virtualNodes);
+
+    /**
+     * \brief Put a shard on the ring.
+     * \param address the address the requests for its ids are sent to
+     * \return the shard number, never reused
+     */
+    uint32_t AddShard(const Address& address);
+
+    /**
+     * \brief Take a shard off the ring, its ids moving to the next points.
+     * \param shard the shard number
+     * \return true if the shard was on the ring
+     */
+    bool RemoveShard(uint32_t shard);
+
+    /**
+     * \return the number of shards on the ring
+     */
+    uint32_t GetShardCount() const;
+
+    /**
+     * \param shard the shard number
+     * \return true if the shard is on the ring
+     */
+    bool IsActive(uint32_t shard) const;
+
+    /**
+     * \param id the object id
+     * \return the shard owning the id, the ring must not be empty
+     */
+    uint32_t GetShard(uint32_t id) const;
+
+    /**
+     * \param shard the shard number
+     * \return the address of the shard
+     */
+    const Address& GetAddress(uint32_t shard) const;
+
+  private:
+    uint32_t m_virtualNodes;                          //!< Points per shard
+    std::vector<Address> m_addresses;                 //!< Address of every shard ever added
+    std::vector<bool> m_active;                       //!< Whether each shard is on the ring
+    std::vector<std::pair<uint64_t, uint32_t>> m_points; //!< Points and their shards, sorted
+};
+
+} // namespace ns3
+
+#endif /* CONSISTENT_HASH_RING_H */
@@ -0,0 +1,120 @@
+#include "core-pool.h"
+
+#include "hash-util.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+CorePool::CorePool()
+    : m_queueSize(0)
+{
+}
+
+void
+CorePool::Configure(uint32_t cores, uint32_t queueSize)
+{
+    NS_ASSERT_MSG(cores == 0 || queueSize > 0, "A core must hold at least the job in service");
+    m_cores.assign(cores, Core{{}, Time(), Time(), Time(), 0, 0, 0, 0, 0});
+    m_queueSize = queueSize;
+}
+
+bool
+CorePool::IsEnabled() const
+{
+    return !m_cores.empty();
+}
+
+uint32_t
+CorePool::GetCores() const
+{
+    return m_cores.size();
+}
+
+uint32_t
+CorePool::Steer(uint64_t key) const
+{
+    return static_cast<uint32_t>(SplitMix64(key) % m_cores.size());
+}
+
+bool
+CorePool::Admit(uint32_t core, Time now)
+{
+    Core& c = m_cores[core];
+    Advance(c, now);
+    uint32_t depth = c.completions.size();
+    c.arrivals++;
+    c.depthSum += depth;
+    c.maxDepth = std::max(c.maxDepth, depth);
+    if (depth >= m_queueSize)
+    {
+        c.drops++;
+        return false;
+    }
+    return true;
+}
+
+Time
+CorePool::Run(uint32_t core, Time now, Time service)
+{
+    Core& c = m_cores[core];
+    Advance(c, now);
+    Time start = std::max(now, c.busyUntil);
+    c.busyUntil = start + service;
+    c.completions.push_back(c.busyUntil);
+    c.busy += service;
+    c.wait += start - now;
+    c.jobs++;
+    return c.busyUntil - now;
+}
+
+CorePool::CoreStats
+CorePool::GetStats(uint32_t core) const
+{
+    const Core& c = m_cores[core];
+    return {c.jobs,
+            c.drops,
+            c.busy,
+            c.wait,
+            c.arrivals > 0 ? double(c.depthSum) / c.arrivals : 0,
+            c.maxDepth};
+}
+
+uint64_t
+CorePool::GetDrops() const
+{
+    uint64_t drops = 0;
+    for (const Core& c : m_cores)
+    {
+        drops += c.drops;
+    }
+    return drops;
+}
+
+double
+CorePool::GetImbalance() const
+{
+    uint64_t jobs = 0;
+    uint64_t most = 0;
+    for (const Core& c : m_cores)
+    {
+        jobs += c.jobs;
+        most = std::max(most, c.jobs);
+    }
+    return jobs > 0 ? double(most) * m_cores.size() / jobs : 0;
+}
+
+void
+CorePool::Advance(Core& core, Time now)
+{
+    // completion times are queued in order, the cores serving first come first
+    while (!core.completions.empty() && core.completions.front() <= now)
+    {
+        core.completions.pop_front();
+    }
+}
+
+} // namespace ns3
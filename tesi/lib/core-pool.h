@@ -0,0 +1,127 @@
+#ifndef CORE_POOL_H
+#define CORE_POOL_H
+
+#include "ns3/nstime.h"
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Worker cores of a cache, each serving its jobs in order.
+ *
+ * As with receive-side scaling, every job is steered to one core by a hash
+ * of its key, the object id or the flow of the datagram, so a skewed key
+ * distribution loads some cores more than others. A core serves one job at
+ * a time; the jobs waiting or in service on a core are bounded, and a job
+ * arriving at a full core is dropped. The service time of a job is only
+ * known once the cache has handled it, so the pool is a queueing model: the
+ * cache changes its state on arrival and the outputs of the job wait for the
+ * time Run returns.
+ */
+class CorePool
+{
+  public:
+    /// Counters of one core
+    struct CoreStats
+    {
+        uint64_t jobs;       //!< Jobs served
+        uint64_t drops;      //!< Jobs dropped on a full queue
+        Time busy;           //!< Service time of the jobs served
+        Time wait;           //!< Time the jobs served waited for the core
+        double meanDepth;    //!< Jobs found on the core by the arrivals, on average
+        uint32_t maxDepth;   //!< Most jobs found on the core by an arrival
+    };
+
+    CorePool();
+    CorePool(const CorePool&) = delete;
+    CorePool& operator=(const CorePool&) = delete;
+
+    /**
+     * \brief Set the cores and clear every queue and counter.
+     * \param cores worker cores, 0 disables the model
+     * \param queueSize jobs a core holds, the one in service included
+     */
+    void Configure(uint32_t cores, uint32_t queueSize);
+
+    /**
+     * \return true if the cache has cores
+     */
+    bool IsEnabled() const;
+
+    /**
+     * \return the number of cores
+     */
+    uint32_t GetCores() const;
+
+    /**
+     * \param key the steering key of a job
+     * \return the core serving the job
+     */
+    uint32_t Steer(uint64_t key) const;
+
+    /**
+     * \brief Check that a core has room for one more job, counting a drop otherwise.
+     * \param core the core
+     * \param now the current time
+     * \return false if the job must be dropped
+     */
+    bool Admit(uint32_t core, Time now);
+
+    /**
+     * \brief Queue a job on a core.
+     * \param core the core
+     * \param now the current time
+     * \param service the service time of the job
+     * \return the time until the job is served, its wait for the core included
+     */
+    Time Run(uint32_t core, Time now, Time service);
+
+    /**
+     * \param core the core
+     * \return the counters of the core
+     */
+    CoreStats GetStats(uint32_t core) const;
+
+    /**
+     * \return the jobs dropped by all the cores
+     */
+    uint64_t GetDrops() const;
+
+    /**
+     * \return the jobs served by the busiest core over the average, 1 for a perfect balance
+     */
+    double GetImbalance() const;
+
+  private:
+    /// State of one core
+    struct Core
+    {
+        std::deque<Time> completions; //!< Completion times of the jobs not served yet, oldest first
+        Time busyUntil;               //!< Completion of the last job queued
+        Time busy;                    //!< Service time of the jobs queued
+        Time wait;                    //!< Wait of the jobs queued
+        uint64_t jobs;                //!< Jobs queued
+        uint64_t drops;               //!< Jobs dropped
+        uint64_t arrivals;            //!< Jobs offered, dropped ones included
+        uint64_t depthSum;            //!< Jobs found on the core, summed over the arrivals
+        uint32_t maxDepth;            //!< Most jobs found by an arrival
+    };
+
+    /**
+     * \brief Forget the jobs of a core served by now.
+     * \param core the core
+     * \param now the current time
+     */
+    void Advance(Core& core, Time now);
+
+    std::vector<Core> m_cores; //!< The cores, empty when disabled
+    uint32_t m_queueSize;      //!< Jobs a core holds
+};
+
+} // namespace ns3
+
+#endif /* CORE_POOL_H */
@@ -0,0 +1,290 @@
+#include "flash-tier.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+FlashTier::FlashTier()
+    : m_capacity(0),
+      m_regionSize(0),
+      m_admission(ADMIT_ALL),
+      m_admitProbability(1),
+      m_maxObjectSize(0),
+      m_reinsertHits(false),
+      m_open(0),
+      m_nextSeq(0),
+      m_bufferedBytes(0),
+      m_admittedBytes(0),
+      m_deviceWriteBytes(0),
+      m_reads(0),
+      m_deviceReadBytes(0),
+      m_rejected(0),
+      m_droppedWrites(0),
+      m_evictions(0),
+      m_reinserted(0)
+{
+}
+
+void
+FlashTier::Configure(uint64_t capacity,
+                     uint32_t regionSize,
+                     Time readLatency,
+                     Time writeLatency,
+                     DataRate bandwidth,
+                     AdmissionPolicy admission,
+                     double admitProbability,
+                     uint32_t maxObjectSize,
+                     bool reinsertHits)
+{
+    m_regions.clear();
+    m_items.clear();
+    m_ghosts.Clear();
+    m_open = 0;
+    m_nextSeq = 0;
+    m_busyUntil = Time();
+    m_flushDoneAt = Time();
+    m_bufferedBytes = 0;
+    m_admittedBytes = 0;
+    m_deviceWriteBytes = 0;
+    m_reads = 0;
+    m_deviceReadBytes = 0;
+    m_rejected = 0;
+    m_droppedWrites = 0;
+    m_evictions = 0;
+    m_reinserted = 0;
+    m_regionSize = regionSize;
+    m_readLatency = readLatency;
+    m_writeLatency = writeLatency;
+    m_bandwidth = bandwidth;
+    m_admission = admission;
+    m_admitProbability = admitProbability;
+    m_maxObjectSize = maxObjectSize;
+    m_reinsertHits = reinsertHits;
+    if (capacity == 0)
+    {
+        m_capacity = 0;
+        return;
+    }
+    NS_ASSERT_MSG(regionSize > ITEM_HEADER, "Region size " << regionSize << " smaller than an item header");
+
+    // the write buffer holds one region, the log needs at least another one
+    uint32_t regions = std::max<uint64_t>(capacity / regionSize, 2);
+    m_capacity = uint64_t(regions) * regionSize;
+    m_regions.resize(regions, Region{0, {}});
+    // remember as many rejected ids as the device holds pages
+    m_ghosts.SetCapacity(std::max<uint64_t>(m_capacity / FLASH_PAGE, 1024));
+    if (m_admission == RANDOM)
+    {
+        m_random = CreateObject<UniformRandomVariable>();
+    }
+}
+
+bool
+FlashTier::IsEnabled() const
+{
+    return m_capacity > 0;
+}
+
+bool
+FlashTier::Contains(uint32_t id) const
+{
+    return m_items.find(id) != m_items.end();
+}
+
+bool
+FlashTier::Insert(uint32_t id, uint32_t size, Time now)
+{
+    NS_ASSERT(IsEnabled());
+    Remove(id);
+    uint64_t footprint = uint64_t(ITEM_HEADER) + size;
+    if (footprint > m_regionSize || (m_maxObjectSize > 0 && size > m_maxObjectSize) || !Admit(id))
+    {
+        m_rejected++;
+        return false;
+    }
+
+    if (m_regions[m_open].used + footprint > m_regionSize)
+    {
+        if (now < m_flushDoneAt)
+        {
+            m_droppedWrites++;
+            return false;
+        }
+        Seal(now);
+        // the objects appended again by the reclaim may leave no room
+        if (m_regions[m_open].used + footprint > m_regionSize)
+        {
+            m_droppedWrites++;
+            return false;
+        }
+    }
+    Append(id, size, false);
+    m_bufferedBytes += footprint;
+    return true;
+}
+
+Time
+FlashTier::Read(uint32_t id, Time now, uint32_t& size)
+{
+    FlashItem& item = m_items.at(id);
+    item.read = true;
+    size = item.size;
+    if (item.region == m_open)
+    {
+        return Time();
+    }
+    uint64_t bytes = (uint64_t(ITEM_HEADER) + item.size + FLASH_PAGE - 1) / FLASH_PAGE * FLASH_PAGE;
+    m_reads++;
+    m_deviceReadBytes += bytes;
+    return Transfer(bytes, m_readLatency, now) - now;
+}
+
+bool
+FlashTier::Remove(uint32_t id)
+{
+    return m_items.erase(id) > 0;
+}
+
+uint32_t
+FlashTier::GetItems() const
+{
+    return m_items.size();
+}
+
+uint64_t
+FlashTier::GetAdmittedBytes() const
+{
+    return m_admittedBytes;
+}
+
+uint64_t
+FlashTier::GetDeviceWriteBytes() const
+{
+    return m_deviceWriteBytes;
+}
+
+double
+FlashTier::GetWriteAmplification() const
+{
+    return m_admittedBytes > 0 ? double(m_deviceWriteBytes) / m_admittedBytes : 0;
+}
+
+uint64_t
+FlashTier::GetReads() const
+{
+    return m_reads;
+}
+
+uint64_t
+FlashTier::GetDeviceReadBytes() const
+{
+    return m_deviceReadBytes;
+}
+
+uint64_t
+FlashTier::GetRejected() const
+{
+    return m_rejected;
+}
+
+uint64_t
+FlashTier::GetDroppedWrites() const
+{
+    return m_droppedWrites;
+}
+
+uint64_t
+FlashTier::GetEvictions() const
+{
+    return m_evictions;
+}
+
+uint64_t
+FlashTier::GetReinserted() const
+{
+    return m_reinserted;
+}
+
+bool
+FlashTier::Admit(uint32_t id)
+{
+    switch (m_admission)
+    {
+    case RANDOM:
+        return m_random->GetValue() < m_admitProbability;
+    case REJECT_FIRST:
+        if (m_ghosts.Erase(id))
+        {
+            return true;
+        }
+        m_ghosts.Insert(id);
+        return false;
+    default:
+        return true;
+    }
+}
+
+void
+FlashTier::Append(uint32_t id, uint32_t size, bool read)
+{
+    Region& region = m_regions[m_open];
+    region.used += ITEM_HEADER + size;
+    region.items.emplace_back(id, m_nextSeq);
+    m_items[id] = FlashItem{m_open, size, m_nextSeq, read};
+    m_nextSeq++;
+}
+
+void
+FlashTier::Seal(Time now)
+{
+    // the whole region is written, the unused tail included
+    m_flushDoneAt = Transfer(m_regionSize, m_writeLatency, now);
+    m_deviceWriteBytes += m_regionSize;
+    m_admittedBytes += m_bufferedBytes;
+    m_bufferedBytes = 0;
+
+    // reclaim the oldest region; an object removed or written again since
+    // has a different append number and is skipped
+    m_open = (m_open + 1) % m_regions.size();
+    Region& region = m_regions[m_open];
+    std::vector<std::pair<uint32_t, uint32_t>> reinsert;
+    for (const auto& [id, seq] : region.items)
+    {
+        auto it = m_items.find(id);
+        if (it == m_items.end() || it->second.seq != seq)
+        {
+            continue;
+        }
+        if (m_reinsertHits && it->second.read)
+        {
+            reinsert.emplace_back(id, it->second.size);
+        }
+        else
+        {
+            m_evictions++;
+        }
+        m_items.erase(it);
+    }
+    region.used = 0;
+    region.items.clear();
+
+    // the live bytes of a region always fit in it
+    for (const auto& [id, size] : reinsert)
+    {
+        Append(id, size, false);
+        m_reinserted++;
+    }
+}
+
+Time
+FlashTier::Transfer(uint64_t bytes, Time latency, Time now)
+{
+    Time start = std::max(now, m_busyUntil);
+    m_busyUntil = start + (m_bandwidth.GetBitRate() > 0 ? m_bandwidth.CalculateBytesTxTime(bytes) : Time());
+    return m_busyUntil + latency;
+}
+
+} // namespace ns3
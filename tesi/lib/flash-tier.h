@@ -0,0 +1,239 @@
+#ifndef FLASH_TIER_H
+#define FLASH_TIER_H
+
+#include "cache-store.h"
+
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Flash tier behind the memory of a cache, as a log-structured store.
+ *
+ * The device is cut into regions written whole, in a circular log. Objects
+ * evicted from memory are appended to an in-memory write buffer holding the
+ * open region; when it is full the region is written to the device and the
+ * oldest region is reclaimed for the next writes, dropping its objects (or
+ * appending again those read since they were written, with ReinsertHits).
+ * Every region written counts its whole size, padding included, so the
+ * write amplification is the device bytes over the object bytes admitted.
+ *
+ * The device serves one transfer at a time at its bandwidth, reads in units
+ * of FLASH_PAGE bytes; each operation also pays a fixed read or write
+ * latency. Reads queue behind region writes, so heavy admission slows hits.
+ * A region can be written only after the previous write completed: objects
+ * arriving while the write buffer is still being flushed are dropped.
+ */
+class FlashTier
+{
+  public:
+    /// Rule deciding which evicted objects are written to flash
+    enum AdmissionPolicy
+    {
+        ADMIT_ALL,    //!< Every object that fits a region
+        RANDOM,       //!< Each object with a fixed probability
+        REJECT_FIRST, //!< Objects evicted again after a first rejection
+    };
+
+    /// Bytes in front of each object on the device: id, size and checksum
+    static constexpr uint32_t ITEM_HEADER = 32;
+    /// Unit of the device reads
+    static constexpr uint32_t FLASH_PAGE = 4096;
+
+    FlashTier();
+    FlashTier(const FlashTier&) = delete;
+    FlashTier& operator=(const FlashTier&) = delete;
+
+    /**
+     * \brief Set the device and the admission rule, dropping every object.
+     * \param capacity device size in bytes, 0 disables the tier
+     * \param regionSize bytes written at once, also the largest storable item
+     * \param readLatency fixed cost of a read
+     * \param writeLatency fixed cost of a region write
+     * \param bandwidth transfer rate of the device, 0 for instant transfers
+     * \param admission rule for the objects evicted from memory
+     * \param admitProbability probability of admission of the RANDOM rule
+     * \param maxObjectSize largest object admitted, 0 for no limit
+     * \param reinsertHits whether objects read since written survive the reclaim of their region
+     */
+    void Configure(uint64_t capacity,
+                   uint32_t regionSize,
+                   Time readLatency,
+                   Time writeLatency,
+                   DataRate bandwidth,
+                   AdmissionPolicy admission,
+                   double admitProbability,
+                   uint32_t maxObjectSize,
+                   bool reinsertHits);
+
+    /**
+     * \return true if the tier has a device
+     */
+    bool IsEnabled() const;
+
+    /**
+     * \param id the object id
+     * \return true if the object is on flash or in the write buffer
+     */
+    bool Contains(uint32_t id) const;
+
+    /**
+     * \brief Offer an object evicted from memory to the tier.
+     * \param id the object id, replacing any older copy
+     * \param size the object size, 0 for an object without payload
+     * \param now the current time
+     * \return true if the object was appended to the write buffer
+     */
+    bool Insert(uint32_t id, uint32_t size, Time now);
+
+    /**
+     * \brief Read an object, queueing the read on the device.
+     * \param id the object id, must be contained
+     * \param now the current time
+     * \param[out] size the object size
+     * \return the time until the object is read, zero if it is in the write buffer
+     */
+    Time Read(uint32_t id, Time now, uint32_t& size);
+
+    /**
+     * \brief Drop an object; its bytes stay in the log until the region is reclaimed.
+     * \param id the object id
+     * \return true if the object was contained
+     */
+    bool Remove(uint32_t id);
+
+    /**
+     * \return the number of objects held
+     */
+    uint32_t GetItems() const;
+
+    /**
+     * \return the object bytes admitted and written to the device, headers included
+     */
+    uint64_t GetAdmittedBytes() const;
+
+    /**
+     * \return the bytes written to the device
+     */
+    uint64_t GetDeviceWriteBytes() const;
+
+    /**
+     * \return the device bytes written per admitted byte, 0 before the first region write
+     */
+    double GetWriteAmplification() const;
+
+    /**
+     * \return the number of device reads
+     */
+    uint64_t GetReads() const;
+
+    /**
+     * \return the bytes read from the device
+     */
+    uint64_t GetDeviceReadBytes() const;
+
+    /**
+     * \return the number of objects refused by the admission rule or too large for a region
+     */
+    uint64_t GetRejected() const;
+
+    /**
+     * \return the number of objects dropped because the write buffer was being flushed
+     */
+    uint64_t GetDroppedWrites() const;
+
+    /**
+     * \return the number of objects dropped by the reclaim of their region
+     */
+    uint64_t GetEvictions() const;
+
+    /**
+     * \return the number of objects appended again by the reclaim of their region
+     */
+    uint64_t GetReinserted() const;
+
+  private:
+    /// Object on flash
+    struct FlashItem
+    {
+        uint32_t region; //!< Region holding the object
+        uint32_t size;   //!< Object size
+        uint64_t seq;    //!< Append number, identifying the live copy in the region
+        bool read;       //!< Whether the object was read since it was written
+    };
+
+    /// Region of the log
+    struct Region
+    {
+        uint32_t used;                                     //!< Bytes appended
+        std::vector<std::pair<uint32_t, uint64_t>> items; //!< Appended objects and their append numbers
+    };
+
+    /**
+     * \param id the object id
+     * \return true if the admission rule accepts the object
+     */
+    bool Admit(uint32_t id);
+
+    /**
+     * \brief Append an object to the open region.
+     * \param id the object id
+     * \param size the object size
+     * \param read whether the object was read since it was first written
+     */
+    void Append(uint32_t id, uint32_t size, bool read);
+
+    /**
+     * \brief Write the open region to the device and reclaim the next one.
+     * \param now the current time
+     */
+    void Seal(Time now);
+
+    /**
+     * \brief Queue a transfer on the device.
+     * \param bytes the bytes transferred
+     * \param latency the fixed cost of the operation
+     * \param now the current time
+     * \return the completion time of the operation
+     */
+    Time Transfer(uint64_t bytes, Time latency, Time now);
+
+    uint64_t m_capacity;            //!< Device size, 0 when disabled
+    uint32_t m_regionSize;          //!< Bytes written at once
+    Time m_readLatency;             //!< Fixed cost of a read
+    Time m_writeLatency;            //!< Fixed cost of a region write
+    DataRate m_bandwidth;           //!< Transfer rate, 0 for instant transfers
+    AdmissionPolicy m_admission;    //!< Rule for the evicted objects
+    double m_admitProbability;      //!< Admission probability of RANDOM
+    uint32_t m_maxObjectSize;       //!< Largest object admitted, 0 for no limit
+    bool m_reinsertHits;            //!< Whether read objects survive a reclaim
+    Ptr<UniformRandomVariable> m_random; //!< Draws of the RANDOM rule
+    std::vector<Region> m_regions;  //!< The log
+    uint32_t m_open;                //!< Region held by the write buffer
+    std::unordered_map<uint32_t, FlashItem> m_items; //!< Index of the live objects
+    CacheStore m_ghosts;            //!< Ids rejected once by REJECT_FIRST, oldest forgotten first
+    uint64_t m_nextSeq;             //!< Next append number
+    Time m_busyUntil;               //!< End of the last transfer queued on the device
+    Time m_flushDoneAt;             //!< Completion of the last region write
+    uint64_t m_bufferedBytes;       //!< Object bytes admitted in the write buffer
+    uint64_t m_admittedBytes;       //!< Object bytes admitted and written, headers included
+    uint64_t m_deviceWriteBytes;    //!< Bytes written to the device
+    uint64_t m_reads;               //!< Device reads
+    uint64_t m_deviceReadBytes;     //!< Bytes read from the device
+    uint64_t m_rejected;            //!< Objects refused
+    uint64_t m_droppedWrites;       //!< Objects dropped while the buffer was flushed
+    uint64_t m_evictions;           //!< Objects dropped by a reclaim
+    uint64_t m_reinserted;          //!< Objects appended again by a reclaim
+};
+
+} // namespace ns3
+
+#endif /* FLASH_TIER_H */
@@ -0,0 +1,333 @@
+#include "flat-cache-policy.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FLAT_CACHE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace ns3
+{
+
+namespace
+{
+
+const uint32_t LANES = 8;      //!< Slots per AVX2 register, the array is padded to it
+const uint32_t LFU_SHIFT = 24; //!< LFU keys hold the access count above this bit
+const std::align_val_t ALIGNMENT = static_cast<std::align_val_t>(LANES * sizeof(uint32_t));
+
+/**
+ * \return the first slot of the first n holding value, -1 if none
+ */
+int32_t
+FindScalar(const uint32_t* values, uint32_t n, uint32_t value)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (values[i] == value)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \return the smallest of the first n values, padded slots included
+ */
+uint32_t
+MinScalar(const uint32_t* values, uint32_t n)
+{
+    return *std::min_element(values, values + n);
+}
+
+#ifdef FLAT_CACHE_X86_SIMD
+
+__attribute__((target("avx2"))) int32_t
+FindAvx2(const uint32_t* values, uint32_t n, uint32_t value)
+{
+    __m256i needle = _mm256_set1_epi32(value);
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+        uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+        if (n - i < 8)
+        {
+            mask &= (1U << (n - i)) - 1;
+        }
+        if (mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("avx2"))) uint32_t
+MinAvx2(const uint32_t* values, uint32_t n)
+{
+    __m256i best = _mm256_set1_epi32(-1);
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        best = _mm256_min_epu32(
+            best,
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i)));
+    }
+    __m128i half = _mm_min_epu32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+}
+
+__attribute__((target("sse4.1"))) int32_t
+FindSse41(const uint32_t* values, uint32_t n, uint32_t value)
+{
+    __m128i needle = _mm_set1_epi32(value);
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(values + i));
+        uint32_t mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+        if (n - i < 4)
+        {
+            mask &= (1U << (n - i)) - 1;
+        }
+        if (mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("sse4.1"))) uint32_t
+MinSse41(const uint32_t* values, uint32_t n)
+{
+    __m128i best = _mm_set1_epi32(-1);
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        best = _mm_min_epu32(best, _mm_load_si128(reinterpret_cast<const __m128i*>(values + i)));
+    }
+    best = _mm_min_epu32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_min_epu32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(best);
+}
+
+/// Widest instruction set available on this CPU
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_SSE41,
+    SIMD_AVX2,
+};
+
+SimdLevel
+DetectSimd()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return SIMD_SSE41;
+    }
+    return SIMD_SCALAR;
+}
+
+const SimdLevel g_simd = DetectSimd();
+
+#endif /* FLAT_CACHE_X86_SIMD */
+
+/**
+ * \brief Find a value among the first n slots of a padded, aligned array.
+ * \return the slot, -1 if not found
+ */
+inline int32_t
+Find(const uint32_t* values, uint32_t n, uint32_t value)
+{
+#ifdef FLAT_CACHE_X86_SIMD
+    if (g_simd == SIMD_AVX2)
+    {
+        return FindAvx2(values, n, value);
+    }
+    if (g_simd == SIMD_SSE41)
+    {
+        return FindSse41(values, n, value);
+    }
+#endif
+    return FindScalar(values, n, value);
+}
+
+/**
+ * \brief Smallest value of a padded, aligned array.
+ * \param n number of slots, a multiple of LANES
+ */
+inline uint32_t
+Min(const uint32_t* values, uint32_t n)
+{
+#ifdef FLAT_CACHE_X86_SIMD
+    if (g_simd == SIMD_AVX2)
+    {
+        return MinAvx2(values, n);
+    }
+    if (g_simd == SIMD_SSE41)
+    {
+        return MinSse41(values, n);
+    }
+#endif
+    return MinScalar(values, n);
+}
+
+} // namespace
+
+bool
+FlatCachePolicy::IsSupported(PolicyType type)
+{
+    return type == FIFO || type == LRU || type == LFU;
+}
+
+FlatCachePolicy::FlatCachePolicy(PolicyType type, uint32_t capacity)
+    : CacheEvictionPolicy(capacity),
+      m_type(type),
+      m_slots(std::max<uint32_t>(LANES, (capacity + LANES - 1) / LANES * LANES)),
+      m_size(0),
+      m_stamp(0),
+      m_stampMask(type == LFU ? (1U << LFU_SHIFT) - 1 : UINT32_MAX)
+{
+    NS_ASSERT(IsSupported(type));
+    m_ids = static_cast<uint32_t*>(::operator new(m_slots * sizeof(uint32_t), ALIGNMENT));
+    m_keys = static_cast<uint32_t*>(::operator new(m_slots * sizeof(uint32_t), ALIGNMENT));
+    std::fill(m_ids, m_ids + m_slots, 0);
+    std::fill(m_keys, m_keys + m_slots, UINT32_MAX);
+}
+
+FlatCachePolicy::~FlatCachePolicy()
+{
+    ::operator delete(m_ids, ALIGNMENT);
+    ::operator delete(m_keys, ALIGNMENT);
+}
+
+std::string
+FlatCachePolicy::GetName() const
+{
+    switch (m_type)
+    {
+    case LRU:
+        return "LRU (flat)";
+    case LFU:
+        return "LFU (flat)";
+    default:
+        return "FIFO (flat)";
+    }
+}
+
+uint32_t
+FlatCachePolicy::GetSize() const
+{
+    return m_size;
+}
+
+int32_t
+FlatCachePolicy::Find(uint32_t id) const
+{
+    return ns3::Find(m_ids, m_size, id);
+}
+
+bool
+FlatCachePolicy::Contains(uint32_t id) const
+{
+    return Find(id) >= 0;
+}
+
+bool
+FlatCachePolicy::Lookup(uint32_t id)
+{
+    int32_t slot = Find(id);
+    if (slot < 0)
+    {
+        return false;
+    }
+    if (m_type == LRU)
+    {
+        m_keys[slot] = NextKey(0);
+    }
+    else if (m_type == LFU)
+    {
+        uint32_t freq = std::min<uint32_t>((m_keys[slot] >> LFU_SHIFT) + 1, LfuCachePolicy::MAX_COUNT);
+        m_keys[slot] = NextKey(freq);
+    }
+    return true;
+}
+
+uint32_t
+FlatCachePolicy::SelectVictim(uint32_t incoming)
+{
+    NS_ASSERT(m_size > 0);
+    // Padded slots hold UINT32_MAX, which no resident key reaches
+    uint32_t key = Min(m_keys, m_slots);
+    int32_t slot = ns3::Find(m_keys, m_size, key);
+    NS_ASSERT(slot >= 0);
+    return m_ids[slot];
+}
+
+void
+FlatCachePolicy::Remove(uint32_t id)
+{
+    int32_t slot = Find(id);
+    NS_ASSERT(slot >= 0);
+    m_size--;
+    m_ids[slot] = m_ids[m_size];
+    m_keys[slot] = m_keys[m_size];
+    m_keys[m_size] = UINT32_MAX;
+}
+
+void
+FlatCachePolicy::Insert(uint32_t id)
+{
+    NS_ASSERT(m_size < m_slots);
+    m_ids[m_size] = id;
+    m_keys[m_size] = NextKey(1);
+    m_size++;
+}
+
+uint32_t
+FlatCachePolicy::NextKey(uint32_t freq)
+{
+    if (m_stamp >= m_stampMask)
+    {
+        Renumber();
+    }
+    uint32_t key = m_stamp++;
+    if (m_type == LFU)
+    {
+        key |= freq << LFU_SHIFT;
+    }
+    return key;
+}
+
+void
+FlatCachePolicy::Renumber()
+{
+    std::vector<uint32_t> order(m_size);
+    for (uint32_t i = 0; i < m_size; i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return (m_keys[a] & m_stampMask) < (m_keys[b] & m_stampMask);
+    });
+    for (uint32_t rank = 0; rank < m_size; rank++)
+    {
+        uint32_t& key = m_keys[order[rank]];
+        key = (key & ~m_stampMask) | rank;
+    }
+    m_stamp = m_size;
+}
+
+} // namespace ns3
@@ -0,0 +1,80 @@
+#ifndef FLAT_CACHE_POLICY_H
+#define FLAT_CACHE_POLICY_H
+
+#include "cache-eviction-policy.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \brief Storage mode for small caches: ids in a flat, aligned array.
+ *
+ * Each slot holds an id and a 32-bit ordering key, and the victim is the
+ * slot with the smallest key: the insertion stamp for FIFO, the last access
+ * stamp for LRU, and the access count followed by the last access stamp for
+ * LFU. Membership tests and the victim search are linear scans done 8 (AVX2)
+ * or 4 (SSE4.1) slots at a time, chosen at run time, with a scalar fallback
+ * on other CPUs. For a few hundred ids this beats a hash table. Eviction
+ * order is the same as the hashed FIFO, LRU and LFU policies, LFU counts
+ * included: both saturate at LfuCachePolicy::MAX_COUNT.
+ */
+class FlatCachePolicy final : public CacheEvictionPolicy
+{
+  public:
+    /**
+     * \param type a replacement policy
+     * \return true if the policy can run on the flat storage
+     */
+    static bool IsSupported(PolicyType type);
+
+    /**
+     * \param type FIFO, LRU or LFU
+     * \param capacity maximum number of resident ids
+     */
+    FlatCachePolicy(PolicyType type, uint32_t capacity);
+    ~FlatCachePolicy() override;
+
+    FlatCachePolicy(const FlatCachePolicy&) = delete;
+    FlatCachePolicy& operator=(const FlatCachePolicy&) = delete;
+
+    std::string GetName() const override;
+    uint32_t GetSize() const override;
+    bool Contains(uint32_t id) const override;
+    bool Lookup(uint32_t id) override;
+    uint32_t SelectVictim(uint32_t incoming) override;
+    void Remove(uint32_t id) override;
+    void Insert(uint32_t id) override;
+
+  private:
+    /**
+     * \param id the object id
+     * \return the slot holding the id, -1 if not resident
+     */
+    int32_t Find(uint32_t id) const;
+
+    /**
+     * \param freq the access count, for LFU
+     * \return a key newer than every key handed out so far
+     */
+    uint32_t NextKey(uint32_t freq);
+
+    /**
+     * \brief Reassign the stamps by rank once they reach m_stampMask.
+     */
+    void Renumber();
+
+    PolicyType m_type;    //!< FIFO, LRU or LFU
+    uint32_t* m_ids;      //!< Resident ids, m_slots entries aligned to 32 bytes
+    uint32_t* m_keys;     //!< Ordering keys, UINT32_MAX past m_size
+    uint32_t m_slots;     //!< Capacity rounded up to a multiple of 8
+    uint32_t m_size;      //!< Number of resident ids
+    uint32_t m_stamp;     //!< Next stamp
+    uint32_t m_stampMask; //!< Bits of the key holding the stamp
+};
+
+} // namespace ns3
+
+#endif /* FLAT_CACHE_POLICY_H */
@@ -0,0 +1,32 @@
+#ifndef HASH_UTIL_H
+#define HASH_UTIL_H
+
+#include <stdint.h>
+
+namespace ns3
+{
+
+/**
+ * \brief Hash a key with the splitmix64 finalizer.
+ *
+ * Consecutive keys land far apart. Keys of different kinds that are compared
+ * on the same scale, e.g. object ids and ring points, must use different
+ * seeds: with the same seed, key x of one kind hashes exactly as key x of the
+ * other.
+ *
+ * \param x the key
+ * \param seed the domain of the key
+ * \return the hash of x
+ */
+inline uint64_t
+SplitMix64(uint64_t x, uint64_t seed = 0)
+{
+    x += seed + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace ns3
+
+#endif /* HASH_UTIL_H */
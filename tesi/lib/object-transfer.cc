@@ -0,0 +1,227 @@
+#include "object-transfer.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ObjectTransfer");
+
+/// IPv4 and UDP headers of every datagram
+static const uint32_t IP_UDP_OVERHEAD = 28;
+
+ObjectSender::ObjectSender()
+    : m_socket(nullptr),
+      m_mtu(1400),
+      m_window(1),
+      m_tokens(0),
+      m_datagrams(0),
+      m_bytes(0),
+      m_sendErrors(0)
+{
+}
+
+ObjectSender::~ObjectSender()
+{
+    Simulator::Cancel(m_event);
+}
+
+void
+ObjectSender::Configure(Ptr<Socket> socket, uint32_t mtu, DataRate rate, uint32_t window)
+{
+    Stop();
+    m_socket = socket;
+    m_mtu = mtu;
+    m_rate = rate;
+    m_window = std::max<uint32_t>(window, 1);
+    m_tokens = double(m_window) * m_mtu;
+    m_lastRefill = Simulator::Now();
+    NS_ASSERT_MSG(GetSegmentPayload() > 0, "MTU " << mtu << " leaves no room for object bytes");
+}
+
+uint32_t
+ObjectSender::GetSegmentPayload() const
+{
+    uint32_t headers = IP_UDP_OVERHEAD + CacheProtocolHeader().GetSerializedSize() +
+                       CacheSegmentHeader().GetSerializedSize();
+    return m_mtu > headers ? m_mtu - headers : 0;
+}
+
+void
+ObjectSender::Send(const CacheProtocolHeader& header,
+                   uint32_t objectSize,
+                   const Address& to,
+                   Ptr<const Packet> options)
+{
+    NS_ASSERT(objectSize > 0);
+    NS_ASSERT_MSG(!options || options->GetSize() < GetSegmentPayload(),
+                  "Optional headers leave no room for object bytes");
+    Transfer transfer;
+    transfer.header = header;
+    transfer.header.SetFlags(header.GetFlags() | CacheProtocolHeader::SEGMENT);
+    transfer.options = options;
+    transfer.objectSize = objectSize;
+    transfer.offset = 0;
+    transfer.to = to;
+    m_transfers.push_back(transfer);
+    if (!m_event.IsRunning())
+    {
+        SendNext();
+    }
+}
+
+void
+ObjectSender::SendNext()
+{
+    bool paced = m_rate.GetBitRate() > 0;
+    while (!m_transfers.empty())
+    {
+        Transfer& transfer = m_transfers.front();
+        uint32_t optionsSize = transfer.options ? transfer.options->GetSize() : 0;
+        uint32_t length = std::min(GetSegmentPayload() - optionsSize, transfer.objectSize - transfer.offset);
+        CacheSegmentHeader segment;
+        uint32_t wireSize = length + segment.GetSerializedSize() + optionsSize +
+                            transfer.header.GetSerializedSize() + IP_UDP_OVERHEAD;
+
+        if (paced)
+        {
+            Time now = Simulator::Now();
+            m_tokens = std::min(double(m_window) * m_mtu,
+                                m_tokens + (now - m_lastRefill).GetSeconds() * m_rate.GetBitRate() / 8);
+            m_lastRefill = now;
+            if (m_tokens < wireSize)
+            {
+                m_event = Simulator::Schedule(Seconds((wireSize - m_tokens) * 8 / m_rate.GetBitRate()),
+                                              &ObjectSender::SendNext,
+                                              this);
+                return;
+            }
+            m_tokens -= wireSize;
+        }
+
+        // the object bytes are zero-filled, which ns-3 stores without allocating them
+        Ptr<Packet> packet = Create<Packet>(length);
+        segment.SetObjectSize(transfer.objectSize);
+        segment.SetOffset(transfer.offset);
+        packet->AddHeader(segment);
+        if (transfer.options)
+        {
+            Ptr<Packet> datagram = transfer.options->Copy();
+            datagram->AddAtEnd(packet);
+            packet = datagram;
+        }
+        packet->AddHeader(transfer.header);
+        if (m_socket->SendTo(packet, 0, transfer.to) == -1)
+        {
+            m_sendErrors++;
+            NS_LOG_LOGIC("Segment at offset " << transfer.offset << " of object "
+                                              << transfer.header.GetObjectId() << " not sent");
+        }
+        m_datagrams++;
+        m_bytes += length;
+
+        // round robin: the transfer goes back to the end of the queue
+        transfer.offset += length;
+        if (transfer.offset < transfer.objectSize)
+        {
+            m_transfers.push_back(transfer);
+        }
+        m_transfers.pop_front();
+    }
+}
+
+uint32_t
+ObjectSender::GetPending() const
+{
+    return m_transfers.size();
+}
+
+uint64_t
+ObjectSender::GetDatagrams() const
+{
+    return m_datagrams;
+}
+
+uint64_t
+ObjectSender::GetBytes() const
+{
+    return m_bytes;
+}
+
+uint64_t
+ObjectSender::GetSendErrors() const
+{
+    return m_sendErrors;
+}
+
+void
+ObjectSender::Stop()
+{
+    Simulator::Cancel(m_event);
+    m_transfers.clear();
+}
+
+bool
+ObjectReassembler::AddSegment(uint32_t key, uint32_t objectSize, uint32_t offset, uint32_t length)
+{
+    if (offset >= objectSize)
+    {
+        return false;
+    }
+    PartialObject& object = m_partial[key];
+    if (object.objectSize != objectSize)
+    {
+        // first segment, or a new version of the object: start over
+        object.objectSize = objectSize;
+        object.received = 0;
+        object.offsets.clear();
+    }
+
+    auto it = std::lower_bound(object.offsets.begin(), object.offsets.end(), offset);
+    if (it != object.offsets.end() && *it == offset)
+    {
+        return false;
+    }
+    object.offsets.insert(it, offset);
+    object.received += std::min(length, objectSize - offset);
+
+    if (object.received < objectSize)
+    {
+        return false;
+    }
+    m_partial.erase(key);
+    return true;
+}
+
+uint32_t
+ObjectReassembler::GetReceived(uint32_t key) const
+{
+    auto it = m_partial.find(key);
+    return it != m_partial.end() ? it->second.received : 0;
+}
+
+void
+ObjectReassembler::Remove(uint32_t key)
+{
+    m_partial.erase(key);
+}
+
+uint32_t
+ObjectReassembler::GetSize() const
+{
+    return m_partial.size();
+}
+
+void
+ObjectReassembler::Clear()
+{
+    m_partial.clear();
+}
+
+} // namespace ns3
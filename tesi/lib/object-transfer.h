@@ -0,0 +1,177 @@
+#ifndef OBJECT_TRANSFER_H
+#define OBJECT_TRANSFER_H
+
+#include "cache-protocol-header.h"
+
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <deque>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class Packet;
+class Socket;
+
+/**
+ * \brief Sends objects as a sequence of MTU-sized datagrams.
+ *
+ * Each datagram is a CacheProtocolHeader with the SEGMENT flag, the optional
+ * headers announced by its other flags, a CacheSegmentHeader and up to
+ * GetSegmentPayload() object bytes less the optional headers, so that the
+ * IPv4 packet fits the MTU. Concurrent transfers are served round robin, one
+ * datagram at a time. With a pacing rate, datagrams leave through a token
+ * bucket of Window datagrams refilled at that rate; without one, every
+ * datagram is handed to the socket at once and the device queue does the
+ * pacing, dropping the excess.
+ */
+class ObjectSender
+{
+  public:
+    ObjectSender();
+    ~ObjectSender();
+
+    /**
+     * \brief Set the socket and the segmentation, dropping any transfer in progress.
+     * \param socket the socket datagrams are sent from
+     * \param mtu the IP MTU of the path, in bytes
+     * \param rate the pacing rate, 0 to send without pacing
+     * \param window datagrams that can be sent back to back
+     */
+    void Configure(Ptr<Socket> socket, uint32_t mtu, DataRate rate, uint32_t window);
+
+    /**
+     * \return the object bytes carried by each datagram
+     */
+    uint32_t GetSegmentPayload() const;
+
+    /**
+     * \brief Queue the transfer of an object.
+     * \param header the response header, copied in every datagram with the SEGMENT flag
+     * \param objectSize the object size, in bytes
+     * \param to the receiver
+     * \param options the optional headers announced by the flags of header, copied in every datagram
+     */
+    void Send(const CacheProtocolHeader& header,
+              uint32_t objectSize,
+              const Address& to,
+              Ptr<const Packet> options = nullptr);
+
+    /**
+     * \return the number of transfers in progress
+     */
+    uint32_t GetPending() const;
+
+    /**
+     * \return the number of datagrams sent
+     */
+    uint64_t GetDatagrams() const;
+
+    /**
+     * \return the number of object bytes sent
+     */
+    uint64_t GetBytes() const;
+
+    /**
+     * \return the number of datagrams refused by the socket
+     */
+    uint64_t GetSendErrors() const;
+
+    /**
+     * \brief Drop the transfers in progress and cancel the pacing event.
+     */
+    void Stop();
+
+  private:
+    /// Object being sent
+    struct Transfer
+    {
+        CacheProtocolHeader header; //!< Response header
+        uint32_t objectSize;        //!< Object size
+        uint32_t offset;            //!< Offset of the next datagram
+        Address to;                 //!< Receiver
+        Ptr<const Packet> options;  //!< Optional headers, null for none
+    };
+
+    /**
+     * \brief Send datagrams while the token bucket allows, then schedule the next one.
+     */
+    void SendNext();
+
+    Ptr<Socket> m_socket;             //!< Socket datagrams are sent from
+    uint32_t m_mtu;                   //!< IP MTU of the path
+    DataRate m_rate;                  //!< Pacing rate, 0 for no pacing
+    uint32_t m_window;                //!< Datagrams sent back to back
+    double m_tokens;                  //!< Bytes the bucket allows to send
+    Time m_lastRefill;                //!< Last refill of the bucket
+    std::deque<Transfer> m_transfers; //!< Transfers in progress, next to send first
+    EventId m_event;                  //!< Next paced send
+    uint64_t m_datagrams;             //!< Datagrams sent
+    uint64_t m_bytes;                 //!< Object bytes sent
+    uint64_t m_sendErrors;            //!< Datagrams refused by the socket
+};
+
+/**
+ * \brief Reassembles segmented objects from their CacheSegmentHeader.
+ *
+ * Only the received byte count is kept, not the bytes; a segment is
+ * identified by its offset, so duplicates from a retransmitted request are
+ * counted once.
+ */
+class ObjectReassembler
+{
+  public:
+    /**
+     * \brief Account a received segment.
+     * \param key the object, e.g. its id or the sequence number of the request
+     * \param objectSize the size of the whole object
+     * \param offset the offset of the segment
+     * \param length the object bytes in the segment
+     * \return true if the segment completed the object, whose state is then dropped
+     */
+    bool AddSegment(uint32_t key, uint32_t objectSize, uint32_t offset, uint32_t length);
+
+    /**
+     * \param key the object
+     * \return the bytes received so far, 0 if the object is not being reassembled
+     */
+    uint32_t GetReceived(uint32_t key) const;
+
+    /**
+     * \brief Drop a partially received object.
+     * \param key the object
+     */
+    void Remove(uint32_t key);
+
+    /**
+     * \return the number of objects being reassembled
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \brief Drop every partially received object.
+     */
+    void Clear();
+
+  private:
+    /// Object being reassembled
+    struct PartialObject
+    {
+        uint32_t objectSize;           //!< Size of the whole object
+        uint32_t received;             //!< Distinct bytes received
+        std::vector<uint32_t> offsets; //!< Offsets of the received segments, sorted
+    };
+
+    std::unordered_map<uint32_t, PartialObject> m_partial; //!< Objects being reassembled
+};
+
+} // namespace ns3
+
+#endif /* OBJECT_TRANSFER_H */
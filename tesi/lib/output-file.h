@@ -0,0 +1,30 @@
+#ifndef OUTPUT_FILE_H
+#define OUTPUT_FILE_H
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \brief Name the statistics file of one application.
+ *
+ * Caches and content servers write their own statistics, and a topology
+ * may hold several of each: the node id in the name keeps them from
+ * overwriting each other's results.
+ *
+ * \param name the base name, e.g. "cachestats"
+ * \param nodeId the id of the node of the application
+ * \param extension the extension, dot included
+ * \return output/<name>-<nodeId><extension>
+ */
+inline std::string
+NodeOutputFile(const std::string& name, uint32_t nodeId, const std::string& extension)
+{
+    return "output/" + name + "-" + std::to_string(nodeId) + extension;
+}
+
+} // namespace ns3
+
+#endif /* OUTPUT_FILE_H */
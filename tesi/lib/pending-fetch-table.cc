@@ -0,0 +1,88 @@
+#include "pending-fetch-table.h"
+
+#include "ns3/assert.h"
+
+namespace ns3
+{
+
+PendingFetchTable::PendingFetchTable()
+    : m_maxWaiters(0)
+{
+}
+
+void
+PendingFetchTable::SetMaxWaiters(uint32_t maxWaiters)
+{
+    m_maxWaiters = maxWaiters;
+}
+
+uint32_t
+PendingFetchTable::GetSize() const
+{
+    return m_pending.size();
+}
+
+bool
+PendingFetchTable::IsPending(uint32_t id) const
+{
+    return m_pending.find(id) != m_pending.end();
+}
+
+PendingFetch*
+PendingFetchTable::Find(uint32_t id)
+{
+    auto it = m_pending.find(id);
+    return it != m_pending.end() ? &it->second : nullptr;
+}
+
+bool
+PendingFetchTable::AddFetch(uint32_t id, Time now)
+{
+    auto result = m_pending.emplace(id, PendingFetch());
+    if (!result.second)
+    {
+        return false;
+    }
+    result.first->second.start = now;
+    result.first->second.deadline = now;
+    result.first->second.retries = 0;
+    result.first->second.shed = 0;
+    result.first->second.backoff = false;
+    result.first->second.flags = 0;
+    return true;
+}
+
+bool
+PendingFetchTable::AddWaiter(uint32_t id, const Address& waiter, uint32_t seq)
+{
+    auto it = m_pending.find(id);
+    NS_ASSERT(it != m_pending.end());
+    std::vector<PendingWaiter>& waiters = it->second.waiters;
+    if (m_maxWaiters > 0 && waiters.size() >= m_maxWaiters)
+    {
+        return false;
+    }
+    waiters.push_back({waiter, seq});
+    return true;
+}
+
+bool
+PendingFetchTable::Complete(uint32_t id, PendingFetch& fetch)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end())
+    {
+        return false;
+    }
+    fetch = std::move(it->second);
+    m_pending.erase(it);
+    return true;
+}
+
+void
+PendingFetchTable::Clear()
+{
+    m_pending.clear();
+}
+
+} // namespace ns3
@@ -0,0 +1,108 @@
+#ifndef PENDING_FETCH_TABLE_H
+#define PENDING_FETCH_TABLE_H
+
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Client waiting for an object.
+ */
+struct PendingWaiter
+{
+    Address address; //!< Client address
+    uint32_t seq;    //!< Sequence number of the client request, 0 if unknown
+};
+
+/**
+ * \brief Origin request of an id that is still waiting for the response.
+ */
+struct PendingFetch
+{
+    Time start;                         //!< Send time of the origin request
+    Time deadline;                      //!< Time at which the origin request is retransmitted
+    uint32_t retries;                   //!< Retransmissions done so far
+    uint32_t shed;                      //!< Requests the content server shed so far
+    bool backoff;                       //!< Whether the deadline re-sends a shed request
+    uint16_t flags;                     //!< Flags of the origin request, sent again when shed
+    std::vector<PendingWaiter> waiters; //!< Clients to answer when the object arrives
+};
+
+/**
+ * \brief Outstanding origin requests of a cache, keyed by id.
+ *
+ * A miss on an id that is already being fetched only queues the client on
+ * the existing fetch, so a burst of requests for the same object produces a
+ * single origin request. Every operation is O(1) on average.
+ */
+class PendingFetchTable
+{
+  public:
+    PendingFetchTable();
+
+    /**
+     * \param maxWaiters clients that can wait on one fetch, 0 for no limit
+     */
+    void SetMaxWaiters(uint32_t maxWaiters);
+
+    /**
+     * \return the number of ids being fetched
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \param id the object id
+     * \return true if the id is being fetched
+     */
+    bool IsPending(uint32_t id) const;
+
+    /**
+     * \param id the object id
+     * \return the fetch of the id, nullptr if the id is not pending
+     */
+    PendingFetch* Find(uint32_t id);
+
+    /**
+     * \brief Record the origin request of an id, unless one is outstanding.
+     * \param id the object id
+     * \param now the current time
+     * \return true if the id was not pending and must be requested
+     */
+    bool AddFetch(uint32_t id, Time now);
+
+    /**
+     * \brief Queue a client on the fetch of an id, which must be pending.
+     * \param id the object id
+     * \param waiter the client address
+     * \param seq the sequence number of the client request, 0 if unknown
+     * \return false if the fetch already has the maximum number of waiters
+     */
+    bool AddWaiter(uint32_t id, const Address& waiter, uint32_t seq);
+
+    /**
+     * \brief Remove the fetch of an id once its response arrived.
+     * \param id the object id
+     * \param[out] fetch the removed fetch
+     * \return false if the id was not pending
+     */
+    bool Complete(uint32_t id, PendingFetch& fetch);
+
+    /**
+     * \brief Forget every pending fetch.
+     */
+    void Clear();
+
+  private:
+    std::unordered_map<uint32_t, PendingFetch> m_pending; //!< Fetches by id
+    uint32_t m_maxWaiters; //!< Clients that can wait on one fetch, 0 for no limit
+};
+
+} // namespace ns3
+
+#endif /* PENDING_FETCH_TABLE_H */
@@ -0,0 +1,204 @@
+#include "popularity-sampler.h"
+
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PopularitySampler");
+
+namespace
+{
+
+/**
+ * \param x a real number
+ * \return log(1 + x) / x, accurate also near 0
+ */
+inline double
+Helper1(double x)
+{
+    if (std::abs(x) > 1e-8)
+    {
+        return std::log1p(x) / x;
+    }
+    return 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+/**
+ * \param x a real number
+ * \return (exp(x) - 1) / x, accurate also near 0
+ */
+inline double
+Helper2(double x)
+{
+    if (std::abs(x) > 1e-8)
+    {
+        return std::expm1(x) / x;
+    }
+    return 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+} // namespace
+
+PopularitySampler::PopularitySampler()
+    : m_distribution(ZIPF),
+      m_catalogueSize(0),
+      m_alpha(0),
+      m_shift(0),
+      m_hIntegralX1(0),
+      m_hIntegralN(0),
+      m_squeeze(0)
+{
+}
+
+void
+PopularitySampler::ConfigureZipf(uint32_t catalogueSize, double alpha, double shift)
+{
+    NS_ASSERT_MSG(catalogueSize > 0, "A Zipf catalogue needs at least one id");
+    NS_ASSERT_MSG(alpha >= 0 && shift >= 0, "Zipf needs a non-negative exponent and shift");
+    m_distribution = shift > 0 ? ZIPF_MANDELBROT : ZIPF;
+    m_catalogueSize = catalogueSize;
+    m_alpha = alpha;
+    m_shift = shift;
+    m_hIntegralX1 = HIntegral(1.5) - H(1);
+    m_hIntegralN = HIntegral(catalogueSize + 0.5);
+    m_squeeze = 2 - HIntegralInverse(HIntegral(2.5) - H(2));
+    m_ids.clear();
+    m_prob.clear();
+    m_alias.clear();
+}
+
+void
+PopularitySampler::ConfigureFile(const std::string& fileName)
+{
+    std::ifstream pmf(fileName);
+    if (!pmf.is_open())
+    {
+        NS_FATAL_ERROR("Failed to open popularity file " << fileName);
+    }
+    m_ids.clear();
+    std::vector<double> weights;
+    double total = 0;
+    std::string line;
+    while (std::getline(pmf, line))
+    {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        uint32_t id;
+        double weight;
+        if (fields >> id >> weight && weight > 0)
+        {
+            m_ids.push_back(id);
+            weights.push_back(weight);
+            total += weight;
+        }
+    }
+    if (m_ids.empty())
+    {
+        NS_FATAL_ERROR("No id with a positive weight in popularity file " << fileName);
+    }
+
+    // Vose: entries above the mean give their excess to the entries below it
+    uint32_t n = m_ids.size();
+    m_prob.assign(n, 1);
+    m_alias.resize(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        weights[i] *= n / total;
+        m_alias[i] = i;
+        (weights[i] < 1 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t less = small.back();
+        uint32_t more = large.back();
+        small.pop_back();
+        m_prob[less] = weights[less];
+        m_alias[less] = more;
+        weights[more] -= 1 - weights[less];
+        if (weights[more] < 1)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // what is left is 1 up to rounding errors
+    m_distribution = FILE_PMF;
+    NS_LOG_INFO("Read the weights of " << n << " ids from " << fileName);
+}
+
+PopularitySampler::Distribution
+PopularitySampler::GetDistribution() const
+{
+    return m_distribution;
+}
+
+uint32_t
+PopularitySampler::GetCatalogueSize() const
+{
+    return m_distribution == FILE_PMF ? m_ids.size() : m_catalogueSize;
+}
+
+uint32_t
+PopularitySampler::Sample(const Ptr<UniformRandomVariable>& rng) const
+{
+    return m_distribution == FILE_PMF ? SampleAlias(rng) : SampleZipf(rng);
+}
+
+double
+PopularitySampler::H(double x) const
+{
+    return std::exp(-m_alpha * std::log(x + m_shift));
+}
+
+double
+PopularitySampler::HIntegral(double x) const
+{
+    // ((x + q)^(1 - alpha) - 1) / (1 - alpha), log(x + q) for alpha = 1
+    double logX = std::log(x + m_shift);
+    return Helper2((1 - m_alpha) * logX) * logX;
+}
+
+double
+PopularitySampler::HIntegralInverse(double x) const
+{
+    double t = std::max(-1.0, x * (1 - m_alpha));
+    return std::exp(Helper1(t) * x) - m_shift;
+}
+
+uint32_t
+PopularitySampler::SampleZipf(const Ptr<UniformRandomVariable>& rng) const
+{
+    NS_ASSERT_MSG(m_catalogueSize > 0, "Sampling an unconfigured distribution");
+    while (true)
+    {
+        // uniform on the area under the hat, mapped back to the support
+        double u = m_hIntegralN + rng->GetValue() * (m_hIntegralX1 - m_hIntegralN);
+        double x = HIntegralInverse(u);
+        double k = std::min<double>(std::max(1.0, std::floor(x + 0.5)), m_catalogueSize);
+        // the squeeze accepts most draws without evaluating the hat
+        if (k - x <= m_squeeze || u >= HIntegral(k + 0.5) - H(k))
+        {
+            return static_cast<uint32_t>(k);
+        }
+    }
+}
+
+uint32_t
+PopularitySampler::SampleAlias(const Ptr<UniformRandomVariable>& rng) const
+{
+    // the integer part picks the entry, the fraction chooses it or its alias
+    double x = rng->GetValue() * m_ids.size();
+    uint32_t entry = std::min<uint32_t>(static_cast<uint32_t>(x), m_ids.size() - 1);
+    return m_ids[x - entry < m_prob[entry] ? entry : m_alias[entry]];
+}
+
+} // namespace ns3
@@ -0,0 +1,116 @@
+#ifndef POPULARITY_SAMPLER_H
+#define POPULARITY_SAMPLER_H
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Draws the object ids of requests from a popularity distribution.
+ *
+ * Zipf and Zipf-Mandelbrot give id k, for k from 1 to the catalogue size,
+ * a probability proportional to 1 / (k + q)^alpha, with q = 0 for Zipf. They
+ * are sampled by rejection-inversion (Hoermann and Derflinger, 1996), with a
+ * few constants computed once, so catalogues of 10^8 ids take no memory and
+ * a draw costs less than two uniforms on average, for any alpha.
+ *
+ * A custom distribution is read from a file of "id weight" lines and sampled
+ * with the alias method (Walker, with Vose's construction): one table entry
+ * per id, and one uniform per draw.
+ *
+ * Draws take their uniforms from the ns-3 stream they are given, and never
+ * allocate.
+ */
+class PopularitySampler
+{
+  public:
+    /// Distribution of the ids
+    enum Distribution
+    {
+        ZIPF,            //!< 1 / k^alpha
+        ZIPF_MANDELBROT, //!< 1 / (k + q)^alpha
+        FILE_PMF,        //!< Weights read from a file
+    };
+
+    PopularitySampler();
+
+    /**
+     * \brief Sample Zipf or Zipf-Mandelbrot ids.
+     * \param catalogueSize the number of ids, from 1 to catalogueSize
+     * \param alpha the exponent, 0 for uniform ids
+     * \param shift the Zipf-Mandelbrot q, 0 for Zipf
+     */
+    void ConfigureZipf(uint32_t catalogueSize, double alpha, double shift = 0);
+
+    /**
+     * \brief Sample the ids of a file, replacing the distribution.
+     * \param fileName a file with one "id weight" line per id, '#' starting a comment
+     */
+    void ConfigureFile(const std::string& fileName);
+
+    /**
+     * \return the distribution configured last
+     */
+    Distribution GetDistribution() const;
+
+    /**
+     * \return the number of ids that can be drawn
+     */
+    uint32_t GetCatalogueSize() const;
+
+    /**
+     * \param rng the stream of the uniforms
+     * \return a random id
+     */
+    uint32_t Sample(const Ptr<UniformRandomVariable>& rng) const;
+
+  private:
+    /**
+     * \param x a point of the support
+     * \return the hat function, (x + q)^-alpha
+     */
+    double H(double x) const;
+
+    /**
+     * \param x a point of the support
+     * \return an antiderivative of the hat function
+     */
+    double HIntegral(double x) const;
+
+    /**
+     * \param x a value of HIntegral
+     * \return the point where HIntegral is x
+     */
+    double HIntegralInverse(double x) const;
+
+    /**
+     * \return a draw of the Zipf or Zipf-Mandelbrot distribution
+     */
+    uint32_t SampleZipf(const Ptr<UniformRandomVariable>& rng) const;
+
+    /**
+     * \return a draw of the alias table
+     */
+    uint32_t SampleAlias(const Ptr<UniformRandomVariable>& rng) const;
+
+    Distribution m_distribution; //!< Distribution configured last
+    uint32_t m_catalogueSize;    //!< Ids of Zipf and Zipf-Mandelbrot
+    double m_alpha;              //!< Zipf exponent
+    double m_shift;              //!< Zipf-Mandelbrot q
+    double m_hIntegralX1;        //!< HIntegral(1.5) - H(1), lower end of the inverted uniforms
+    double m_hIntegralN;         //!< HIntegral(catalogueSize + 0.5), upper end of the inverted uniforms
+    double m_squeeze;            //!< Distance under which a draw is accepted without a test
+    std::vector<uint32_t> m_ids;   //!< Ids of the file, by table entry
+    std::vector<double> m_prob;    //!< Probability of keeping the entry drawn instead of its alias
+    std::vector<uint32_t> m_alias; //!< Alias of each entry
+};
+
+} // namespace ns3
+
+#endif /* POPULARITY_SAMPLER_H */
@@ -0,0 +1,436 @@
+#include "prefetch-engine.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+PrefetchPredictor::~PrefetchPredictor()
+{
+}
+
+NeighbourPrefetchPredictor::NeighbourPrefetchPredictor(uint32_t distance)
+    : m_distance(distance)
+{
+}
+
+std::string
+NeighbourPrefetchPredictor::GetName() const
+{
+    return "NEIGHBOUR";
+}
+
+void
+NeighbourPrefetchPredictor::RecordAccess(uint32_t /* id */)
+{
+}
+
+void
+NeighbourPrefetchPredictor::Predict(uint32_t id, std::vector<uint32_t>& candidates)
+{
+    for (uint32_t d = 1; d <= m_distance; d++)
+    {
+        if (id > d)
+        {
+            candidates.push_back(id - d);
+        }
+        if (id <= UINT32_MAX - d)
+        {
+            candidates.push_back(id + d);
+        }
+    }
+}
+
+StridePrefetchPredictor::StridePrefetchPredictor(uint32_t depth)
+    : m_depth(depth),
+      m_last(-1),
+      m_stride(0),
+      m_confidence(0)
+{
+}
+
+std::string
+StridePrefetchPredictor::GetName() const
+{
+    return "STRIDE";
+}
+
+void
+StridePrefetchPredictor::RecordAccess(uint32_t id)
+{
+    if (m_last >= 0)
+    {
+        int64_t stride = int64_t(id) - m_last;
+        if (stride == m_stride)
+        {
+            m_confidence = std::min<uint32_t>(m_confidence + 1, 3);
+        }
+        else if (m_confidence > 0)
+        {
+            m_confidence--;
+        }
+        else
+        {
+            m_stride = stride;
+        }
+    }
+    m_last = id;
+}
+
+void
+StridePrefetchPredictor::Predict(uint32_t id, std::vector<uint32_t>& candidates)
+{
+    if (m_confidence == 0 || m_stride == 0)
+    {
+        return;
+    }
+    int64_t next = id;
+    for (uint32_t k = 0; k < m_depth; k++)
+    {
+        next += m_stride;
+        if (next < 0 || next > UINT32_MAX)
+        {
+            break;
+        }
+        candidates.push_back(next);
+    }
+}
+
+MarkovPrefetchPredictor::MarkovPrefetchPredictor(uint32_t maxEntries)
+    : m_order(maxEntries),
+      m_last(-1)
+{
+}
+
+std::string
+MarkovPrefetchPredictor::GetName() const
+{
+    return "MARKOV";
+}
+
+void
+MarkovPrefetchPredictor::RecordAccess(uint32_t id)
+{
+    if (m_last >= 0 && m_last != id)
+    {
+        auto it = m_table.find(m_last);
+        if (it == m_table.end())
+        {
+            uint32_t evicted;
+            if (m_order.Insert(m_last, &evicted))
+            {
+                m_table.erase(evicted);
+            }
+            it = m_table.emplace(m_last, Successors()).first;
+        }
+
+        Successors& successors = it->second;
+        uint32_t slot = 0;
+        for (uint32_t i = 0; i < SUCCESSORS; i++)
+        {
+            if (successors.counts[i] > 0 && successors.ids[i] == id)
+            {
+                slot = i;
+                break;
+            }
+            if (successors.counts[i] < successors.counts[slot])
+            {
+                slot = i;
+            }
+        }
+        if (successors.counts[slot] > 0 && successors.ids[slot] == id)
+        {
+            successors.counts[slot]++;
+        }
+        else
+        {
+            successors.ids[slot] = id;
+            successors.counts[slot] = 1;
+        }
+    }
+    m_last = id;
+}
+
+void
+MarkovPrefetchPredictor::Predict(uint32_t id, std::vector<uint32_t>& candidates)
+{
+    auto it = m_table.find(id);
+    if (it == m_table.end())
+    {
+        return;
+    }
+    Successors successors = it->second;
+    while (true)
+    {
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < SUCCESSORS; i++)
+        {
+            if (successors.counts[i] > successors.counts[best])
+            {
+                best = i;
+            }
+        }
+        if (successors.counts[best] == 0)
+        {
+            break;
+        }
+        candidates.push_back(successors.ids[best]);
+        successors.counts[best] = 0;
+    }
+}
+
+PopularityPrefetchPredictor::PopularityPrefetchPredictor(uint32_t counters)
+    : m_counters(counters)
+{
+}
+
+std::string
+PopularityPrefetchPredictor::GetName() const
+{
+    return "POPULARITY";
+}
+
+void
+PopularityPrefetchPredictor::RecordAccess(uint32_t id)
+{
+    uint32_t pos;
+    auto it = m_index.find(id);
+    if (it != m_index.end())
+    {
+        pos = it->second;
+        m_top[pos].first++;
+    }
+    else if (m_top.size() < m_counters)
+    {
+        pos = m_top.size();
+        m_top.emplace_back(1, id);
+        m_index.emplace(id, pos);
+    }
+    else
+    {
+        // m_top is sorted by decreasing count: the last id has the smallest count
+        pos = m_top.size() - 1;
+        m_index.erase(m_top[pos].second);
+        m_top[pos] = std::make_pair(m_top[pos].first + 1, id);
+        m_index.emplace(id, pos);
+    }
+
+    while (pos > 0 && m_top[pos - 1].first < m_top[pos].first)
+    {
+        std::swap(m_top[pos - 1], m_top[pos]);
+        m_index[m_top[pos].second] = pos;
+        m_index[m_top[pos - 1].second] = pos - 1;
+        pos--;
+    }
+}
+
+void
+PopularityPrefetchPredictor::Predict(uint32_t /* id */, std::vector<uint32_t>& candidates)
+{
+    for (const auto& entry : m_top)
+    {
+        candidates.push_back(entry.second);
+    }
+}
+
+PrefetchEngine::PrefetchEngine()
+    : m_predictor(nullptr),
+      m_catalogueSize(0),
+      m_maxDegree(0),
+      m_degree(0),
+      m_adaptive(false),
+      m_budget(0),
+      m_tokens(0),
+      m_triggers(0),
+      m_issued(0),
+      m_useful(0),
+      m_wasted(0),
+      m_demandMisses(0),
+      m_windowUseful(0),
+      m_windowWasted(0),
+      m_windowMisses(0)
+{
+}
+
+void
+PrefetchEngine::Configure(PredictorType type,
+                          uint32_t catalogueSize,
+                          uint32_t maxDegree,
+                          uint32_t budget,
+                          bool adaptive,
+                          uint32_t tableSize)
+{
+    switch (type)
+    {
+    case NEIGHBOUR:
+        m_predictor = Create<NeighbourPrefetchPredictor>((maxDegree + 1) / 2);
+        break;
+    case STRIDE:
+        m_predictor = Create<StridePrefetchPredictor>(maxDegree);
+        break;
+    case MARKOV:
+        m_predictor = Create<MarkovPrefetchPredictor>(std::max<uint32_t>(tableSize, 1));
+        break;
+    case POPULARITY:
+        m_predictor = Create<PopularityPrefetchPredictor>(std::max<uint32_t>(64, 4 * maxDegree));
+        break;
+    default:
+        m_predictor = nullptr;
+        break;
+    }
+    m_catalogueSize = catalogueSize;
+    m_maxDegree = maxDegree;
+    m_degree = maxDegree;
+    m_adaptive = adaptive;
+    m_budget = budget;
+    m_tokens = std::max(1.0, m_budget);
+    m_lastRefill = Time();
+    m_triggers = 0;
+    m_unused.clear();
+    m_issued = 0;
+    m_useful = 0;
+    m_wasted = 0;
+    m_demandMisses = 0;
+    m_windowUseful = 0;
+    m_windowWasted = 0;
+    m_windowMisses = 0;
+}
+
+bool
+PrefetchEngine::IsEnabled() const
+{
+    return m_predictor != nullptr;
+}
+
+bool
+PrefetchEngine::RecordAccess(uint32_t id, bool hit)
+{
+    m_predictor->RecordAccess(id);
+    if (m_unused.erase(id) > 0)
+    {
+        m_useful++;
+        m_windowUseful++;
+        Adapt();
+        return true;
+    }
+    if (!hit)
+    {
+        m_demandMisses++;
+        m_windowMisses++;
+    }
+    return false;
+}
+
+uint32_t
+PrefetchEngine::NextDegree()
+{
+    if (m_degree > 0)
+    {
+        return m_degree;
+    }
+    m_triggers++;
+    return m_triggers % PROBE_PERIOD == 0 ? 1 : 0;
+}
+
+void
+PrefetchEngine::Predict(uint32_t id, std::vector<uint32_t>& candidates)
+{
+    candidates.clear();
+    m_predictor->Predict(id, candidates);
+    candidates.erase(std::remove_if(candidates.begin(),
+                                    candidates.end(),
+                                    [this, id](uint32_t candidate) {
+                                        return candidate == 0 || candidate > m_catalogueSize ||
+                                               candidate == id;
+                                    }),
+                     candidates.end());
+}
+
+bool
+PrefetchEngine::ConsumeBudget(Time now)
+{
+    if (m_budget == 0)
+    {
+        return true;
+    }
+    m_tokens = std::min(std::max(1.0, m_budget),
+                        m_tokens + (now - m_lastRefill).GetSeconds() * m_budget);
+    m_lastRefill = now;
+    if (m_tokens < 1)
+    {
+        return false;
+    }
+    m_tokens -= 1;
+    return true;
+}
+
+void
+PrefetchEngine::RecordIssued(uint32_t id)
+{
+    m_issued++;
+    m_unused.insert(id);
+}
+
+void
+PrefetchEngine::RecordDiscarded(uint32_t id)
+{
+    if (m_unused.erase(id) > 0)
+    {
+        m_wasted++;
+        m_windowWasted++;
+        Adapt();
+    }
+}
+
+uint32_t
+PrefetchEngine::GetIssued() const
+{
+    return m_issued;
+}
+
+uint32_t
+PrefetchEngine::GetUseful() const
+{
+    return m_useful;
+}
+
+double
+PrefetchEngine::GetAccuracy() const
+{
+    uint32_t resolved = m_useful + m_wasted;
+    return resolved > 0 ? double(m_useful) / resolved : 0;
+}
+
+double
+PrefetchEngine::GetCoverage() const
+{
+    uint32_t misses = m_useful + m_demandMisses;
+    return misses > 0 ? double(m_useful) / misses : 0;
+}
+
+void
+PrefetchEngine::Adapt()
+{
+    if (m_windowUseful + m_windowWasted < ADAPT_INTERVAL)
+    {
+        return;
+    }
+    if (m_adaptive)
+    {
+        double accuracy = double(m_windowUseful) / (m_windowUseful + m_windowWasted);
+        double coverage = double(m_windowUseful) / (m_windowUseful + m_windowMisses);
+        if (accuracy >= 0.6)
+        {
+            m_degree = std::min(m_degree + 1, m_maxDegree);
+        }
+        else if ((accuracy < 0.3 || coverage < 0.05) && m_degree > 0)
+        {
+            m_degree--;
+        }
+    }
+    m_windowUseful = 0;
+    m_windowWasted = 0;
+    m_windowMisses = 0;
+}
+
+} // namespace ns3
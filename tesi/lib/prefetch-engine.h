@@ -0,0 +1,287 @@
+#ifndef PREFETCH_ENGINE_H
+#define PREFETCH_ENGINE_H
+
+#include "cache-store.h"
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Guesses which ids will be requested next from the access stream.
+ */
+class PrefetchPredictor : public SimpleRefCount<PrefetchPredictor>
+{
+  public:
+    virtual ~PrefetchPredictor();
+
+    /**
+     * \return the name of the predictor
+     */
+    virtual std::string GetName() const = 0;
+
+    /**
+     * \brief Learn from a client request.
+     * \param id the requested id
+     */
+    virtual void RecordAccess(uint32_t id) = 0;
+
+    /**
+     * \brief Append the ids likely to follow a request, most likely first.
+     * \param id the requested id
+     * \param[out] candidates the predicted ids, possibly out of the catalogue
+     */
+    virtual void Predict(uint32_t id, std::vector<uint32_t>& candidates) = 0;
+};
+
+/**
+ * \brief The ids closest to the requested one, alternating below and above.
+ */
+class NeighbourPrefetchPredictor final : public PrefetchPredictor
+{
+  public:
+    /**
+     * \param distance the largest distance from the requested id
+     */
+    explicit NeighbourPrefetchPredictor(uint32_t distance);
+
+    std::string GetName() const override;
+    void RecordAccess(uint32_t id) override;
+    void Predict(uint32_t id, std::vector<uint32_t>& candidates) override;
+
+  private:
+    uint32_t m_distance; //!< Largest distance from the requested id
+};
+
+/**
+ * \brief Constant-stride detector over the request stream.
+ *
+ * A stride must be seen on two consecutive pairs of requests before it is
+ * trusted; predictions then continue it from the requested id.
+ */
+class StridePrefetchPredictor final : public PrefetchPredictor
+{
+  public:
+    /**
+     * \param depth the number of strides predicted ahead
+     */
+    explicit StridePrefetchPredictor(uint32_t depth);
+
+    std::string GetName() const override;
+    void RecordAccess(uint32_t id) override;
+    void Predict(uint32_t id, std::vector<uint32_t>& candidates) override;
+
+  private:
+    uint32_t m_depth;      //!< Strides predicted ahead
+    int64_t m_last;        //!< Previous request, -1 before the first
+    int64_t m_stride;      //!< Candidate stride
+    uint32_t m_confidence; //!< Consecutive repetitions of m_stride, saturating at 3
+};
+
+/**
+ * \brief First-order Markov model: the most frequent successors of each id.
+ *
+ * Each id keeps up to SUCCESSORS successor counters, the least counted one
+ * being replaced by a new successor. The table is bounded, ids being
+ * forgotten in FIFO order.
+ */
+class MarkovPrefetchPredictor final : public PrefetchPredictor
+{
+  public:
+    /**
+     * \param maxEntries the number of ids whose successors are tracked
+     */
+    explicit MarkovPrefetchPredictor(uint32_t maxEntries);
+
+    std::string GetName() const override;
+    void RecordAccess(uint32_t id) override;
+    void Predict(uint32_t id, std::vector<uint32_t>& candidates) override;
+
+  private:
+    static constexpr uint32_t SUCCESSORS = 4; //!< Successors tracked per id
+
+    /// Successor counters of an id
+    struct Successors
+    {
+        uint32_t ids[SUCCESSORS];    //!< Successor ids
+        uint32_t counts[SUCCESSORS]; //!< Times each successor followed, 0 for free slots
+    };
+
+    std::unordered_map<uint32_t, Successors> m_table; //!< Successors by id
+    CacheStore m_order; //!< Ids of m_table, oldest first
+    int64_t m_last;     //!< Previous request, -1 before the first
+};
+
+/**
+ * \brief The most requested ids, tracked with the Space-Saving algorithm.
+ *
+ * Predictions do not depend on the requested id: they are the heavy hitters
+ * in decreasing count order, so a cold cache warms up with them first.
+ */
+class PopularityPrefetchPredictor final : public PrefetchPredictor
+{
+  public:
+    /**
+     * \param counters the number of heavy hitters tracked
+     */
+    explicit PopularityPrefetchPredictor(uint32_t counters);
+
+    std::string GetName() const override;
+    void RecordAccess(uint32_t id) override;
+    void Predict(uint32_t id, std::vector<uint32_t>& candidates) override;
+
+  private:
+    uint32_t m_counters;                          //!< Heavy hitters tracked
+    std::vector<std::pair<uint32_t, uint32_t>> m_top; //!< (count, id) of the tracked ids
+    std::unordered_map<uint32_t, uint32_t> m_index; //!< Position in m_top by id
+};
+
+/**
+ * \brief Prefetch controller of the cache server.
+ *
+ * Wraps a predictor with the catalogue bounds, a token bucket limiting the
+ * prefetches per second, and feedback-directed throttling: a prefetched id
+ * is useful if a client asks for it before it leaves the cache, wasted
+ * otherwise. Every ADAPT_INTERVAL resolved prefetches the degree (ids
+ * prefetched per trigger) is raised when accuracy is high and lowered when
+ * accuracy or coverage is low. At degree 0 a single probe prefetch is still
+ * issued every PROBE_PERIOD triggers, so the engine can recover when the
+ * workload changes.
+ */
+class PrefetchEngine
+{
+  public:
+    /// Predictors available to the engine
+    enum PredictorType
+    {
+        NONE,
+        NEIGHBOUR,
+        STRIDE,
+        MARKOV,
+        POPULARITY,
+    };
+
+    PrefetchEngine();
+
+    /**
+     * \brief Select the predictor and reset the statistics.
+     * \param type the predictor, NONE disables prefetching
+     * \param catalogueSize ids are valid in [1, catalogueSize]
+     * \param maxDegree the largest number of ids prefetched per trigger
+     * \param budget prefetches allowed per second, 0 for no limit
+     * \param adaptive whether the degree follows accuracy and coverage
+     * \param tableSize ids tracked by the Markov predictor
+     */
+    void Configure(PredictorType type,
+                   uint32_t catalogueSize,
+                   uint32_t maxDegree,
+                   uint32_t budget,
+                   bool adaptive,
+                   uint32_t tableSize);
+
+    /**
+     * \return true if a predictor is configured
+     */
+    bool IsEnabled() const;
+
+    /**
+     * \brief Train the predictor and account the request.
+     * \param id the requested id
+     * \param hit whether the id was resident
+     * \return true if the id had been prefetched and not yet requested
+     */
+    bool RecordAccess(uint32_t id, bool hit);
+
+    /**
+     * \brief Number of prefetches allowed for the current trigger.
+     * \return the degree, or the probe
+     */
+    uint32_t NextDegree();
+
+    /**
+     * \brief Predicted ids within the catalogue, most likely first.
+     * \param id the requested id
+     * \param[out] candidates the predicted ids, replaced
+     */
+    void Predict(uint32_t id, std::vector<uint32_t>& candidates);
+
+    /**
+     * \brief Take a token from the budget.
+     * \param now the current time
+     * \return false if the budget of the current second is exhausted
+     */
+    bool ConsumeBudget(Time now);
+
+    /**
+     * \brief Record that a predicted id was requested to the origin.
+     * \param id the prefetched id
+     */
+    void RecordIssued(uint32_t id);
+
+    /**
+     * \brief Record that an id left the cache or was never stored.
+     * \param id the id, ignored unless prefetched and not yet requested
+     */
+    void RecordDiscarded(uint32_t id);
+
+    /**
+     * \return the number of prefetches issued
+     */
+    uint32_t GetIssued() const;
+
+    /**
+     * \return the number of prefetched ids later requested by a client
+     */
+    uint32_t GetUseful() const;
+
+    /**
+     * \return the fraction of resolved prefetches that were useful
+     */
+    double GetAccuracy() const;
+
+    /**
+     * \return the fraction of would-be misses avoided or shortened by prefetching
+     */
+    double GetCoverage() const;
+
+  private:
+    static constexpr uint32_t ADAPT_INTERVAL = 32; //!< Resolved prefetches between two adaptations
+    static constexpr uint32_t PROBE_PERIOD = 16;   //!< Triggers between two probes at degree 0
+
+    /**
+     * \brief Resize the degree from the feedback of the last interval.
+     */
+    void Adapt();
+
+    Ptr<PrefetchPredictor> m_predictor; //!< Predictor, null if disabled
+    uint32_t m_catalogueSize;           //!< Largest valid id
+    uint32_t m_maxDegree;               //!< Largest degree
+    uint32_t m_degree;                  //!< Current degree
+    bool m_adaptive;                    //!< Whether the degree adapts
+    double m_budget;                    //!< Prefetches per second, 0 for no limit
+    double m_tokens;                    //!< Prefetches left in the bucket
+    Time m_lastRefill;                  //!< Last refill of the bucket
+    uint32_t m_triggers;                //!< Triggers seen at degree 0
+    std::unordered_set<uint32_t> m_unused; //!< Prefetched ids not yet requested
+
+    uint32_t m_issued;         //!< Prefetches issued
+    uint32_t m_useful;         //!< Prefetched ids later requested
+    uint32_t m_wasted;         //!< Prefetched ids discarded before any request
+    uint32_t m_demandMisses;   //!< Misses on ids that were not prefetched
+    uint32_t m_windowUseful;   //!< m_useful in the current interval
+    uint32_t m_windowWasted;   //!< m_wasted in the current interval
+    uint32_t m_windowMisses;   //!< m_demandMisses in the current interval
+};
+
+} // namespace ns3
+
+#endif /* PREFETCH_ENGINE_H */
@@ -0,0 +1,427 @@
+#include "slab-storage.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3
+{
+
+SlabStorage::SlabStorage()
+    : m_capacity(0),
+      m_pageSize(0),
+      m_rebalance(false),
+      m_pageCount(0),
+      m_nextPage(0),
+      m_emptyPages(0),
+      m_storedBytes(0),
+      m_evictions(0),
+      m_pagesMoved(0)
+{
+}
+
+void
+SlabStorage::Configure(uint64_t capacity,
+                       uint32_t pageSize,
+                       uint32_t minChunk,
+                       double growthFactor,
+                       bool rebalance)
+{
+    m_items.clear();
+    m_classes.clear();
+    m_arena.reset();
+    m_pageClass.clear();
+    m_pageItems.clear();
+    m_pageCount = 0;
+    m_nextPage = 0;
+    m_emptyPages = 0;
+    m_storedBytes = 0;
+    m_evictions = 0;
+    m_pagesMoved = 0;
+    m_pageSize = pageSize;
+    m_rebalance = rebalance;
+    if (capacity == 0)
+    {
+        m_capacity = 0;
+        return;
+    }
+    NS_ASSERT_MSG(pageSize > ITEM_HEADER, "Page size " << pageSize << " smaller than an item header");
+    NS_ASSERT_MSG(growthFactor > 1, "Slab growth factor must be larger than 1");
+
+    m_pageCount = std::max<uint64_t>(capacity / pageSize, 1);
+    m_capacity = uint64_t(m_pageCount) * pageSize;
+    // not value-initialized: the pages only become resident once written
+    m_arena.reset(new uint8_t[m_capacity]);
+    m_pageClass.assign(m_pageCount, NO_CLASS);
+    m_pageItems.assign(m_pageCount, 0);
+
+    // 8-byte aligned chunk sizes growing by growthFactor, the last class taking a whole page
+    uint32_t chunkSize = (std::max(minChunk, ITEM_HEADER + 1) + 7) & ~7u;
+    while (chunkSize <= pageSize / 2)
+    {
+        auto cls = std::make_unique<SlabClass>();
+        cls->chunkSize = chunkSize;
+        cls->perPage = pageSize / chunkSize;
+        m_classes.push_back(std::move(cls));
+        uint32_t next = (static_cast<uint32_t>(chunkSize * growthFactor) + 7) & ~7u;
+        chunkSize = std::max(next, chunkSize + 8);
+    }
+    auto largest = std::make_unique<SlabClass>();
+    largest->chunkSize = pageSize;
+    largest->perPage = 1;
+    m_classes.push_back(std::move(largest));
+
+    for (auto& cls : m_classes)
+    {
+        cls->storedBytes = 0;
+        cls->evictions = 0;
+        cls->windowEvictions = 0;
+        cls->pagesMoved = 0;
+    }
+}
+
+bool
+SlabStorage::IsEnabled() const
+{
+    return m_capacity > 0;
+}
+
+uint64_t
+SlabStorage::GetCapacity() const
+{
+    return m_capacity;
+}
+
+uint32_t
+SlabStorage::GetMaxItems() const
+{
+    return m_classes.empty() ? 0 : m_pageCount * m_classes.front()->perPage;
+}
+
+uint32_t
+SlabStorage::GetClassCount() const
+{
+    return m_classes.size();
+}
+
+SlabStorage::ClassStats
+SlabStorage::GetClassStats(uint32_t cls) const
+{
+    const SlabClass& c = *m_classes[cls];
+    ClassStats stats;
+    stats.chunkSize = c.chunkSize;
+    stats.pages = c.pages.size();
+    stats.chunks = c.pages.size() * c.perPage;
+    stats.items = c.lru.GetSize();
+    stats.storedBytes = c.storedBytes;
+    stats.evictions = c.evictions;
+    stats.pagesMoved = c.pagesMoved;
+    return stats;
+}
+
+bool
+SlabStorage::Contains(uint32_t id) const
+{
+    return m_items.find(id) != m_items.end();
+}
+
+bool
+SlabStorage::Store(uint32_t id, uint32_t size, const uint8_t* data, std::vector<uint32_t>& evicted)
+{
+    NS_ASSERT(IsEnabled() && !Contains(id));
+    if (uint64_t(size) + ITEM_HEADER > m_pageSize)
+    {
+        return false;
+    }
+    uint32_t cls = ClassFor(size + ITEM_HEADER);
+    if (!MakeRoom(cls, evicted))
+    {
+        return false;
+    }
+
+    SlabClass& c = *m_classes[cls];
+    uint64_t chunk = c.freeList.back();
+    c.freeList.pop_back();
+    Item& item = m_items[id];
+    item.entry.id = id;
+    item.cls = cls;
+    item.page = static_cast<uint32_t>(chunk >> 32);
+    item.slot = static_cast<uint32_t>(chunk);
+    item.size = size;
+    c.lru.PushBack(&item.entry);
+    if (m_pageItems[item.page]++ == 0)
+    {
+        m_emptyPages--;
+    }
+
+    uint8_t* chunkData = ChunkData(item.page, cls, item.slot);
+    std::memset(chunkData, 0, ITEM_HEADER);
+    std::memcpy(chunkData, &id, sizeof(id));
+    std::memcpy(chunkData + sizeof(id), &size, sizeof(size));
+    if (data)
+    {
+        std::memcpy(chunkData + ITEM_HEADER, data, size);
+    }
+    else
+    {
+        std::memset(chunkData + ITEM_HEADER, 0, size);
+    }
+    c.storedBytes += size;
+    m_storedBytes += size;
+    return true;
+}
+
+void
+SlabStorage::Touch(uint32_t id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end())
+    {
+        return;
+    }
+    CacheEntryList& lru = m_classes[it->second.cls]->lru;
+    lru.Remove(&it->second.entry);
+    lru.PushBack(&it->second.entry);
+}
+
+const uint8_t*
+SlabStorage::Read(uint32_t id) const
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end())
+    {
+        return nullptr;
+    }
+    return ChunkData(it->second.page, it->second.cls, it->second.slot) + ITEM_HEADER;
+}
+
+bool
+SlabStorage::Remove(uint32_t id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end())
+    {
+        return false;
+    }
+    FreeItem(it);
+    return true;
+}
+
+uint64_t
+SlabStorage::GetStoredBytes() const
+{
+    return m_storedBytes;
+}
+
+uint64_t
+SlabStorage::GetAssignedBytes() const
+{
+    uint64_t pages = 0;
+    for (const auto& cls : m_classes)
+    {
+        pages += cls->pages.size();
+    }
+    return pages * m_pageSize;
+}
+
+double
+SlabStorage::GetFragmentation() const
+{
+    uint64_t assigned = GetAssignedBytes();
+    return assigned > 0 ? 1 - double(m_storedBytes) / assigned : 0;
+}
+
+uint64_t
+SlabStorage::GetEvictions() const
+{
+    return m_evictions;
+}
+
+uint32_t
+SlabStorage::GetPagesMoved() const
+{
+    return m_pagesMoved;
+}
+
+uint32_t
+SlabStorage::ClassFor(uint32_t size) const
+{
+    auto it = std::partition_point(m_classes.begin(),
+                                   m_classes.end(),
+                                   [size](const std::unique_ptr<SlabClass>& cls) {
+                                       return cls->chunkSize < size;
+                                   });
+    return it - m_classes.begin();
+}
+
+bool
+SlabStorage::MakeRoom(uint32_t cls, std::vector<uint32_t>& evicted)
+{
+    SlabClass& c = *m_classes[cls];
+    if (!c.freeList.empty())
+    {
+        return true;
+    }
+    if (m_nextPage < m_pageCount)
+    {
+        AssignPage(m_nextPage++, cls);
+        return true;
+    }
+
+    if (m_rebalance)
+    {
+        // a page emptied by removals is taken as is; the class in need has
+        // no empty page, or its free list would not be empty
+        if (m_emptyPages > 0)
+        {
+            for (uint32_t page = 0; page < m_pageCount; page++)
+            {
+                if (m_pageClass[page] != NO_CLASS && m_pageItems[page] == 0)
+                {
+                    ReleasePage(page, evicted);
+                    AssignPage(page, cls);
+                    c.pagesMoved++;
+                    m_pagesMoved++;
+                    return true;
+                }
+            }
+        }
+        if ((c.pages.empty() || c.windowEvictions >= REBALANCE_EVICTIONS) && MovePage(cls, evicted))
+        {
+            return true;
+        }
+    }
+
+    if (c.lru.IsEmpty())
+    {
+        return false;
+    }
+    auto victim = m_items.find(c.lru.Front()->id);
+    evicted.push_back(victim->first);
+    FreeItem(victim);
+    c.evictions++;
+    c.windowEvictions++;
+    m_evictions++;
+    return true;
+}
+
+void
+SlabStorage::AssignPage(uint32_t page, uint32_t cls)
+{
+    SlabClass& c = *m_classes[cls];
+    m_pageClass[page] = cls;
+    c.pages.push_back(page);
+    // pushed backwards, so the chunks are handed out in address order
+    for (uint32_t slot = c.perPage; slot-- > 0;)
+    {
+        c.freeList.push_back(uint64_t(page) << 32 | slot);
+    }
+    m_emptyPages++;
+}
+
+bool
+SlabStorage::MovePage(uint32_t cls, std::vector<uint32_t>& evicted)
+{
+    // the donor is the class evicting the least, and at least four times less
+    // than the class in need; the eviction counts then decay, so they follow
+    // the recent demand of each class
+    uint32_t needed = m_classes[cls]->windowEvictions;
+    uint32_t donor = NO_CLASS;
+    for (uint32_t d = 0; d < m_classes.size(); d++)
+    {
+        const SlabClass& candidate = *m_classes[d];
+        if (d == cls || candidate.pages.size() < 2 || 4 * candidate.windowEvictions >= needed)
+        {
+            continue;
+        }
+        if (donor == NO_CLASS || candidate.windowEvictions < m_classes[donor]->windowEvictions ||
+            (candidate.windowEvictions == m_classes[donor]->windowEvictions &&
+             candidate.pages.size() > m_classes[donor]->pages.size()))
+        {
+            donor = d;
+        }
+    }
+    for (auto& c : m_classes)
+    {
+        c->windowEvictions /= 2;
+    }
+    // a class without any page would never store anything: take from the largest class
+    if (donor == NO_CLASS && m_classes[cls]->pages.empty())
+    {
+        for (uint32_t d = 0; d < m_classes.size(); d++)
+        {
+            if (d != cls && !m_classes[d]->pages.empty() &&
+                (donor == NO_CLASS || m_classes[d]->pages.size() > m_classes[donor]->pages.size()))
+            {
+                donor = d;
+            }
+        }
+    }
+    if (donor == NO_CLASS)
+    {
+        return false;
+    }
+
+    // the page of the donor holding the fewest objects
+    const std::vector<uint32_t>& pages = m_classes[donor]->pages;
+    uint32_t page = *std::min_element(pages.begin(), pages.end(), [this](uint32_t a, uint32_t b) {
+        return m_pageItems[a] < m_pageItems[b];
+    });
+    ReleasePage(page, evicted);
+    AssignPage(page, cls);
+    m_classes[cls]->pagesMoved++;
+    m_pagesMoved++;
+    return true;
+}
+
+void
+SlabStorage::ReleasePage(uint32_t page, std::vector<uint32_t>& evicted)
+{
+    SlabClass& c = *m_classes[m_pageClass[page]];
+    for (CacheEntry* entry = c.lru.Front(); entry && m_pageItems[page] > 0;)
+    {
+        CacheEntry* next = c.lru.Next(entry);
+        auto it = m_items.find(entry->id);
+        if (it->second.page == page)
+        {
+            evicted.push_back(it->first);
+            FreeItem(it);
+            c.evictions++;
+            m_evictions++;
+        }
+        entry = next;
+    }
+
+    c.freeList.erase(std::remove_if(c.freeList.begin(),
+                                    c.freeList.end(),
+                                    [page](uint64_t chunk) { return (chunk >> 32) == page; }),
+                     c.freeList.end());
+    c.pages.erase(std::find(c.pages.begin(), c.pages.end(), page));
+    m_pageClass[page] = NO_CLASS;
+    m_emptyPages--;
+}
+
+void
+SlabStorage::FreeItem(std::unordered_map<uint32_t, Item>::iterator it)
+{
+    Item& item = it->second;
+    SlabClass& c = *m_classes[item.cls];
+    c.lru.Remove(&item.entry);
+    c.freeList.push_back(uint64_t(item.page) << 32 | item.slot);
+    c.storedBytes -= item.size;
+    m_storedBytes -= item.size;
+    if (--m_pageItems[item.page] == 0)
+    {
+        m_emptyPages++;
+    }
+    m_items.erase(it);
+}
+
+uint8_t*
+SlabStorage::ChunkData(uint32_t page, uint32_t cls, uint32_t slot) const
+{
+    return m_arena.get() + uint64_t(page) * m_pageSize + uint64_t(slot) * m_classes[cls]->chunkSize;
+}
+
+} // namespace ns3
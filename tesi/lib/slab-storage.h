@@ -0,0 +1,251 @@
+#ifndef SLAB_STORAGE_H
+#define SLAB_STORAGE_H
+
+#include "cache-store.h"
+
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Object memory of a cache, managed as memcached-style slabs.
+ *
+ * The memory is one arena cut into pages. A page is assigned to a size class
+ * on demand and cut into equal chunks; chunk sizes grow geometrically from
+ * the smallest one up to the page size. An object takes one chunk of the
+ * smallest class that fits it plus a per-item header, and the payload bytes
+ * are really written there, so internal fragmentation (chunk bytes not used
+ * by the object) and calcification (pages stuck in a class that no longer
+ * needs them) show up as they do in a real cache.
+ *
+ * Each class keeps a free list and an LRU list of its objects. When a class
+ * has no free chunk and no page is left, its least recently used object is
+ * evicted. With rebalancing, a class first takes a page nobody uses, and a
+ * class that keeps evicting takes a page from a class that evicts much less,
+ * evicting the objects on that page.
+ */
+class SlabStorage
+{
+  public:
+    /// Bytes in front of each stored value: id, size and list links
+    static constexpr uint32_t ITEM_HEADER = 48;
+
+    /// Occupancy of a size class
+    struct ClassStats
+    {
+        uint32_t chunkSize;   //!< Bytes per chunk
+        uint32_t pages;       //!< Pages assigned to the class
+        uint32_t chunks;      //!< Chunks in those pages
+        uint32_t items;       //!< Chunks holding an object
+        uint64_t storedBytes; //!< Object bytes held, headers excluded
+        uint64_t evictions;   //!< Objects evicted to make room in the class
+        uint32_t pagesMoved;  //!< Pages taken from other classes
+    };
+
+    SlabStorage();
+    SlabStorage(const SlabStorage&) = delete;
+    SlabStorage& operator=(const SlabStorage&) = delete;
+
+    /**
+     * \brief Allocate the arena and build the size classes, dropping every object.
+     * \param capacity arena size in bytes, 0 disables the storage
+     * \param pageSize page size in bytes, also the largest storable item
+     * \param minChunk chunk size of the smallest class
+     * \param growthFactor ratio between the chunk sizes of consecutive classes
+     * \param rebalance whether pages move between classes
+     */
+    void Configure(uint64_t capacity,
+                   uint32_t pageSize,
+                   uint32_t minChunk,
+                   double growthFactor,
+                   bool rebalance);
+
+    /**
+     * \return true if the storage has an arena
+     */
+    bool IsEnabled() const;
+
+    /**
+     * \return the arena size in bytes
+     */
+    uint64_t GetCapacity() const;
+
+    /**
+     * \return the largest number of objects the arena can hold
+     */
+    uint32_t GetMaxItems() const;
+
+    /**
+     * \return the number of size classes
+     */
+    uint32_t GetClassCount() const;
+
+    /**
+     * \param cls a size class
+     * \return the occupancy of the class
+     */
+    ClassStats GetClassStats(uint32_t cls) const;
+
+    /**
+     * \param id the object id
+     * \return true if the object is stored
+     */
+    bool Contains(uint32_t id) const;
+
+    /**
+     * \brief Write an object in a chunk of its class, making room if needed.
+     * \param id the object id, must not be stored yet
+     * \param size the object size in bytes
+     * \param data the object bytes, nullptr for zero bytes
+     * \param[out] evicted the ids evicted to make room are appended here
+     * \return false if no chunk can hold the object
+     */
+    bool Store(uint32_t id, uint32_t size, const uint8_t* data, std::vector<uint32_t>& evicted);
+
+    /**
+     * \brief Mark an object as the most recently used of its class.
+     * \param id the object id, ignored if not stored
+     */
+    void Touch(uint32_t id);
+
+    /**
+     * \param id the object id
+     * \return the object bytes, nullptr if not stored
+     */
+    const uint8_t* Read(uint32_t id) const;
+
+    /**
+     * \brief Free the chunk of an object.
+     * \param id the object id
+     * \return true if the object was stored
+     */
+    bool Remove(uint32_t id);
+
+    /**
+     * \return the object bytes held, headers excluded
+     */
+    uint64_t GetStoredBytes() const;
+
+    /**
+     * \return the bytes of the pages assigned to a class
+     */
+    uint64_t GetAssignedBytes() const;
+
+    /**
+     * \return the fraction of the assigned pages not holding object bytes
+     */
+    double GetFragmentation() const;
+
+    /**
+     * \return the number of objects evicted to make room
+     */
+    uint64_t GetEvictions() const;
+
+    /**
+     * \return the number of pages moved between classes
+     */
+    uint32_t GetPagesMoved() const;
+
+  private:
+    /// Recent evictions in a class that trigger a page move
+    static constexpr uint32_t REBALANCE_EVICTIONS = 64;
+    /// Marks a page not assigned to any class
+    static constexpr uint32_t NO_CLASS = UINT32_MAX;
+
+    /// Chunk holding an object
+    struct Item
+    {
+        CacheEntry entry; //!< Node in the LRU list of the class
+        uint32_t cls;     //!< Size class
+        uint32_t page;    //!< Page of the chunk
+        uint32_t slot;    //!< Chunk within the page
+        uint32_t size;    //!< Object size
+    };
+
+    /// Size class
+    struct SlabClass
+    {
+        uint32_t chunkSize;             //!< Bytes per chunk, header included
+        uint32_t perPage;               //!< Chunks per page
+        std::vector<uint64_t> freeList; //!< Free chunks, as page << 32 | slot
+        std::vector<uint32_t> pages;    //!< Pages of the class
+        CacheEntryList lru;             //!< Objects, least recently used first
+        uint64_t storedBytes;           //!< Object bytes held
+        uint64_t evictions;             //!< Objects evicted to make room
+        uint32_t windowEvictions;       //!< Recent evictions, halved at every rebalancing check
+        uint32_t pagesMoved;            //!< Pages taken from other classes
+    };
+
+    /**
+     * \param size the bytes of an item, header included
+     * \return the smallest class whose chunks fit the item, GetClassCount() if none
+     */
+    uint32_t ClassFor(uint32_t size) const;
+
+    /**
+     * \brief Get a free chunk in a class, assigning, moving or emptying pages as needed.
+     * \param cls the size class
+     * \param[out] evicted the ids evicted to make room are appended here
+     * \return true if the free list of the class is not empty
+     */
+    bool MakeRoom(uint32_t cls, std::vector<uint32_t>& evicted);
+
+    /**
+     * \brief Give a page to a class and put its chunks in the free list.
+     * \param page the page, not assigned or emptied
+     * \param cls the size class
+     */
+    void AssignPage(uint32_t page, uint32_t cls);
+
+    /**
+     * \brief Take a page from another class for a class that keeps evicting.
+     * \param cls the size class in need
+     * \param[out] evicted the ids evicted from the moved page are appended here
+     * \return true if a page was moved
+     */
+    bool MovePage(uint32_t cls, std::vector<uint32_t>& evicted);
+
+    /**
+     * \brief Detach a page from its class, evicting its objects.
+     * \param page the page
+     * \param[out] evicted the ids evicted from the page are appended here
+     */
+    void ReleasePage(uint32_t page, std::vector<uint32_t>& evicted);
+
+    /**
+     * \brief Free the chunk of a stored object.
+     * \param it the object
+     */
+    void FreeItem(std::unordered_map<uint32_t, Item>::iterator it);
+
+    /**
+     * \param page a page
+     * \param cls its class
+     * \param slot a chunk of the page
+     * \return the first byte of the chunk
+     */
+    uint8_t* ChunkData(uint32_t page, uint32_t cls, uint32_t slot) const;
+
+    uint64_t m_capacity;                    //!< Arena size
+    uint32_t m_pageSize;                    //!< Page size
+    bool m_rebalance;                       //!< Whether pages move between classes
+    std::unique_ptr<uint8_t[]> m_arena;     //!< Memory of the pages
+    uint32_t m_pageCount;                   //!< Pages in the arena
+    uint32_t m_nextPage;                    //!< First page never assigned
+    uint32_t m_emptyPages;                  //!< Assigned pages holding no object
+    std::vector<uint32_t> m_pageClass;      //!< Class of each assigned page
+    std::vector<uint32_t> m_pageItems;      //!< Objects on each page
+    std::vector<std::unique_ptr<SlabClass>> m_classes; //!< Size classes, smallest chunks first
+    std::unordered_map<uint32_t, Item> m_items; //!< Stored objects, nodes never move on rehash
+    uint64_t m_storedBytes;                 //!< Object bytes held
+    uint64_t m_evictions;                   //!< Objects evicted to make room
+    uint32_t m_pagesMoved;                  //!< Pages moved between classes
+};
+
+} // namespace ns3
+
+#endif /* SLAB_STORAGE_H */
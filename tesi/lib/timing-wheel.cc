@@ -0,0 +1,138 @@
+#include "timing-wheel.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+TimingWheel::TimingWheel()
+    : m_tick(MilliSeconds(1)),
+      m_now(0),
+      m_size(0)
+{
+}
+
+void
+TimingWheel::Configure(Time tick, Time now)
+{
+    NS_ASSERT(tick.IsStrictlyPositive());
+    Clear();
+    m_tick = tick;
+    m_now = now.GetTimeStep() / m_tick.GetTimeStep();
+}
+
+Time
+TimingWheel::GetTick() const
+{
+    return m_tick;
+}
+
+uint32_t
+TimingWheel::GetSize() const
+{
+    return m_size;
+}
+
+void
+TimingWheel::Schedule(uint32_t key, Time deadline)
+{
+    int64_t step = m_tick.GetTimeStep();
+    int64_t tick = (deadline.GetTimeStep() + step - 1) / step;
+    Place({key, tick > 0 ? static_cast<uint64_t>(tick) : 0});
+    m_size++;
+}
+
+void
+TimingWheel::Place(const Timer& timer)
+{
+    if (timer.tick <= m_now)
+    {
+        m_due.push_back(timer);
+        return;
+    }
+    uint32_t level = (63 - __builtin_clzll(timer.tick ^ m_now)) / SLOT_BITS;
+    if (level >= LEVELS)
+    {
+        m_overflow.push_back(timer);
+        return;
+    }
+    m_slots[level][(timer.tick >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(timer);
+}
+
+void
+TimingWheel::Cascade(uint32_t level)
+{
+    std::vector<Timer> timers;
+    timers.swap(m_slots[level][(m_now >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+    for (const Timer& timer : timers)
+    {
+        Place(timer);
+    }
+}
+
+void
+TimingWheel::Advance(Time now, std::vector<uint32_t>& expired)
+{
+    uint64_t target = now.GetTimeStep() / m_tick.GetTimeStep();
+    if (m_size == 0)
+    {
+        m_now = std::max(m_now, target);
+        return;
+    }
+
+    while (true)
+    {
+        for (const Timer& timer : m_due)
+        {
+            expired.push_back(timer.key);
+        }
+        m_size -= m_due.size();
+        m_due.clear();
+
+        if (m_now >= target || m_size == 0)
+        {
+            break;
+        }
+        m_now++;
+
+        if ((m_now & ((uint64_t(1) << (SLOT_BITS * LEVELS)) - 1)) == 0)
+        {
+            std::vector<Timer> timers;
+            timers.swap(m_overflow);
+            for (const Timer& timer : timers)
+            {
+                Place(timer);
+            }
+        }
+        for (uint32_t level = LEVELS - 1; level > 0; level--)
+        {
+            if ((m_now & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0)
+            {
+                Cascade(level);
+            }
+        }
+        std::vector<Timer>& slot = m_slots[0][m_now & (SLOTS - 1)];
+        m_due.insert(m_due.end(), slot.begin(), slot.end());
+        slot.clear();
+    }
+    m_now = std::max(m_now, target);
+}
+
+void
+TimingWheel::Clear()
+{
+    for (auto& level : m_slots)
+    {
+        for (auto& slot : level)
+        {
+            slot.clear();
+        }
+    }
+    m_overflow.clear();
+    m_due.clear();
+    m_size = 0;
+}
+
+} // namespace ns3
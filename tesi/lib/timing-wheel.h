@@ -0,0 +1,100 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Hierarchical timing wheel of Varghese and Lauck for per-id timers.
+ *
+ * Time advances in fixed ticks. Each of the 4 levels has 64 slots, level l
+ * covering 64^(l+1) ticks; a timer sits at the level of the highest tick bit
+ * in which its expiry differs from the current tick and is moved down a
+ * level each time the wheel reaches the start of its slot. Scheduling is
+ * O(1) and advancing is O(1) per tick plus the timers moved or fired, so a
+ * single ns-3 event driving the wheel replaces one event per timer.
+ *
+ * Timers cannot be cancelled: the owner checks, when a key expires, whether
+ * the timer is still the current one for that key.
+ */
+class TimingWheel
+{
+  public:
+    TimingWheel();
+
+    /**
+     * \brief Set the tick length and remove every timer.
+     * \param tick the granularity of the wheel
+     * \param now the current time
+     */
+    void Configure(Time tick, Time now);
+
+    /**
+     * \return the granularity of the wheel
+     */
+    Time GetTick() const;
+
+    /**
+     * \return the number of scheduled timers
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \brief Schedule a timer, firing at the first tick not before the deadline.
+     * \param key the id the timer refers to
+     * \param deadline the expiry time
+     */
+    void Schedule(uint32_t key, Time deadline);
+
+    /**
+     * \brief Move the wheel to the current time and collect the expired timers.
+     * \param now the current time
+     * \param[out] expired the keys of the timers that fired, appended in expiry order
+     */
+    void Advance(Time now, std::vector<uint32_t>& expired);
+
+    /**
+     * \brief Remove every timer.
+     */
+    void Clear();
+
+  private:
+    static constexpr uint32_t LEVELS = 4;    //!< Levels of the wheel
+    static constexpr uint32_t SLOT_BITS = 6; //!< log2 of the slots per level
+    static constexpr uint32_t SLOTS = 1 << SLOT_BITS; //!< Slots per level
+
+    /// A scheduled timer
+    struct Timer
+    {
+        uint32_t key;  //!< Id the timer refers to
+        uint64_t tick; //!< Expiry tick
+    };
+
+    /**
+     * \brief Put a timer in the slot matching its expiry tick.
+     * \param timer the timer
+     */
+    void Place(const Timer& timer);
+
+    /**
+     * \brief Move the timers of a slot to the lower levels.
+     * \param level the level of the slot, at least 1
+     */
+    void Cascade(uint32_t level);
+
+    Time m_tick;                             //!< Granularity of the wheel
+    uint64_t m_now;                          //!< Current tick
+    uint32_t m_size;                         //!< Scheduled timers
+    std::vector<Timer> m_slots[LEVELS][SLOTS]; //!< Timers by level and slot
+    std::vector<Timer> m_overflow;           //!< Timers beyond the top level
+    std::vector<Timer> m_due;                //!< Timers scheduled in the past
+};
+
+} // namespace ns3
+
+#endif /* TIMING_WHEEL_H */
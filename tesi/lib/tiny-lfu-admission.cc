@@ -0,0 +1,136 @@
+#include "tiny-lfu-admission.h"
+
+#include "hash-util.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Seeds of the DEPTH hash functions
+const uint64_t g_seeds[] = {0x9e3779b97f4a7c15ULL,
+                            0xc2b2ae3d27d4eb4fULL,
+                            0x165667b19e3779f9ULL,
+                            0xd6e8feb86659fd93ULL};
+
+} // namespace
+
+TinyLfuAdmission::TinyLfuAdmission()
+    : m_mask(0),
+      m_resetPeriod(0),
+      m_additions(0),
+      m_resets(0)
+{
+    Configure(1, 1);
+}
+
+void
+TinyLfuAdmission::Configure(uint32_t width, uint32_t resetPeriod)
+{
+    uint32_t rowWidth = 64;
+    while (rowWidth < width)
+    {
+        rowWidth <<= 1;
+    }
+    m_mask = rowWidth - 1;
+    m_counters.assign(static_cast<size_t>(DEPTH) * rowWidth, 0);
+    m_doorkeeper.assign(rowWidth / 64, 0);
+    m_resetPeriod = std::max<uint32_t>(1, resetPeriod);
+    m_additions = 0;
+    m_resets = 0;
+}
+
+uint32_t
+TinyLfuAdmission::Slot(uint32_t id, uint32_t row) const
+{
+    return static_cast<uint32_t>(SplitMix64(id, g_seeds[row])) & m_mask;
+}
+
+bool
+TinyLfuAdmission::DoorkeeperContains(uint32_t id) const
+{
+    for (uint32_t row = 0; row < DEPTH; row++)
+    {
+        uint32_t bit = Slot(id, row);
+        if (!(m_doorkeeper[bit >> 6] & (1ULL << (bit & 63))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+TinyLfuAdmission::RecordAccess(uint32_t id)
+{
+    if (!DoorkeeperContains(id))
+    {
+        for (uint32_t row = 0; row < DEPTH; row++)
+        {
+            uint32_t bit = Slot(id, row);
+            m_doorkeeper[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+    else
+    {
+        // Conservative update: only the smallest counters are raised
+        uint32_t current = Estimate(id) - 1;
+        for (uint32_t row = 0; row < DEPTH; row++)
+        {
+            uint8_t& counter = m_counters[row * (m_mask + 1) + Slot(id, row)];
+            if (counter == current && counter < MAX_COUNT)
+            {
+                counter++;
+            }
+        }
+    }
+
+    if (++m_additions >= m_resetPeriod)
+    {
+        Age();
+    }
+}
+
+uint32_t
+TinyLfuAdmission::Estimate(uint32_t id) const
+{
+    if (!DoorkeeperContains(id))
+    {
+        return 0;
+    }
+    uint8_t count = MAX_COUNT;
+    for (uint32_t row = 0; row < DEPTH; row++)
+    {
+        count = std::min(count, m_counters[row * (m_mask + 1) + Slot(id, row)]);
+    }
+    return count + 1;
+}
+
+bool
+TinyLfuAdmission::Admit(uint32_t candidate, uint32_t victim) const
+{
+    return Estimate(candidate) > Estimate(victim);
+}
+
+uint32_t
+TinyLfuAdmission::GetResets() const
+{
+    return m_resets;
+}
+
+void
+TinyLfuAdmission::Age()
+{
+    for (auto& counter : m_counters)
+    {
+        counter >>= 1;
+    }
+    std::fill(m_doorkeeper.begin(), m_doorkeeper.end(), 0);
+    m_additions /= 2;
+    m_resets++;
+}
+
+} // namespace ns3
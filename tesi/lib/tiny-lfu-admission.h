@@ -0,0 +1,88 @@
+#ifndef TINY_LFU_ADMISSION_H
+#define TINY_LFU_ADMISSION_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief TinyLFU admission filter of Einziger, Friedman and Manes.
+ *
+ * Access frequencies are approximated by a count-min sketch of 4-bit
+ * saturating counters placed behind a doorkeeper Bloom filter, so ids seen
+ * only once never reach the sketch. After a fixed number of recorded accesses
+ * every counter is halved and the doorkeeper is cleared, letting old
+ * popularity fade away.
+ */
+class TinyLfuAdmission
+{
+  public:
+    TinyLfuAdmission();
+
+    /**
+     * \brief Size the filter and forget every recorded access.
+     * \param width counters per sketch row, rounded up to a power of two
+     * \param resetPeriod recorded accesses between two agings
+     */
+    void Configure(uint32_t width, uint32_t resetPeriod);
+
+    /**
+     * \brief Record one access to an id.
+     * \param id the object id
+     */
+    void RecordAccess(uint32_t id);
+
+    /**
+     * \param id the object id
+     * \return the estimated number of recent accesses to the id
+     */
+    uint32_t Estimate(uint32_t id) const;
+
+    /**
+     * \brief Decide whether a candidate may replace an eviction victim.
+     * \param candidate the id that would be inserted
+     * \param victim the id that would be evicted
+     * \return true if the candidate is estimated to be more popular
+     */
+    bool Admit(uint32_t candidate, uint32_t victim) const;
+
+    /**
+     * \return the number of agings done so far
+     */
+    uint32_t GetResets() const;
+
+  private:
+    /**
+     * \brief Halve every counter and clear the doorkeeper.
+     */
+    void Age();
+
+    /**
+     * \param id the object id
+     * \param row index of the hash function
+     * \return the slot of the id in the given row
+     */
+    uint32_t Slot(uint32_t id, uint32_t row) const;
+
+    /**
+     * \param id the object id
+     * \return true if the id was added to the doorkeeper since the last aging
+     */
+    bool DoorkeeperContains(uint32_t id) const;
+
+    static constexpr uint32_t DEPTH = 4;     //!< Rows of the sketch and hashes of the doorkeeper
+    static constexpr uint8_t MAX_COUNT = 15; //!< Saturation value of a counter
+
+    std::vector<uint8_t> m_counters;    //!< DEPTH rows of m_mask + 1 counters
+    std::vector<uint64_t> m_doorkeeper; //!< Bloom filter bits, m_mask + 1 of them
+    uint32_t m_mask;                    //!< Row width minus one
+    uint32_t m_resetPeriod;             //!< Accesses between two agings
+    uint32_t m_additions;               //!< Accesses since the last aging
+    uint32_t m_resets;                  //!< Number of agings
+};
+
+} // namespace ns3
+
+#endif /* TINY_LFU_ADMISSION_H */
@@ -0,0 +1,235 @@
+#include "udp-cache-cluster.h"
+
+#include "udp-cache-server.h"
+#include "udp-traffic-generator.h"
+
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("UdpCacheCluster");
+
+UdpCacheCluster::UdpCacheCluster(const UdpCacheServerHelper& servers,
+                                 uint16_t portClients,
+                                 uint32_t virtualNodes,
+                                 uint32_t catalogueSize)
+    : m_servers(servers),
+      m_portClients(portClients),
+      m_catalogueSize(catalogueSize),
+      m_ring(Create<ConsistentHashRing>(virtualNodes)),
+      m_recoveryThreshold(0.95),
+      m_lastAccesses(0),
+      m_lastHits(0),
+      m_lastRatio(-1)
+{
+}
+
+ApplicationContainer
+UdpCacheCluster::Install(NodeContainer nodes)
+{
+    ApplicationContainer apps = m_servers.Install(nodes);
+    for (auto it = apps.Begin(); it != apps.End(); ++it)
+    {
+        AddShard(*it, false);
+    }
+    return apps;
+}
+
+void
+UdpCacheCluster::SetClients(ApplicationContainer clients)
+{
+    for (auto it = clients.Begin(); it != clients.End(); ++it)
+    {
+        Ptr<UdpTrafficGenerator> client = DynamicCast<UdpTrafficGenerator>(*it);
+        NS_ASSERT_MSG(client, "Cluster clients must be UdpTrafficGenerator applications");
+        client->SetShardRing(m_ring);
+    }
+}
+
+ApplicationContainer
+UdpCacheCluster::ScheduleAddShard(Time at, Ptr<Node> node)
+{
+    ApplicationContainer app = m_servers.Install(node);
+    app.Start(at);
+    Simulator::Schedule(at - Simulator::Now(), &UdpCacheCluster::AddShard, this, app.Get(0), true);
+    return app;
+}
+
+void
+UdpCacheCluster::ScheduleRemoveShard(Time at, uint32_t shard)
+{
+    Simulator::Schedule(at - Simulator::Now(), &UdpCacheCluster::RemoveShard, this, shard);
+}
+
+void
+UdpCacheCluster::StartSampling(Time interval, Time stop, double recoveryThreshold)
+{
+    m_sampleInterval = interval;
+    m_sampleStop = stop;
+    m_recoveryThreshold = recoveryThreshold;
+    Simulator::Schedule(interval, &UdpCacheCluster::Sample, this);
+}
+
+Ptr<ConsistentHashRing>
+UdpCacheCluster::GetRing() const
+{
+    return m_ring;
+}
+
+void
+UdpCacheCluster::AddShard(Ptr<Application> app, bool record)
+{
+    Ptr<Ipv4> ipv4 = app->GetNode()->GetObject<Ipv4>();
+    NS_ASSERT_MSG(ipv4 && ipv4->GetNInterfaces() > 1, "Shard node without an IPv4 address");
+    uint32_t shard = m_ring->AddShard(InetSocketAddress(ipv4->GetAddress(1, 0).GetLocal(), m_portClients));
+    NS_ASSERT(shard == m_shards.size());
+    m_shards.push_back(app);
+    RecordChange(shard, true, record);
+    NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " shard " << shard << " joined the cluster");
+}
+
+void
+UdpCacheCluster::RemoveShard(uint32_t shard)
+{
+    if (!m_ring->RemoveShard(shard))
+    {
+        NS_LOG_WARN("Shard " << shard << " is not on the ring");
+        return;
+    }
+    RecordChange(shard, false, true);
+    NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " shard " << shard << " left the cluster");
+}
+
+void
+UdpCacheCluster::RecordChange(uint32_t shard, bool added, bool record)
+{
+    std::vector<uint32_t> owners(m_catalogueSize);
+    uint32_t moved = 0;
+    m_owned.assign(m_shards.size(), 0);
+    for (uint32_t id = 1; id <= m_catalogueSize && m_ring->GetShardCount() > 0; id++)
+    {
+        owners[id - 1] = m_ring->GetShard(id);
+        m_owned[owners[id - 1]]++;
+        if (!m_owners.empty() && owners[id - 1] != m_owners[id - 1])
+        {
+            moved++;
+        }
+    }
+    // the virtual nodes should give every shard about its fair share of the catalogue
+    uint32_t shards = m_ring->GetShardCount();
+    uint32_t most = m_owned.empty() ? 0 : *std::max_element(m_owned.begin(), m_owned.end());
+    if (shards > 1 && m_catalogueSize >= 10 * shards && most > 2 * m_catalogueSize / shards)
+    {
+        NS_LOG_WARN("A shard owns " << most << " of " << m_catalogueSize << " ids on a ring of " << shards
+                                    << " shards, raise the VirtualNodes");
+    }
+    if (record)
+    {
+        m_changes.push_back(MembershipChange{Simulator::Now(),
+                                             shard,
+                                             added,
+                                             m_ring->GetShardCount(),
+                                             m_catalogueSize > 0 ? double(moved) / m_catalogueSize : 0,
+                                             m_lastRatio,
+                                             Time(-1)});
+    }
+    m_owners.swap(owners);
+}
+
+void
+UdpCacheCluster::Sample()
+{
+    uint64_t accesses = 0;
+    uint64_t hits = 0;
+    for (const Ptr<Application>& app : m_shards)
+    {
+        Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(app);
+        accesses += cache->GetAccesses();
+        hits += cache->GetHits();
+    }
+    // a shard joining late starts from zero, so the sums only grow
+    if (accesses > m_lastAccesses)
+    {
+        m_lastRatio = double(hits - m_lastHits) / (accesses - m_lastAccesses);
+        m_samples.emplace_back(Simulator::Now(), m_lastRatio);
+        for (MembershipChange& change : m_changes)
+        {
+            if (change.recovery.IsNegative() && change.baseline >= 0 &&
+                m_lastRatio >= m_recoveryThreshold * change.baseline)
+            {
+                change.recovery = Simulator::Now() - change.at;
+            }
+        }
+    }
+    m_lastAccesses = accesses;
+    m_lastHits = hits;
+    if (Simulator::Now() + m_sampleInterval <= m_sampleStop)
+    {
+        Simulator::Schedule(m_sampleInterval, &UdpCacheCluster::Sample, this);
+    }
+}
+
+void
+UdpCacheCluster::PrintStats(std::string fileName) const
+{
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    for (const MembershipChange& change : m_changes)
+    {
+        outputFile << "time:" << change.at.GetSeconds() << ";" << "event:" << (change.added ? "add" : "remove") << ";"
+                   << "shard:" << change.shard << ";" << "shards:" << change.shards << ";"
+                   << "remapped:" << change.remapped << ";" << "baseline:" << change.baseline << ";"
+                   << "recoveryms:" << (change.recovery.IsNegative() ? -1 : change.recovery.GetMilliSeconds()) << ";"
+                   << std::endl;
+    }
+    for (uint32_t shard = 0; shard < m_shards.size(); shard++)
+    {
+        Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(m_shards[shard]);
+        uint32_t accesses = cache->GetAccesses();
+        outputFile << "shard:" << shard << ";" << "active:" << m_ring->IsActive(shard) << ";"
+                   << "owned:" << (shard < m_owned.size() ? m_owned[shard] : 0) << ";"
+                   << "accesses:" << accesses << ";" << "hits:" << cache->GetHits() << ";"
+                   << "hitratio:" << (accesses > 0 ? double(cache->GetHits()) / accesses : 0) << ";" << std::endl;
+    }
+    outputFile.close();
+
+    if (m_samples.empty())
+    {
+        return;
+    }
+    // the samples go next to the statistics, so that two clusters of a run
+    // do not overwrite each other's
+    std::string samplesName = fileName;
+    std::size_t dot = samplesName.find_last_of('.');
+    if (dot != std::string::npos && dot > samplesName.find_last_of('/') + 1)
+    {
+        samplesName.erase(dot);
+    }
+    samplesName += "-hitratio.csv";
+    std::ofstream samplesFile(samplesName);
+    if (!samplesFile.is_open())
+    {
+        std::cerr << "Error opening file " << samplesName << std::endl;
+        return;
+    }
+    for (const auto& [time, ratio] : m_samples)
+    {
+        samplesFile << time.GetSeconds() << ";" << ratio << "\n";
+    }
+    samplesFile.close();
+}
+
+} // namespace ns3
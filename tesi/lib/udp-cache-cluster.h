@@ -0,0 +1,156 @@
+#ifndef UDP_CACHE_CLUSTER_H
+#define UDP_CACHE_CLUSTER_H
+
+#include "consistent-hash-ring.h"
+#include "udp-traffic-cache-cp-helper.h"
+
+#include "ns3/application-container.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Cluster of UdpCacheServer shards behind a consistent-hash ring.
+ *
+ * Every shard is an independent cache fetching from the same content server;
+ * the clients given to SetClients send each request straight to the shard
+ * owning its id on the ring. Shards can join or leave at scheduled times:
+ * the ring changes for every client at once, and the share of the
+ * catalogue that moved to another shard is measured at each change. With
+ * sampling on, the hit ratio of the cluster is measured per interval and
+ * the time it takes to get back near its value before each change is
+ * reported as the recovery time.
+ *
+ * Shards are numbered in the order they join. A removed shard stops getting
+ * requests but keeps running. The cluster must outlive the simulation.
+ */
+class UdpCacheCluster
+{
+  public:
+    /**
+     * \param servers the helper configuring the shards, with the content server to fetch from
+     * \param portClients the port the shards listen on for clients, as set in servers
+     * \param virtualNodes points of the ring per shard
+     * \param catalogueSize the ids 1 to catalogueSize checked for remapping
+     */
+    UdpCacheCluster(const UdpCacheServerHelper& servers,
+                    uint16_t portClients,
+                    uint32_t virtualNodes,
+                    uint32_t catalogueSize);
+    UdpCacheCluster(const UdpCacheCluster&) = delete;
+    UdpCacheCluster& operator=(const UdpCacheCluster&) = delete;
+
+    /**
+     * \brief Install a shard on each node and put them on the ring.
+     * \param nodes the nodes, each reachable at its first IPv4 address
+     * \return the shards installed
+     */
+    ApplicationContainer Install(NodeContainer nodes);
+
+    /**
+     * \brief Route the requests of UdpTrafficGenerator clients through the ring.
+     * \param clients the clients
+     */
+    void SetClients(ApplicationContainer clients);
+
+    /**
+     * \brief Install a shard now and put it on the ring at a later time.
+     * \param at the time the shard joins, also its start time
+     * \param node the node of the shard
+     * \return the shard installed
+     */
+    ApplicationContainer ScheduleAddShard(Time at, Ptr<Node> node);
+
+    /**
+     * \brief Take a shard off the ring at a later time.
+     * \param at the time the shard leaves
+     * \param shard the shard number
+     */
+    void ScheduleRemoveShard(Time at, uint32_t shard);
+
+    /**
+     * \brief Measure the hit ratio of the cluster periodically.
+     * \param interval the measurement window
+     * \param stop the time of the last measurement
+     * \param recoveryThreshold share of the hit ratio before a change that counts as recovered
+     */
+    void StartSampling(Time interval, Time stop, double recoveryThreshold = 0.95);
+
+    /**
+     * \return the ring shared with the clients
+     */
+    Ptr<ConsistentHashRing> GetRing() const;
+
+    /**
+     * \brief Write the membership changes and the per-shard counters, one line each,
+     *        and the sampled hit ratios to the same name with a -hitratio.csv suffix
+     *        instead of the extension. Call it after Simulator::Run.
+     * \param fileName the output file
+     */
+    void PrintStats(std::string fileName = "output/clusterstats.txt") const;
+
+  private:
+    /// Shard joining or leaving the ring
+    struct MembershipChange
+    {
+        Time at;         //!< Time of the change
+        uint32_t shard;  //!< Shard number
+        bool added;      //!< Whether the shard joined
+        uint32_t shards; //!< Shards on the ring after the change
+        double remapped; //!< Share of the catalogue owned by another shard after the change
+        double baseline; //!< Hit ratio of the last window before the change, negative if unknown
+        Time recovery;   //!< Time to get back to the baseline, negative until then
+    };
+
+    /**
+     * \brief Put an installed shard on the ring.
+     * \param app the shard
+     * \param record whether it is a membership change, not part of the initial shards
+     */
+    void AddShard(Ptr<Application> app, bool record);
+
+    /**
+     * \brief Take a shard off the ring.
+     * \param shard the shard number
+     */
+    void RemoveShard(uint32_t shard);
+
+    /**
+     * \brief Update the owner of every id, recording the change and the ids that moved.
+     * \param shard the shard number
+     * \param added whether the shard joined
+     * \param record whether to record the change
+     */
+    void RecordChange(uint32_t shard, bool added, bool record);
+
+    /**
+     * \brief Measure the hit ratio of the last window and check the recoveries.
+     */
+    void Sample();
+
+    UdpCacheServerHelper m_servers;       //!< Helper configuring the shards
+    uint16_t m_portClients;               //!< Port of the shards for clients
+    uint32_t m_catalogueSize;             //!< Ids checked for remapping
+    Ptr<ConsistentHashRing> m_ring;       //!< Ring shared with the clients
+    std::vector<Ptr<Application>> m_shards; //!< Shards by number
+    std::vector<uint32_t> m_owners;       //!< Owner of each id before the last change
+    std::vector<uint32_t> m_owned;        //!< Ids owned by each shard after the last change
+    std::vector<MembershipChange> m_changes; //!< Membership changes so far
+    Time m_sampleInterval;                //!< Measurement window, 0 when not sampling
+    Time m_sampleStop;                    //!< Time of the last measurement
+    double m_recoveryThreshold;           //!< Share of the baseline that counts as recovered
+    uint64_t m_lastAccesses;              //!< Requests of the cluster at the last measurement
+    uint64_t m_lastHits;                  //!< Hits of the cluster at the last measurement
+    double m_lastRatio;                   //!< Hit ratio of the last window, negative if unknown
+    std::vector<std::pair<Time, double>> m_samples; //!< Hit ratio of every window
+};
+
+} // namespace ns3
+
+#endif /* UDP_CACHE_CLUSTER_H */
@@ -1,22 +1,34 @@
 #include "udp-cache-server.h"
 
+#include "flat-cache-policy.h"
+#include "hash-util.h"
+#include "output-file.h"
+
 #include "ns3/address-utils.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/socket.h"
+#include "ns3/string.h"
 #include "ns3/udp-socket.h"
 #include "ns3/uinteger.h"
 
-#include <regex>
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <sstream>
 
 namespace ns3
 {
@@ -25,6 +37,12 @@ NS_LOG_COMPONENT_DEFINE("UdpCacheServerApplication");
 
 NS_OBJECT_ENSURE_REGISTERED(UdpCacheServer);
 
+/// Largest UDP payload over IPv4
+static const uint32_t MAX_UDP_PAYLOAD = 65507;
+
+/// Hash seed of the ids partitioned among the content servers, apart from the core steering
+static const uint64_t ORIGIN_SEED = 0x510e527fade682d1ULL;
+
 TypeId
 UdpCacheServer::GetTypeId()
 {
@@ -34,15 +52,327 @@ UdpCacheServer::GetTypeId()
             .SetGroupName("Applications")
             .AddConstructor<UdpCacheServer>()
             .AddAttribute("CacheSize",
-                          "Size of the cache",
+                          "Size of the cache; with a StorageCapacity, the number of objects "
+                          "expected to fit, which sizes the sibling summary and the prefetch table",
                           UintegerValue(100),
                           MakeUintegerAccessor(&UdpCacheServer::m_cacheSize),
                           MakeUintegerChecker<u_int32_t>())
+            .AddAttribute("StorageCapacity",
+                          "Bytes of slab memory holding the cached objects; when not 0 it bounds "
+                          "the cache instead of CacheSize and objects are evicted from their slab "
+                          "class in LRU order, so only the LRU EvictionPolicy without "
+                          "AdmissionFilter is allowed",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_storageCapacity),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("SlabPageSize",
+                          "Size of a slab page, also the largest object the storage holds",
+                          UintegerValue(1048576),
+                          MakeUintegerAccessor(&UdpCacheServer::m_slabPageSize),
+                          MakeUintegerChecker<uint32_t>(1024))
+            .AddAttribute("SlabMinChunk",
+                          "Chunk size of the smallest slab class, item header included",
+                          UintegerValue(96),
+                          MakeUintegerAccessor(&UdpCacheServer::m_slabMinChunk),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("SlabGrowthFactor",
+                          "Ratio between the chunk sizes of consecutive slab classes",
+                          DoubleValue(1.25),
+                          MakeDoubleAccessor(&UdpCacheServer::m_slabGrowthFactor),
+                          MakeDoubleChecker<double>(1.01))
+            .AddAttribute("SlabRebalance",
+                          "Whether slab pages move from classes that rarely evict to classes "
+                          "that keep evicting",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpCacheServer::m_slabRebalance),
+                          MakeBooleanChecker())
+            .AddAttribute("FlashCapacity",
+                          "Bytes of the flash tier receiving the objects evicted from memory "
+                          "(0 means memory only)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_flashCapacity),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("FlashRegionSize",
+                          "Bytes of the flash write buffer, written to the device at once",
+                          UintegerValue(1048576),
+                          MakeUintegerAccessor(&UdpCacheServer::m_flashRegionSize),
+                          MakeUintegerChecker<uint32_t>(4096))
+            .AddAttribute("FlashReadLatency",
+                          "Fixed cost of a flash read, added to its transfer time",
+                          TimeValue(MicroSeconds(100)),
+                          MakeTimeAccessor(&UdpCacheServer::m_flashReadLatency),
+                          MakeTimeChecker())
+            .AddAttribute("FlashWriteLatency",
+                          "Fixed cost of a flash region write, added to its transfer time",
+                          TimeValue(MicroSeconds(500)),
+                          MakeTimeAccessor(&UdpCacheServer::m_flashWriteLatency),
+                          MakeTimeChecker())
+            .AddAttribute("FlashBandwidth",
+                          "Transfer rate of the flash device, shared by reads and writes",
+                          DataRateValue(DataRate("16Gbps")),
+                          MakeDataRateAccessor(&UdpCacheServer::m_flashBandwidth),
+                          MakeDataRateChecker())
+            .AddAttribute("FlashAdmission",
+                          "Rule deciding which objects evicted from memory are written to flash",
+                          EnumValue(FlashTier::ADMIT_ALL),
+                          MakeEnumAccessor(&UdpCacheServer::m_flashAdmission),
+                          MakeEnumChecker(FlashTier::ADMIT_ALL, "ALL",
+                                          FlashTier::RANDOM, "RANDOM",
+                                          FlashTier::REJECT_FIRST, "REJECT_FIRST"))
+            .AddAttribute("FlashAdmitProbability",
+                          "Probability that the RANDOM flash admission writes an object",
+                          DoubleValue(0.5),
+                          MakeDoubleAccessor(&UdpCacheServer::m_flashAdmitProbability),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("FlashMaxObjectSize",
+                          "Largest object written to flash, in bytes (0 means no limit)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_flashMaxObjectSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("FlashReinsertHits",
+                          "Whether objects read from flash are written again when their region "
+                          "is reclaimed, instead of being dropped",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpCacheServer::m_flashReinsertHits),
+                          MakeBooleanChecker())
+            .AddAttribute("EvictionPolicy",
+                          "Replacement policy used when the cache is full, fixed by the type "
+                          "of the specialized caches such as ns3::LruUdpCacheServer",
+                          EnumValue(CacheEvictionPolicy::FIFO),
+                          MakeEnumAccessor(&UdpCacheServer::m_evictionPolicy),
+                          MakeEnumChecker(CacheEvictionPolicy::FIFO, "FIFO",
+                                          CacheEvictionPolicy::LRU, "LRU",
+                                          CacheEvictionPolicy::LFU, "LFU",
+                                          CacheEvictionPolicy::TWO_Q, "2Q",
+                                          CacheEvictionPolicy::ARC, "ARC",
+                                          CacheEvictionPolicy::SIEVE, "SIEVE",
+                                          CacheEvictionPolicy::S3_FIFO, "S3-FIFO",
+                                          CacheEvictionPolicy::GDSF, "GDSF"))
+            .AddAttribute("Placement",
+                          "Which fetched objects the cache keeps when its content server is "
+                          "another cache: all, leave-copy-down (only those its parent served "
+                          "from its own cache) or none, only relaying the misses",
+                          EnumValue(UdpCacheServer::LEAVE_COPY_EVERYWHERE),
+                          MakeEnumAccessor(&UdpCacheServer::m_placement),
+                          MakeEnumChecker(UdpCacheServer::LEAVE_COPY_EVERYWHERE, "LCE",
+                                          UdpCacheServer::LEAVE_COPY_DOWN, "LCD",
+                                          UdpCacheServer::NO_COPY, "NONE"))
+            .AddAttribute("AdmissionFilter",
+                          "Whether a fetched object must be estimated more popular than the "
+                          "eviction victim (TinyLFU) to enter a full cache",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpCacheServer::m_admissionFilter),
+                          MakeBooleanChecker())
+            .AddAttribute("SketchWidth",
+                          "Counters per row of the TinyLFU frequency sketch "
+                          "(0 means four times the cache size)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_sketchWidth),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("SketchResetPeriod",
+                          "Client requests between two agings of the TinyLFU sketch "
+                          "(0 means ten times the cache size)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_sketchResetPeriod),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("SmallCacheMode",
+                          "Whether FIFO, LRU and LFU caches of at most SmallCacheThreshold "
+                          "ids keep them in a flat array searched with SIMD instructions, "
+                          "ignored by the specialized caches such as ns3::LruUdpCacheServer",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&UdpCacheServer::m_smallCacheMode),
+                          MakeBooleanChecker())
+            .AddAttribute("SmallCacheThreshold",
+                          "Largest cache size stored as a flat array in SmallCacheMode",
+                          UintegerValue(128),
+                          MakeUintegerAccessor(&UdpCacheServer::m_smallCacheThreshold),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxWaiters",
+                          "Clients that can wait on the outstanding fetch of one id, further "
+                          "requests for it are dropped (0 means no limit)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_maxWaiters),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxRetries",
+                          "Retransmissions of an origin request after a timeout, the timeout "
+                          "of the last one expires the fetch if ExpireFetches is set; requests "
+                          "the content server sheds are sent again after a backoff that does "
+                          "not count against them",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_maxRetries),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("ExpireFetches",
+                          "Whether a fetch still unanswered after MaxRetries retransmissions "
+                          "expires and its waiting clients are dropped, instead of waiting for "
+                          "the origin as long as it takes",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpCacheServer::m_expireFetches),
+                          MakeBooleanChecker())
+            .AddAttribute("TimerGranularity",
+                          "Tick of the timing wheel holding the retransmission timers",
+                          TimeValue(MilliSeconds(5)),
+                          MakeTimeAccessor(&UdpCacheServer::m_timerGranularity),
+                          MakeTimeChecker())
+            .AddAttribute("DefaultTtl",
+                          "Time to live of the objects the content server sends no TTL for "
+                          "(0 means they never expire)",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UdpCacheServer::m_defaultTtl),
+                          MakeTimeChecker())
+            .AddAttribute("StaleWhileRevalidate",
+                          "Time after its expiration an object is still served, while a single "
+                          "background request refreshes it",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UdpCacheServer::m_staleWhileRevalidate),
+                          MakeTimeChecker())
+            .AddAttribute("StaleIfError",
+                          "Time after its expiration an object is served to the clients waiting "
+                          "on its fetch if the fetch expires",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UdpCacheServer::m_staleIfError),
+                          MakeTimeChecker())
+            .AddAttribute("ExpirationGranularity",
+                          "Tick of the timing wheel dropping the objects past their stale windows",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&UdpCacheServer::m_expirationGranularity),
+                          MakeTimeChecker())
+            .AddAttribute("Prefetcher",
+                          "Predictor of the ids prefetched after a miss",
+                          EnumValue(PrefetchEngine::NEIGHBOUR),
+                          MakeEnumAccessor(&UdpCacheServer::m_prefetcher),
+                          MakeEnumChecker(PrefetchEngine::NONE, "NONE",
+                                          PrefetchEngine::NEIGHBOUR, "NEIGHBOUR",
+                                          PrefetchEngine::STRIDE, "STRIDE",
+                                          PrefetchEngine::MARKOV, "MARKOV",
+                                          PrefetchEngine::POPULARITY, "POPULARITY"))
+            .AddAttribute("PrefetchDegree",
+                          "Largest number of ids prefetched after one request",
+                          UintegerValue(4),
+                          MakeUintegerAccessor(&UdpCacheServer::m_prefetchDegree),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("PrefetchBudget",
+                          "Prefetches allowed per second (0 means no limit)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_prefetchBudget),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("AdaptivePrefetch",
+                          "Whether the prefetch degree follows the measured accuracy and coverage",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpCacheServer::m_adaptivePrefetch),
+                          MakeBooleanChecker())
+            .AddAttribute("PrefetchTableSize",
+                          "Ids whose successors are tracked by the MARKOV predictor "
+                          "(0 means ten times the cache size)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_prefetchTableSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("CatalogueSize",
+                          "Number of objects of the content server, with ids from 1 to CatalogueSize",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&UdpCacheServer::m_catalogueSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("BatchWindow",
+                          "Time during which missing ids are collected into one request to the "
+                          "content server (0 means one request per id)",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UdpCacheServer::m_batchWindow),
+                          MakeTimeChecker())
+            .AddAttribute("BatchSize",
+                          "Ids after which a batched request is sent before the end of the window",
+                          UintegerValue(32),
+                          MakeUintegerAccessor(&UdpCacheServer::m_batchSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxPayloadSize",
+                          "Largest payload of a request to the content server, in bytes",
+                          UintegerValue(1472),
+                          MakeUintegerAccessor(&UdpCacheServer::m_maxPayloadSize),
+                          MakeUintegerChecker<uint32_t>(64))
+            .AddAttribute("Protocol",
+                          "Encoding of the messages sent to clients and to the content server",
+                          EnumValue(CacheProtocolHeader::BINARY),
+                          MakeEnumAccessor(&UdpCacheServer::m_protocol),
+                          MakeEnumChecker(CacheProtocolHeader::TEXT, "TEXT",
+                                          CacheProtocolHeader::BINARY, "BINARY"))
+            .AddAttribute("Mtu",
+                          "IP MTU of the path to the clients, every segment of an object fits in it",
+                          UintegerValue(1400),
+                          MakeUintegerAccessor(&UdpCacheServer::m_mtu),
+                          MakeUintegerChecker<uint32_t>(64))
+            .AddAttribute("PacingRate",
+                          "Rate at which the segments of the objects are sent to clients, 0 for no pacing",
+                          DataRateValue(DataRate("0bps")),
+                          MakeDataRateAccessor(&UdpCacheServer::m_pacingRate),
+                          MakeDataRateChecker())
+            .AddAttribute("SendWindow",
+                          "Segments that can be sent back to back when pacing",
+                          UintegerValue(4),
+                          MakeUintegerAccessor(&UdpCacheServer::m_sendWindow),
+                          MakeUintegerChecker<uint32_t>(1))
             .AddAttribute("rttCacheMiss",
-                          "RTT for cache miss",
+                          "RTT for cache miss, used as fetch cost of objects whose fetch "
+                          "time was not measured and as initial RTT estimate",
                           TimeValue(MilliSeconds(500)),
                           MakeTimeAccessor(&UdpCacheServer::m_RTTCacheMiss),
                           MakeTimeChecker())
+            .AddAttribute("SummaryInterval",
+                          "Time between two summaries of the cache contents sent to the siblings",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&UdpCacheServer::m_summaryInterval),
+                          MakeTimeChecker())
+            .AddAttribute("SummaryBitsPerObject",
+                          "Bits of the Bloom filter summary per object the cache holds",
+                          UintegerValue(8),
+                          MakeUintegerAccessor(&UdpCacheServer::m_summaryBitsPerObject),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("SummaryHashes",
+                          "Hash functions of the Bloom filter summary "
+                          "(0 means the number minimizing false positives)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_summaryHashes),
+                          MakeUintegerChecker<uint32_t>(0, 32))
+            .AddAttribute("Cores",
+                          "Worker cores serving the requests, each with its own queue "
+                          "(0 means requests are served in no time)",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpCacheServer::m_coreCount),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("CoreQueueSize",
+                          "Jobs a core holds, the one in service included; requests beyond are dropped",
+                          UintegerValue(128),
+                          MakeUintegerAccessor(&UdpCacheServer::m_coreQueueSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("CoreSteering",
+                          "Key hashed to pick the core of a request: the object id, or the "
+                          "address and port of the sender as receive-side scaling does",
+                          EnumValue(UdpCacheServer::STEER_ID),
+                          MakeEnumAccessor(&UdpCacheServer::m_coreSteering),
+                          MakeEnumChecker(UdpCacheServer::STEER_ID, "ID",
+                                          UdpCacheServer::STEER_FLOW, "FLOW"))
+            .AddAttribute("ParseTime",
+                          "Core time to parse a request or a response",
+                          TimeValue(MicroSeconds(1)),
+                          MakeTimeAccessor(&UdpCacheServer::m_parseTime),
+                          MakeTimeChecker())
+            .AddAttribute("HitTime",
+                          "Core time to serve a hit",
+                          TimeValue(MicroSeconds(2)),
+                          MakeTimeAccessor(&UdpCacheServer::m_hitTime),
+                          MakeTimeChecker())
+            .AddAttribute("MissTime",
+                          "Core time to handle a miss, the request upstream included",
+                          TimeValue(MicroSeconds(3)),
+                          MakeTimeAccessor(&UdpCacheServer::m_missTime),
+                          MakeTimeChecker())
+            .AddAttribute("InsertTime",
+                          "Core time to insert a fetched object in the cache",
+                          TimeValue(MicroSeconds(3)),
+                          MakeTimeAccessor(&UdpCacheServer::m_insertTime),
+                          MakeTimeChecker())
+            .AddAttribute("EvictTime",
+                          "Core time to evict an object",
+                          TimeValue(MicroSeconds(1)),
+                          MakeTimeAccessor(&UdpCacheServer::m_evictTime),
+                          MakeTimeChecker())
             .AddAttribute("PortClients",
                           "Port on which we listen for incoming request from clients.",
                           UintegerValue(9),
@@ -58,6 +388,20 @@ UdpCacheServer::GetTypeId()
                           AddressValue(),
                           MakeAddressAccessor(&UdpCacheServer::contentServerAddress),
                           MakeAddressChecker())
+            .AddAttribute("OriginPartitioning",
+                          "How the ids are split among the content servers added with AddOrigin or "
+                          "the OriginMapFile: by their ranges, the ids of no range going to "
+                          "IpContentServer, or by a hash of the id over all of them and IpContentServer",
+                          EnumValue(UdpCacheServer::PARTITION_RANGE),
+                          MakeEnumAccessor(&UdpCacheServer::m_originPartitioning),
+                          MakeEnumChecker(UdpCacheServer::PARTITION_RANGE, "RANGE",
+                                          UdpCacheServer::PARTITION_HASH, "HASH"))
+            .AddAttribute("OriginMapFile",
+                          "File with one \"ipv4 port [firstId lastId]\" line per content server "
+                          "to add at the start, as with AddOrigin",
+                          StringValue(""),
+                          MakeStringAccessor(&UdpCacheServer::m_originMapFile),
+                          MakeStringChecker())
             .AddTraceSource("Rx",
                             "A packet has been received",
                             MakeTraceSourceAccessor(&UdpCacheServer::m_rxTrace),
@@ -72,13 +416,88 @@ UdpCacheServer::GetTypeId()
 UdpCacheServer::UdpCacheServer()
 {
     NS_LOG_FUNCTION(this);
+    // read by the cluster and hierarchy statistics, also before the start
+    hitcount = 0;
+    accesscount = 0;
+    m_requestedIds = 0;
+    m_deferSends = false;
+    // IpContentServer, connected at the start
+    m_origins.resize(1);
 }
 
 UdpCacheServer::~UdpCacheServer()
 {
     NS_LOG_FUNCTION(this);
     m_socket_clients = nullptr;
-    m_socket_server = nullptr;
+    m_origins.clear();
+    m_socket_siblings = nullptr;
+}
+
+uint32_t
+UdpCacheServer::GetAccesses() const
+{
+    return accesscount;
+}
+
+uint32_t
+UdpCacheServer::GetHits() const
+{
+    return hitcount;
+}
+
+uint32_t
+UdpCacheServer::GetUpstreamRequests() const
+{
+    return m_requestedIds;
+}
+
+uint32_t
+UdpCacheServer::GetSiblingQueries() const
+{
+    return m_siblingQueries;
+}
+
+uint32_t
+UdpCacheServer::GetSiblingHits() const
+{
+    return m_siblingHits;
+}
+
+uint32_t
+UdpCacheServer::GetSiblingFalsePositives() const
+{
+    return m_siblingFalsePositives;
+}
+
+uint32_t
+UdpCacheServer::GetSiblingTimeouts() const
+{
+    return m_siblingTimeouts;
+}
+
+uint64_t
+UdpCacheServer::GetSummaryBytesSent() const
+{
+    return m_summaryBytesSent;
+}
+
+void
+UdpCacheServer::AddSibling(Address address)
+{
+    NS_ASSERT_MSG(InetSocketAddress::IsMatchingType(address), "Sibling caches are addressed by an InetSocketAddress");
+    m_siblings.push_back(address);
+}
+
+void
+UdpCacheServer::AddOrigin(Address address, uint32_t firstId, uint32_t lastId)
+{
+    NS_ASSERT_MSG(InetSocketAddress::IsMatchingType(address), "Content servers are addressed by an InetSocketAddress");
+    NS_ASSERT_MSG(firstId <= lastId, "Empty id range " << firstId << "-" << lastId);
+    Origin origin = Origin();
+    origin.address = address;
+    origin.firstId = firstId;
+    origin.lastId = lastId;
+    m_origins.push_back(origin);
 }
 
 void
@@ -86,6 +505,11 @@ UdpCacheServer::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     printOut();
+    m_cache = nullptr;
+    for (Origin& origin : m_origins)
+    {
+        origin.rtt = nullptr;
+    }
     Application::DoDispose();
 }
 
@@ -95,10 +519,104 @@ UdpCacheServer::StartApplication()
     NS_LOG_FUNCTION(this);
     hitcount = 0;
     accesscount = 0;
+    m_admitted = 0;
+    m_rejected = 0;
+    m_suppressed = 0;
+    m_waitersDropped = 0;
+    m_retransmissions = 0;
+    m_expired = 0;
+    m_originRequests = 0;
+    m_originSeq = 0;
+    m_originResponses = 0;
+    m_requestedIds = 0;
+    m_batchDelay = Time();
+    m_bytesServed = 0;
+    m_bytesHit = 0;
+    m_storageRejected = 0;
+    m_flashHits = 0;
+    m_ttlStored = 0;
+    m_staleServed = 0;
+    m_refreshes = 0;
+    m_refreshBytes = 0;
+    m_staleIfErrorServed = 0;
+    m_expiredMisses = 0;
+    m_objectsExpired = 0;
+    m_invalidationDatagrams = 0;
+    m_invalidationBytes = 0;
+    m_invalidationsReceived = 0;
+    m_invalidated = 0;
+    m_updateBytes = 0;
+    m_updatesIgnored = 0;
+    m_staleCopies = 0;
+    m_stalenessSum = Time();
+    m_stalenessMax = Time();
+    m_invalidationMisses = 0;
+    m_siblingQueries = 0;
+    m_siblingHits = 0;
+    m_siblingFalsePositives = 0;
+    m_siblingTimeouts = 0;
+    m_siblingServed = 0;
+    m_siblingMissed = 0;
+    m_summariesSent = 0;
+    m_summaryBytesSent = 0;
+    m_summaryBytesReceived = 0;
+    m_originBusy = 0;
+    m_siblingFetches.clear();
+    m_expirations.clear();
+    m_refreshing.clear();
+    m_versions.clear();
+    m_invalidatedIds.clear();
+    m_startTime = Simulator::Now();
+    m_cores.Configure(m_coreCount, m_coreQueueSize);
+    m_deferSends = false;
+    m_deferredSends.clear();
+    m_storage.Configure(m_storageCapacity, m_slabPageSize, m_slabMinChunk, m_slabGrowthFactor, m_slabRebalance);
+    // with a storage, the policy never fills before the slabs do
+    m_capacity = m_storage.IsEnabled() ? m_storage.GetMaxItems() : m_cacheSize;
+    m_cache = CreateCache(m_capacity);
+    // the slab classes pick the victims, neither another policy nor the
+    // admission filter would ever be asked
+    if (m_storage.IsEnabled() && (m_cache->GetName().compare(0, 3, "LRU") != 0 || m_admissionFilter))
+    {
+        NS_FATAL_ERROR("StorageCapacity evicts per slab class in LRU order, it needs the LRU "
+                       "EvictionPolicy and no AdmissionFilter");
+    }
+    m_flash.Configure(m_flashCapacity,
+                      m_flashRegionSize,
+                      m_flashReadLatency,
+                      m_flashWriteLatency,
+                      m_flashBandwidth,
+                      m_flashAdmission,
+                      m_flashAdmitProbability,
+                      m_flashMaxObjectSize,
+                      m_flashReinsertHits);
+    m_pendingFetches.SetMaxWaiters(m_maxWaiters);
+    m_fetchTimers.Configure(m_timerGranularity, Simulator::Now());
+    m_expirationTimers.Configure(m_expirationGranularity, Simulator::Now());
+    m_prefetch.Configure(m_prefetcher,
+                         m_catalogueSize,
+                         m_prefetchDegree,
+                         m_prefetchBudget,
+                         m_adaptivePrefetch,
+                         m_prefetchTableSize ? m_prefetchTableSize : 10 * m_cacheSize);
+    if (m_admissionFilter)
+    {
+        m_tinyLfu.Configure(m_sketchWidth ? m_sketchWidth : 4 * m_cacheSize,
+                            m_sketchResetPeriod ? m_sketchResetPeriod : 10 * m_cacheSize);
+    }
 
     if(contentServerAddress.IsInvalid()){
         NS_FATAL_ERROR("Fatal Error: Content server address not valid");
     }
+    if (m_placement == LEAVE_COPY_DOWN && m_protocol == CacheProtocolHeader::TEXT) {
+        NS_FATAL_ERROR("Leave-copy-down needs the BINARY protocol");
+    }
+    if (!m_siblings.empty() && m_protocol == CacheProtocolHeader::TEXT) {
+        NS_FATAL_ERROR("Sibling caches need the BINARY protocol");
+    }
+    if (!m_siblings.empty() && !m_summaryInterval.IsStrictlyPositive()) {
+        NS_FATAL_ERROR("Sibling caches need a positive SummaryInterval");
+    }
 
     if (!m_socket_clients)
     {
@@ -112,39 +630,32 @@ UdpCacheServer::StartApplication()
     }
 
     m_socket_clients->SetRecvCallback(MakeCallback(&UdpCacheServer::HandleReadClients, this));
+    m_clientSender.Configure(m_socket_clients, m_mtu, m_pacingRate, m_sendWindow);
 
 
-    if (!m_socket_server)
-    {
-        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-        m_socket_server = Socket::CreateSocket(GetNode(), tid);
+    loadOriginMap();
+    connectOrigins();
 
-        if (Ipv4Address::IsMatchingType(contentServerAddress) == true)
-        {
-            if (m_socket_server->Bind() == -1)
-            {
-                NS_FATAL_ERROR("Failed to bind socket");
-            }
-            contentServerAddress = InetSocketAddress(Ipv4Address::ConvertFrom(contentServerAddress), m_port_server);
-            if(m_socket_server->Connect(contentServerAddress)==-1){
-                NS_FATAL_ERROR("Failed to connect socket to content server");
-            }
-        }
-        else if (InetSocketAddress::IsMatchingType(contentServerAddress) == true)
+    if (!m_siblings.empty())
+    {
+        // k = ln 2 * m / n minimizes the false positives of a full cache
+        uint32_t hashes = m_summaryHashes ? m_summaryHashes : std::max<uint32_t>(1, std::lround(0.693 * m_summaryBitsPerObject));
+        m_summary.Configure(std::max<uint64_t>(64, uint64_t(m_summaryBitsPerObject) * m_cacheSize), hashes);
+        m_siblingSummaries.assign(m_siblings.size(), BloomFilter());
+        m_summaryChunks.assign(m_siblings.size(), SummaryChunks());
+        if (!m_socket_siblings)
         {
-            if (m_socket_server->Bind() == -1)
+            TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+            m_socket_siblings = Socket::CreateSocket(GetNode(), tid);
+            if (m_socket_siblings->Bind() == -1)
             {
-                NS_FATAL_ERROR("Failed to bind socket");
+                NS_FATAL_ERROR("Failed to bind socket siblings");
             }
-            m_socket_server->Connect(contentServerAddress);
-        }
-        else
-        {
-            NS_ASSERT_MSG(false, "Incompatible address type: " << contentServerAddress);
         }
+        // sibling responses are parsed as those of the content server
+        m_socket_siblings->SetRecvCallback(MakeCallback(&UdpCacheServer::HandleReadServer, this));
+        m_summaryEvent = Simulator::Schedule(m_summaryInterval, &UdpCacheServer::sendSummary, this);
     }
-
-    m_socket_server->SetRecvCallback(MakeCallback(&UdpCacheServer::HandleReadServer, this));
 }
 
 void
@@ -152,6 +663,9 @@ UdpCacheServer::StopApplication()
 {
     NS_LOG_FUNCTION(this);
     printOut();
+    printSlabStats();
+    printCoreStats();
+    printOriginStats();
 
     if (m_socket_clients)
     {
@@ -159,18 +673,87 @@ UdpCacheServer::StopApplication()
         m_socket_clients->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
 
-    if (m_socket_server)
+    for (Origin& origin : m_origins)
+    {
+        if (origin.socket)
+        {
+            origin.socket->Close();
+            origin.socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        }
+        Simulator::Cancel(origin.batchEvent);
+        origin.batch.clear();
+    }
+
+    if (m_socket_siblings)
+    {
+        m_socket_siblings->Close();
+        m_socket_siblings->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+
+    Simulator::Cancel(m_fetchTimersEvent);
+    Simulator::Cancel(m_expirationTimersEvent);
+    Simulator::Cancel(m_summaryEvent);
+    m_siblingFetches.clear();
+    m_fetchTimers.Clear();
+    m_expirationTimers.Clear();
+    m_pendingFetches.Clear();
+    m_refreshing.clear();
+    m_clientSender.Stop();
+    m_reassembly.Clear();
+    for (EventId& read : m_flashReads)
+    {
+        Simulator::Cancel(read);
+    }
+    m_flashReads.clear();
+    for (EventId& send : m_coreSends)
+    {
+        Simulator::Cancel(send);
+    }
+    m_coreSends.clear();
+    m_deferredSends.clear();
+}
+
+Ptr<CacheEvictionPolicy>
+UdpCacheServer::CreateCache(uint32_t capacity)
+{
+    if (m_smallCacheMode && capacity <= m_smallCacheThreshold &&
+        FlatCachePolicy::IsSupported(m_evictionPolicy))
     {
-        m_socket_server->Close();
-        m_socket_server->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        return Create<FlatCachePolicy>(m_evictionPolicy, capacity);
     }
+    return CacheEvictionPolicy::CreatePolicy(m_evictionPolicy, capacity);
 }
 
 void
 UdpCacheServer::HandleReadClients(Ptr<Socket> socket)
 {
     NS_LOG_FUNCTION(this << socket);
+    processClientPackets(socket, *m_cache);
+}
+
+void
+UdpCacheServer::HandleReadServer(Ptr<Socket> socketP2P)
+{
+    NS_LOG_FUNCTION(this << socketP2P);
+    processServerPackets(socketP2P, *m_cache);
+}
+
+void
+UdpCacheServer::HandleFetchTimers()
+{
+    processFetchTimers(*m_cache);
+}
+
+void
+UdpCacheServer::HandleExpirationTimers()
+{
+    processExpirationTimers(*m_cache);
+}
 
+template <typename Cache>
+void
+UdpCacheServer::processClientPackets(Ptr<Socket> socket, Cache& cache)
+{
     Ptr<Packet> packet;
     Address from;
     Address localAddress;
@@ -187,44 +770,183 @@ UdpCacheServer::HandleReadClients(Ptr<Socket> socket)
         /* packet->RemoveAllPacketTags();
         packet->RemoveAllByteTags(); */
 
-        uint32_t value_from_pkt = getIdPacket(packet);
-        accesscount++;
-
-        NS_LOG_LOGIC("Check in the cache if the packet with random value " << value_from_pkt << " is present");
-        if (cacheContains(value_from_pkt))
+        if (CacheProtocolHeader::IsBinary(packet))
         {
-            // Serve the packet from cache
-            sendPacketBackToClient(value_from_pkt, from);
-            hitcount++;
-
-            if (InetSocketAddress::IsMatchingType(from))
+            CacheProtocolHeader header;
+            packet->PeekHeader(header);
+            if (header.GetMessageType() == CacheProtocolHeader::SUMMARY)
             {
-                NS_LOG_INFO("Cache hit: Serving packet with random value " << value_from_pkt);
-                NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " cache sent " << packet->GetSize() << " bytes to client " << InetSocketAddress::ConvertFrom(from).GetIpv4() << " on port " << InetSocketAddress::ConvertFrom(from).GetPort());
+                receiveSummary(packet, from);
+                continue;
             }
         }
-        else
+
+        // a child cache may batch several requests in one datagram
+        getRequestsPacket(packet, m_clientRequests);
+        for (const CacheProtocolHeader& request : m_clientRequests)
         {
-            if (InetSocketAddress::IsMatchingType(contentServerAddress))
+            uint32_t seq = request.GetSequence();
+            uint32_t value_from_pkt = static_cast<uint32_t>(request.GetObjectId());
+            uint32_t core = 0;
+            if (m_cores.IsEnabled())
+            {
+                // a full core drops the request unparsed, as a full receive ring would
+                core = m_cores.Steer(getSteeringKey(value_from_pkt, from));
+                if (!m_cores.Admit(core, Simulator::Now()))
+                {
+                    NS_LOG_LOGIC("Queue of core " << core << " full, request for id " << value_from_pkt << " dropped");
+                    continue;
+                }
+            }
+            beginCoreJob();
+            // siblings only look into the cache, they are not clients
+            if (request.GetFlags() & CacheProtocolHeader::SIBLING)
+            {
+                answerSibling(cache, request, from);
+                endCoreJob(core);
+                continue;
+            }
+            accesscount++;
+            if (m_admissionFilter)
+            {
+                m_tinyLfu.RecordAccess(value_from_pkt);
+            }
+
+            NS_LOG_LOGIC("Check in the cache if the packet with random value " << value_from_pkt << " is present");
+            bool hit = cache.Lookup(value_from_pkt);
+            bool flashHit = !hit && m_flash.IsEnabled() && m_flash.Contains(value_from_pkt);
+            if ((hit || flashHit) && !m_expirations.empty())
+            {
+                auto expiration = m_expirations.find(value_from_pkt);
+                if (expiration != m_expirations.end() && expiration->second <= Simulator::Now())
+                {
+                    if (Simulator::Now() < expiration->second + m_staleWhileRevalidate)
+                    {
+                        // served stale right away, one background request refreshes it
+                        m_staleServed++;
+                        if (fetchFromContentServer(value_from_pkt, CacheProtocolHeader::REFRESH))
+                        {
+                            m_refreshes++;
+                            m_refreshing.insert(value_from_pkt);
+                        }
+                    }
+                    else
+                    {
+                        // too old to serve without the origin, kept for stale-if-error
+                        hit = false;
+                        flashHit = false;
+                        m_expiredMisses++;
+                    }
+                }
+            }
+            // the first request for a prefetched id triggers the next prefetch, as a miss does
+            bool prefetchHit = m_prefetch.IsEnabled() && m_prefetch.RecordAccess(value_from_pkt, hit || flashHit);
+            if (flashHit)
+            {
+                // the response waits for the device; completed reads are dropped from the front
+                uint32_t objectSize;
+                Time delay = m_flash.Read(value_from_pkt, Simulator::Now(), objectSize);
+                while (!m_flashReads.empty() && !m_flashReads.front().IsRunning())
+                {
+                    m_flashReads.pop_front();
+                }
+                m_flashReads.push_back(Simulator::Schedule(delay,
+                                                           &UdpCacheServer::completeFlashRead<Cache>,
+                                                           this,
+                                                           &cache,
+                                                           value_from_pkt,
+                                                           objectSize,
+                                                           from,
+                                                           seq,
+                                                           core));
+                hitcount++;
+                m_flashHits++;
+                if (prefetchHit)
+                {
+                    prefetchData(cache, value_from_pkt);
+                }
+                NS_LOG_INFO("Flash hit: packet with random value " << value_from_pkt << " served in " << delay.As(Time::US));
+            }
+            else if (hit)
+            {
+                // Serve the packet from cache
+                m_storage.Touch(value_from_pkt);
+                auto size = m_objectSizes.find(value_from_pkt);
+                if (size != m_objectSizes.end() && m_protocol == CacheProtocolHeader::BINARY)
+                {
+                    sendObjectToClient(value_from_pkt, size->second, from, seq, CacheProtocolHeader::CACHED);
+                    m_bytesHit += size->second;
+                }
+                else
+                {
+                    sendPacketBackToClient(value_from_pkt, from, seq, CacheProtocolHeader::CACHED);
+                }
+                hitcount++;
+                m_serviceTime += m_hitTime;
+                if (prefetchHit)
+                {
+                    prefetchData(cache, value_from_pkt);
+                }
+
+                if (InetSocketAddress::IsMatchingType(from))
+                {
+                    NS_LOG_INFO("Cache hit: Serving packet with random value " << value_from_pkt);
+                    NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " cache sent " << packet->GetSize() << " bytes to client " << InetSocketAddress::ConvertFrom(from).GetIpv4() << " on port " << InetSocketAddress::ConvertFrom(from).GetPort());
+                }
+            }
+            else
             {
-                NS_LOG_INFO("Cache miss: Requesting packet with random value " << value_from_pkt << " to the content server " << InetSocketAddress::ConvertFrom(contentServerAddress).GetIpv4() << " on port " << InetSocketAddress::ConvertFrom(contentServerAddress).GetPort());
+                m_serviceTime += m_missTime;
+                if (!m_invalidatedIds.empty() && m_invalidatedIds.erase(value_from_pkt) > 0)
+                {
+                    // would have been a hit without the update
+                    m_invalidationMisses++;
+                }
+                const Address& originAddress = m_origins[getOrigin(value_from_pkt)].address;
+                NS_LOG_INFO("Cache miss: Requesting packet with random value " << value_from_pkt << " to the content server " << InetSocketAddress::ConvertFrom(originAddress).GetIpv4() << " on port " << InetSocketAddress::ConvertFrom(originAddress).GetPort());
+                // a sibling whose summary holds the id is asked before the content server
+                bool fetched;
+                uint32_t sibling;
+                if (!m_pendingFetches.IsPending(value_from_pkt) && findSibling(value_from_pkt, 0, sibling))
+                {
+                    fetched = fetchFromSibling(value_from_pkt, sibling);
+                }
+                else
+                {
+                    fetched = fetchFromContentServer(value_from_pkt);
+                }
+                if (fetched || prefetchHit)
+                {
+                    prefetchData(cache, value_from_pkt);
+                }
+                if (!m_pendingFetches.AddWaiter(value_from_pkt, from, seq))
+                {
+                    m_waitersDropped++;
+                    NS_LOG_LOGIC("Too many clients waiting for packet with id " << value_from_pkt << ", request dropped");
+                }
             }
-            requestPacketToContentServer(value_from_pkt);
-            prefetchData(value_from_pkt);
-            requestQueue.insert(std::pair<uint32_t, Address>(value_from_pkt, from));
+            endCoreJob(core);
         }
 
     }
 }
 
+template <typename Cache>
 void
-UdpCacheServer::HandleReadServer(Ptr<Socket> socketP2P)
+UdpCacheServer::processServerPackets(Ptr<Socket> socketP2P, Cache& cache)
 {
-    NS_LOG_FUNCTION(this << socketP2P);
-
     Ptr<Packet> packet;
     Address from;
     Address localAddress;
+    // null for the socket of the siblings
+    Origin* origin = nullptr;
+    for (Origin& candidate : m_origins)
+    {
+        if (candidate.socket == socketP2P)
+        {
+            origin = &candidate;
+        }
+    }
 
     while ((packet = socketP2P->RecvFrom(from)))
     {
@@ -239,22 +961,151 @@ UdpCacheServer::HandleReadServer(Ptr<Socket> socketP2P)
         /* packet->RemoveAllPacketTags();
         packet->RemoveAllByteTags(); */
 
-        uint32_t value_from_pkt = getIdPacket(packet);
+        bool binary = CacheProtocolHeader::IsBinary(packet);
+        CacheProtocolHeader header;
+        if (binary)
+        {
+            packet->PeekHeader(header);
+        }
+        if (binary && header.GetMessageType() == CacheProtocolHeader::INVALIDATE)
+        {
+            m_invalidationDatagrams++;
+            m_invalidationBytes += packet->GetSize();
+            CacheVersionHeader version;
+            while (packet->GetSize() >= header.GetSerializedSize() + version.GetSerializedSize())
+            {
+                packet->RemoveHeader(header);
+                packet->RemoveHeader(version);
+                m_invalidationsReceived++;
+                invalidateObject(cache, static_cast<uint32_t>(header.GetObjectId()), version.GetVersion(), version.GetUpdated());
+            }
+            continue;
+        }
+        if (binary && (header.GetFlags() & CacheProtocolHeader::MISS))
+        {
+            // false positive of a sibling summary: the next sibling whose summary
+            // holds the id is asked, the content server after the last one
+            uint32_t id = static_cast<uint32_t>(header.GetObjectId());
+            PendingFetch* fetch = m_pendingFetches.Find(id);
+            auto asked = m_siblingFetches.find(id);
+            if (fetch && asked != m_siblingFetches.end())
+            {
+                m_siblingFalsePositives++;
+                uint32_t sibling;
+                if (findSibling(id, asked->second + 1, sibling))
+                {
+                    requestToSibling(id, sibling, *fetch);
+                }
+                else
+                {
+                    m_siblingFetches.erase(asked);
+                    fallBackToContentServer(id, *fetch);
+                }
+            }
+            continue;
+        }
+        if (binary ? (header.GetFlags() & CacheProtocolHeader::BUSY) != 0
+                   : CacheProtocolHeader::IsTextBusy(packet, m_rxBuffer))
+        {
+            // the content server shed the request: an expired copy answers now
+            // as on a failure, else the request is sent again after a backoff
+            // that does not count against MaxRetries
+            uint32_t id = binary ? static_cast<uint32_t>(header.GetObjectId())
+                                 : CacheProtocolHeader::ReadTextId(packet, m_rxBuffer);
+            m_originBusy++;
+            m_origins[getOrigin(id)].busy++;
+            PendingFetch* fetch = m_pendingFetches.Find(id);
+            if (fetch && canServeOnError(cache, id))
+            {
+                abandonFetch(cache, id);
+            }
+            else if (fetch)
+            {
+                fetch->shed++;
+                fetch->backoff = true;
+                armFetchTimer(id, *fetch);
+            }
+            continue;
+        }
 
-        NS_LOG_LOGIC("Check in the cache if the packet with random value " << value_from_pkt << " is present");
-        if (!cacheContains(value_from_pkt))
+        m_originResponses++;
+        if (origin)
+        {
+            origin->responses++;
+        }
+        if (binary && (header.GetFlags() & CacheProtocolHeader::SEGMENT))
         {
-            pushInCache(value_from_pkt);
+            Ptr<Packet> payload = packet->Copy();
+            CacheTtlHeader ttl;
+            CacheVersionHeader version;
+            CacheSegmentHeader segment;
+            payload->RemoveHeader(header);
+            if (header.GetFlags() & CacheProtocolHeader::TTL)
+            {
+                payload->RemoveHeader(ttl);
+            }
+            if (header.GetFlags() & CacheProtocolHeader::VERSION)
+            {
+                payload->RemoveHeader(version);
+            }
+            payload->RemoveHeader(segment);
+            uint32_t id = static_cast<uint32_t>(header.GetObjectId());
+            bool accepted = m_pendingFetches.IsPending(id);
+            if (header.GetFlags() & CacheProtocolHeader::UPDATE)
+            {
+                // pushed updates only refresh the objects this cache holds
+                m_updateBytes += packet->GetSize();
+                accepted = accepted || cache.Contains(id) || (m_flash.IsEnabled() && m_flash.Contains(id));
+                if (!accepted && segment.GetOffset() == 0)
+                {
+                    m_updatesIgnored++;
+                }
+            }
+            // segments of a fetch that completed or expired are late duplicates
+            bool complete = accepted &&
+                            m_reassembly.AddSegment(id, segment.GetObjectSize(), segment.GetOffset(), payload->GetSize());
+            PendingFetch* fetch = complete ? nullptr : m_pendingFetches.Find(id);
+            if (fetch)
+            {
+                // the object is still arriving: its timer runs from the last segment
+                armFetchTimer(id, *fetch);
+            }
+            if (complete)
+            {
+                OriginResponse response{id,
+                                        header.GetFlags(),
+                                        ttl.GetTtl(),
+                                        version.GetVersion(),
+                                        version.GetUpdated(),
+                                        header.GetRole() == CacheProtocolHeader::CACHE &&
+                                            !(header.GetFlags() & CacheProtocolHeader::CACHED)};
+                uint32_t core = m_cores.IsEnabled() ? m_cores.Steer(getSteeringKey(id, from)) : 0;
+                beginCoreJob();
+                storeFetchedObject(cache, response, segment.GetObjectSize(), 0);
+                endCoreJob(core);
+            }
+            continue;
         }
-        // get the list of clients that requested the packet from the requestQueue, iterate it and send the packet to each client
 
-        std::multimap<uint32_t, ns3::Address>::iterator requestQueueIter = requestQueue.find(value_from_pkt);
-        
-        while (requestQueueIter != requestQueue.end() && requestQueueIter->first == value_from_pkt)
+        getResponsesPacket(packet, m_responses);
+        // objects of a batched response share the datagram
+        uint32_t wireSize = m_responses.empty() ? 0 : packet->GetSize() / m_responses.size();
+        for (const OriginResponse& response : m_responses)
         {
-            sendPacketBackToClient(value_from_pkt, requestQueueIter->second);
-            // remove the client from the requestQueue
-            requestQueue.erase(requestQueueIter++);
+            if (response.flags & CacheProtocolHeader::UPDATE)
+            {
+                m_updateBytes += wireSize;
+                if (!m_pendingFetches.IsPending(response.id) && !cache.Contains(response.id) &&
+                    !(m_flash.IsEnabled() && m_flash.Contains(response.id)))
+                {
+                    m_updatesIgnored++;
+                    continue;
+                }
+            }
+            uint32_t core = m_cores.IsEnabled() ? m_cores.Steer(getSteeringKey(response.id, from)) : 0;
+            beginCoreJob();
+            storeFetchedObject(cache, response, 0, wireSize);
+            endCoreJob(core);
         }
 
         if (InetSocketAddress::IsMatchingType(from))
@@ -264,104 +1115,1344 @@ UdpCacheServer::HandleReadServer(Ptr<Socket> socketP2P)
     }
 }
 
-uint32_t
-UdpCacheServer::getIdPacket(Ptr<Packet> packet)
+template <typename Cache>
+void
+UdpCacheServer::storeFetchedObject(Cache& cache, const OriginResponse& response, uint32_t objectSize, uint32_t wireSize)
 {
-    uint8_t* buffer = new uint8_t[packet->GetSize()];
-    packet->CopyData(buffer, packet->GetSize());
-    std::string payload = std::string(reinterpret_cast<char*>(buffer), packet->GetSize());
-    std::regex six_digit_number_regex(R"(\b\d{1,6}\b)");
-
-    std::smatch matches;
-    if (std::regex_search(payload, matches, six_digit_number_regex))
+    uint32_t value_from_pkt = response.id;
+    bool fromSibling = !m_siblingFetches.empty() && !(response.flags & CacheProtocolHeader::UPDATE) &&
+                       m_siblingFetches.erase(value_from_pkt) > 0;
+    if (fromSibling)
     {
-        std::string id = matches[0];
-        return static_cast<uint32_t>(std::stoul(id));
+        m_siblingHits++;
     }
-    else
+    // the fetch time of an object we never asked for is unknown, fall back to rttCacheMiss
+    Time fetchTime = m_RTTCacheMiss;
+    PendingFetch fetch;
+    if (m_pendingFetches.Complete(value_from_pkt, fetch))
     {
-        // handle whenever the id is not found
-        return 0;
+        fetchTime = Simulator::Now() - fetch.start;
+        // Karn's algorithm: the response of a retransmitted request is ambiguous;
+        // the fetch time of a shed request includes its backoff, and the RTT of
+        // a sibling says nothing about the content server
+        if (fetch.retries == 0 && fetch.shed == 0 && !fromSibling)
+        {
+            m_origins[getOrigin(value_from_pkt)].rtt->Measurement(fetchTime);
+        }
+        NS_LOG_LOGIC("Packet with id " << value_from_pkt << " fetched in " << fetchTime.As(Time::MS));
     }
-}
-
-void UdpCacheServer::sendPacketBackToClient(uint32_t value_to_send, Address to){
-
-    std::string message = "{ \"sender\": \"cache\", \"type\": \"response\", \"id\": " + std::to_string(value_to_send) + " }";
-
-    uint32_t dataSize = message.size() + 1;
-    uint8_t* m_data = new uint8_t[dataSize];
-
-    memcpy(m_data, message.c_str(), dataSize);
-
-    Ptr<Packet> packet = Create<Packet>(m_data, dataSize);
-    m_socket_clients->SendTo(packet, 0, to);
-}
 
-void UdpCacheServer::requestPacketToContentServer(uint32_t value_to_send){
-
-
-    std::string message = "{ \"sender\": \"cache\", \"type\": \"request\", \"id\": " + std::to_string(value_to_send) + " }";
-    uint32_t dataSize = message.size() + 1;
-    uint8_t* m_data = new uint8_t[dataSize];
-
-    memcpy(m_data, message.c_str(), dataSize);
+    if (response.flags & CacheProtocolHeader::VERSION)
+    {
+        auto known = m_versions.find(value_from_pkt);
+        if (known != m_versions.end() && known->second < response.version)
+        {
+            recordStaleness(response.updated);
+        }
+    }
+    // an update of an object on flash goes to memory, as a read would
+    if ((response.flags & CacheProtocolHeader::UPDATE) && m_flash.IsEnabled())
+    {
+        m_flash.Remove(value_from_pkt);
+    }
 
-    Ptr<Packet> packet = Create<Packet>(m_data, dataSize);
-    m_socket_server->Send(packet);
-}
+    // with leave-copy-down, only the level below the one that held the object keeps it
+    bool keep = m_placement == LEAVE_COPY_EVERYWHERE || (m_placement == LEAVE_COPY_DOWN && !response.relayed);
+    NS_LOG_LOGIC("Check in the cache if the packet with random value " << value_from_pkt << " is present");
+    if (keep && !cache.Contains(value_from_pkt))
+    {
+        pushInCache(cache, value_from_pkt, fetchTime, objectSize > 0 ? objectSize : wireSize);
+        if (objectSize > 0 && cache.Contains(value_from_pkt))
+        {
+            m_objectSizes[value_from_pkt] = objectSize;
+        }
+    }
+    // a fresh copy, also of an object that was cached stale
+    if (cache.Contains(value_from_pkt))
+    {
+        setExpiration(value_from_pkt, response.ttl.IsZero() ? m_defaultTtl : response.ttl);
+        if (response.flags & CacheProtocolHeader::VERSION)
+        {
+            m_versions[value_from_pkt] = response.version;
+        }
+    }
+    if (m_refreshing.erase(value_from_pkt) > 0)
+    {
+        m_refreshBytes += objectSize > 0 ? objectSize : wireSize;
+    }
 
-void UdpCacheServer::pushInCache(const uint32_t& item) {
-    if (m_cache.size() >= m_cacheSize) {
-        m_cache.pop_front();
+    if (objectSize > 0 && m_protocol == CacheProtocolHeader::BINARY)
+    {
+        for (const PendingWaiter& waiter : fetch.waiters)
+        {
+            sendObjectToClient(value_from_pkt, objectSize, waiter.address, waiter.seq);
+        }
+    }
+    // build the response once and send a copy-on-write copy of it to every
+    // client that waited for it, the last one getting the original
+    else if (!fetch.waiters.empty())
+    {
+        Ptr<Packet> response = createPacketForClient(value_from_pkt);
+        for (uint32_t i = 0; i < fetch.waiters.size(); i++)
+        {
+            const PendingWaiter& waiter = fetch.waiters[i];
+            sendPacketBackToClient(i + 1 < fetch.waiters.size() ? response->Copy() : response,
+                                   value_from_pkt,
+                                   waiter.address,
+                                   waiter.seq);
+        }
     }
-    m_cache.push_back(item);
 }
 
-bool UdpCacheServer::cacheContains(const uint32_t& item) {
-    for (const auto& val : m_cache) {
-        if (val == item) {
-            return true;
+template <typename Cache>
+void
+UdpCacheServer::completeFlashRead(Cache* cache, uint32_t value_from_pkt, uint32_t objectSize, Address to, uint32_t seq, uint32_t core)
+{
+    // the request was parsed on arrival, the core now builds the response
+    beginCoreJob();
+    m_serviceTime = m_hitTime;
+    // promoted back to memory, which drops the flash copy
+    if (!cache->Contains(value_from_pkt))
+    {
+        pushInCache(*cache, value_from_pkt, Time(), objectSize);
+        if (objectSize > 0 && cache->Contains(value_from_pkt))
+        {
+            m_objectSizes[value_from_pkt] = objectSize;
         }
     }
-    return false;
-}
 
-bool UdpCacheServer::pushIfNotContained(const uint32_t& item) {
-    if (!cacheContains(item)) {
-        pushInCache(item);
-        return false;
+    if (objectSize > 0 && m_protocol == CacheProtocolHeader::BINARY)
+    {
+        sendObjectToClient(value_from_pkt, objectSize, to, seq, CacheProtocolHeader::CACHED);
+        m_bytesHit += objectSize;
     }
-    return true;
+    else
+    {
+        sendPacketBackToClient(value_from_pkt, to, seq, CacheProtocolHeader::CACHED);
+    }
+    endCoreJob(core);
 }
 
-void UdpCacheServer::prefetchData(uint32_t value) {
-    
-    for (size_t i = 1; i < 3 && value-i > 0; i++)
+template <typename Cache>
+void
+UdpCacheServer::answerSibling(Cache& cache, const CacheProtocolHeader& request, const Address& from)
+{
+    uint32_t id = static_cast<uint32_t>(request.GetObjectId());
+    bool fresh = cache.Lookup(id);
+    if (fresh && !m_expirations.empty())
     {
-        if(!cacheContains(value-i)){
-            requestPacketToContentServer(value-i);
-        }
+        auto expiration = m_expirations.find(id);
+        fresh = expiration == m_expirations.end() || Simulator::Now() < expiration->second;
     }
-    for (size_t i = 1; i < 3 && value+i < 101; i++)
+    if (!fresh)
     {
-        if(!cacheContains(value+i)){
-            requestPacketToContentServer(value+i);
-        }
+        CacheProtocolHeader header;
+        header.SetMessageType(CacheProtocolHeader::RESPONSE);
+        header.SetRole(CacheProtocolHeader::CACHE);
+        header.SetFlags(CacheProtocolHeader::MISS);
+        header.SetSequence(request.GetSequence());
+        header.SetObjectId(id);
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(header);
+        sendDatagram(m_socket_clients, packet, from);
+        m_siblingMissed++;
+        m_serviceTime += m_missTime;
+        return;
     }
-}
 
-void UdpCacheServer::printOut(){
+    m_storage.Touch(id);
+    auto size = m_objectSizes.find(id);
+    if (size != m_objectSizes.end())
+    {
+        sendObjectToClient(id, size->second, from, request.GetSequence(), CacheProtocolHeader::CACHED);
+        m_bytesHit += size->second;
+    }
+    else
+    {
+        sendPacketBackToClient(id, from, request.GetSequence(), CacheProtocolHeader::CACHED);
+    }
+    m_siblingServed++;
+    m_serviceTime += m_hitTime;
+}
 
-    std::ofstream outputFile("output/cachestats.txt");
-    
-    if (!outputFile.is_open()) {
-        std::cerr << "Error opening file cachestats.txt" << std::endl;
+template <typename Cache>
+void
+UdpCacheServer::invalidateObject(Cache& cache, uint32_t id, uint32_t version, Time updated)
+{
+    auto known = m_versions.find(id);
+    if (known == m_versions.end() || known->second >= version)
+    {
         return;
     }
-    outputFile << "cachehits:" << hitcount << ";" << "cacheaccess:" << accesscount << ";" << std::endl;
-    outputFile.close();
+    // versions of objects the flash tier dropped on its own are left behind
+    if (!cache.Contains(id) && !(m_flash.IsEnabled() && m_flash.Contains(id)))
+    {
+        m_versions.erase(known);
+        return;
+    }
+    recordStaleness(updated);
+    if (cache.Contains(id))
+    {
+        evictFromCache(cache, id, false);
+    }
+    else
+    {
+        m_flash.Remove(id);
+        m_expirations.erase(id);
+        m_versions.erase(id);
+    }
+    m_invalidated++;
+    m_invalidatedIds.insert(id);
+    NS_LOG_LOGIC("Packet with id " << id << " invalidated, version " << version);
 }
 
+void
+UdpCacheServer::recordStaleness(Time updated)
+{
+    Time window = Simulator::Now() - updated;
+    m_staleCopies++;
+    m_stalenessSum += window;
+    m_stalenessMax = std::max(m_stalenessMax, window);
+}
+
+void
+UdpCacheServer::getResponsesPacket(Ptr<Packet> packet, std::vector<OriginResponse>& responses)
+{
+    responses.clear();
+    if (CacheProtocolHeader::IsBinary(packet))
+    {
+        Ptr<Packet> copy = packet->Copy();
+        CacheProtocolHeader header;
+        CacheTtlHeader ttl;
+        CacheVersionHeader version;
+        while (copy->GetSize() >= header.GetSerializedSize())
+        {
+            copy->RemoveHeader(header);
+            OriginResponse response{static_cast<uint32_t>(header.GetObjectId()),
+                                    header.GetFlags(),
+                                    Time(),
+                                    0,
+                                    Time(),
+                                    header.GetRole() == CacheProtocolHeader::CACHE &&
+                                        !(header.GetFlags() & CacheProtocolHeader::CACHED)};
+            if (header.GetFlags() & CacheProtocolHeader::TTL)
+            {
+                copy->RemoveHeader(ttl);
+                response.ttl = ttl.GetTtl();
+            }
+            if (header.GetFlags() & CacheProtocolHeader::VERSION)
+            {
+                copy->RemoveHeader(version);
+                response.version = version.GetVersion();
+                response.updated = version.GetUpdated();
+            }
+            responses.push_back(response);
+        }
+        return;
+    }
+
+    // the text format only carries ids
+    CacheProtocolHeader::ReadTextIds(packet, m_rxBuffer, m_responseIds);
+    for (uint32_t id : m_responseIds)
+    {
+        responses.push_back(OriginResponse{id, 0, Time(), 0, Time(), false});
+    }
+}
+
+void
+UdpCacheServer::getRequestsPacket(Ptr<Packet> packet, std::vector<CacheProtocolHeader>& requests)
+{
+    requests.clear();
+    CacheProtocolHeader header;
+    if (CacheProtocolHeader::IsBinary(packet))
+    {
+        Ptr<Packet> copy = packet->Copy();
+        while (copy->GetSize() >= header.GetSerializedSize())
+        {
+            copy->RemoveHeader(header);
+            requests.push_back(header);
+        }
+        return;
+    }
+
+    CacheProtocolHeader::ReadTextIds(packet, m_rxBuffer, m_requestIds);
+    for (uint32_t id : m_requestIds)
+    {
+        header.SetObjectId(id);
+        requests.push_back(header);
+    }
+}
+
+void UdpCacheServer::sendPacketBackToClient(uint32_t value_to_send, Address to, uint32_t seq, uint16_t flags){
+
+    sendPacketBackToClient(createPacketForClient(value_to_send), value_to_send, to, seq, flags);
+}
+
+Ptr<Packet> UdpCacheServer::createPacketForClient(uint32_t value_to_send){
+
+    if (m_protocol == CacheProtocolHeader::BINARY) {
+        return Create<Packet>();
+    }
+    return CacheProtocolHeader::CreateTextPacket("cache", "response", value_to_send);
+}
+
+void UdpCacheServer::sendPacketBackToClient(Ptr<Packet> packet, uint32_t value_to_send, const Address& to, uint32_t seq, uint16_t flags){
+
+    if (m_protocol == CacheProtocolHeader::BINARY) {
+        CacheProtocolHeader header;
+        header.SetMessageType(CacheProtocolHeader::RESPONSE);
+        header.SetRole(CacheProtocolHeader::CACHE);
+        header.SetFlags(flags);
+        header.SetSequence(seq);
+        header.SetObjectId(value_to_send);
+        packet->AddHeader(header);
+    }
+    sendDatagram(m_socket_clients, packet, to);
+}
+
+void UdpCacheServer::sendObjectToClient(uint32_t value_to_send, uint32_t objectSize, const Address& to, uint32_t seq, uint16_t flags){
+
+    CacheProtocolHeader header;
+    header.SetMessageType(CacheProtocolHeader::RESPONSE);
+    header.SetRole(CacheProtocolHeader::CACHE);
+    header.SetFlags(flags);
+    header.SetSequence(seq);
+    header.SetObjectId(value_to_send);
+    if (m_deferSends) {
+        m_deferredSends.push_back({nullptr, nullptr, to, header, objectSize});
+    }
+    else {
+        m_clientSender.Send(header, objectSize, to);
+    }
+    m_bytesServed += objectSize;
+}
+
+void UdpCacheServer::requestPacketToContentServer(uint32_t value_to_send, uint16_t flags){
+
+    // every content server batches the ids it owns on its own
+    uint32_t index = getOrigin(value_to_send);
+    Origin& origin = m_origins[index];
+    origin.batch.push_back({value_to_send, flags, Simulator::Now()});
+    if (m_batchWindow.IsZero() || origin.batch.size() >= m_batchSize) {
+        flushBatch(index);
+    }
+    else if (origin.batch.size() == 1) {
+        origin.batchEvent = Simulator::Schedule(m_batchWindow, &UdpCacheServer::flushBatch, this, index);
+    }
+}
+
+void UdpCacheServer::flushBatch(uint32_t index){
+
+    Origin& origin = m_origins[index];
+    std::vector<BatchedRequest>& batch = origin.batch;
+    Simulator::Cancel(origin.batchEvent);
+    if (m_protocol == CacheProtocolHeader::BINARY) {
+        CacheProtocolHeader header;
+        header.SetMessageType(CacheProtocolHeader::REQUEST);
+        header.SetRole(CacheProtocolHeader::CACHE);
+        uint32_t perPacket = std::max<uint32_t>(1, m_maxPayloadSize / header.GetSerializedSize());
+        for (uint32_t first = 0; first < batch.size(); first += perPacket) {
+            uint32_t last = std::min<uint32_t>(first + perPacket, batch.size());
+            Ptr<Packet> packet = Create<Packet>();
+            // headers are prepended, add them backwards to keep the request order
+            for (uint32_t i = last; i-- > first;) {
+                header.SetFlags(batch[i].flags);
+                header.SetSequence(m_originSeq + i + 1);
+                header.SetObjectId(batch[i].id);
+                packet->AddHeader(header);
+            }
+            sendRequestToContentServer(index, packet);
+        }
+        m_originSeq += batch.size();
+    }
+    else if (batch.size() == 1) {
+        sendRequestToContentServer(index, CacheProtocolHeader::CreateTextPacket("cache", "request", batch.front().id));
+    }
+    else {
+        const std::string head = "{ \"sender\": \"cache\", \"type\": \"request\", \"ids\": [";
+        const std::string tail = "] }";
+        std::string message = head;
+        for (const auto& entry : batch) {
+            std::string id = std::to_string(entry.id);
+            // the request, null terminator included, must fit in one datagram
+            if (message.size() > head.size() && message.size() + id.size() + 2 + tail.size() + 1 > m_maxPayloadSize) {
+                sendRequestToContentServer(index, message + tail);
+                message = head;
+            }
+            if (message.size() > head.size()) {
+                message += ", ";
+            }
+            message += id;
+        }
+        sendRequestToContentServer(index, message + tail);
+    }
+
+    for (const auto& entry : batch) {
+        m_batchDelay += Simulator::Now() - entry.queuedAt;
+    }
+    m_requestedIds += batch.size();
+    origin.requestedIds += batch.size();
+    if (batch.size() > 1) {
+        NS_LOG_LOGIC("Requested a batch of " << batch.size() << " ids to the content server");
+    }
+    batch.clear();
+}
+
+void UdpCacheServer::sendRequestToContentServer(uint32_t origin, const std::string& message){
+
+    uint32_t dataSize = message.size() + 1;
+    sendRequestToContentServer(origin, Create<Packet>(reinterpret_cast<const uint8_t*>(message.c_str()), dataSize));
+}
+
+void UdpCacheServer::sendRequestToContentServer(uint32_t origin, Ptr<Packet> packet){
+
+    sendDatagram(m_origins[origin].socket, packet, Address());
+    m_origins[origin].requests++;
+    m_originRequests++;
+}
+
+uint32_t UdpCacheServer::getOrigin(uint32_t id) const{
+
+    if (m_origins.size() == 1) {
+        return 0;
+    }
+    if (m_originPartitioning == PARTITION_HASH) {
+        return static_cast<uint32_t>(SplitMix64(id, ORIGIN_SEED) % m_origins.size());
+    }
+    for (uint32_t i = 1; i < m_origins.size(); i++) {
+        if (id >= m_origins[i].firstId && id <= m_origins[i].lastId) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void UdpCacheServer::connectOrigins(){
+
+    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+    for (uint32_t i = 0; i < m_origins.size(); i++) {
+        Origin& origin = m_origins[i];
+        if (i == 0) {
+            if (Ipv4Address::IsMatchingType(contentServerAddress)) {
+                contentServerAddress = InetSocketAddress(Ipv4Address::ConvertFrom(contentServerAddress), m_port_server);
+            }
+            else if (!InetSocketAddress::IsMatchingType(contentServerAddress)) {
+                NS_ASSERT_MSG(false, "Incompatible address type: " << contentServerAddress);
+            }
+            origin.address = contentServerAddress;
+        }
+        if (!origin.socket) {
+            origin.socket = Socket::CreateSocket(GetNode(), tid);
+            if (origin.socket->Bind() == -1) {
+                NS_FATAL_ERROR("Failed to bind socket");
+            }
+            if (origin.socket->Connect(origin.address) == -1) {
+                NS_FATAL_ERROR("Failed to connect socket to content server " << origin.address);
+            }
+        }
+        origin.socket->SetRecvCallback(MakeCallback(&UdpCacheServer::HandleReadServer, this));
+        origin.rtt = CreateObject<RttMeanDeviation>();
+        origin.rtt->SetAttribute("InitialEstimation", TimeValue(m_RTTCacheMiss));
+        origin.rtt->Reset();
+        origin.requests = 0;
+        origin.requestedIds = 0;
+        origin.responses = 0;
+        origin.busy = 0;
+    }
+}
+
+void UdpCacheServer::loadOriginMap(){
+
+    if (m_originMapFile.empty()) {
+        return;
+    }
+    std::ifstream map(m_originMapFile);
+    if (!map.is_open()) {
+        NS_FATAL_ERROR("Failed to open origin map file " << m_originMapFile);
+    }
+    std::string line;
+    uint32_t added = 0;
+    while (std::getline(map, line)) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string ip;
+        uint32_t port;
+        if (!(fields >> ip >> port)) {
+            continue;
+        }
+        // without a range the content server is only asked with HASH partitioning
+        uint32_t firstId = 1;
+        uint32_t lastId = 0;
+        if (!(fields >> firstId >> lastId)) {
+            firstId = 1;
+            lastId = 0;
+        }
+        Origin origin = Origin();
+        origin.address = InetSocketAddress(Ipv4Address(ip.c_str()), static_cast<uint16_t>(port));
+        origin.firstId = firstId;
+        origin.lastId = lastId;
+        m_origins.push_back(origin);
+        added++;
+    }
+    NS_LOG_INFO("Read " << added << " content servers from " << m_originMapFile);
+    // read once, a restart keeps them
+    m_originMapFile.clear();
+}
+
+void UdpCacheServer::sendDatagram(Ptr<Socket> socket, Ptr<Packet> packet, const Address& to){
+
+    if (m_deferSends) {
+        m_deferredSends.push_back({socket, packet, to, CacheProtocolHeader(), 0});
+    }
+    else if (to.IsInvalid()) {
+        socket->Send(packet);
+    }
+    else {
+        socket->SendTo(packet, 0, to);
+    }
+}
+
+void UdpCacheServer::sendDeferred(std::vector<DeferredSend> sends){
+
+    for (const DeferredSend& send : sends) {
+        if (send.socket) {
+            sendDatagram(send.socket, send.packet, send.to);
+        }
+        else {
+            m_clientSender.Send(send.header, send.objectSize, send.to);
+        }
+    }
+}
+
+uint64_t UdpCacheServer::getSteeringKey(uint32_t id, const Address& from) const{
+
+    if (m_coreSteering == STEER_FLOW && InetSocketAddress::IsMatchingType(from)) {
+        InetSocketAddress flow = InetSocketAddress::ConvertFrom(from);
+        return uint64_t(flow.GetIpv4().Get()) << 16 | flow.GetPort();
+    }
+    return id;
+}
+
+void UdpCacheServer::beginCoreJob(){
+
+    m_deferSends = m_cores.IsEnabled();
+    m_serviceTime = m_parseTime;
+}
+
+void UdpCacheServer::endCoreJob(uint32_t core){
+
+    if (!m_deferSends) {
+        return;
+    }
+    m_deferSends = false;
+    Time delay = m_cores.Run(core, Simulator::Now(), m_serviceTime);
+    if (m_deferredSends.empty()) {
+        return;
+    }
+    // sent jobs are dropped from the front
+    while (!m_coreSends.empty() && !m_coreSends.front().IsRunning()) {
+        m_coreSends.pop_front();
+    }
+    m_coreSends.push_back(Simulator::Schedule(delay, &UdpCacheServer::sendDeferred, this, m_deferredSends));
+    m_deferredSends.clear();
+}
+
+bool
+UdpCacheServer::fetchFromContentServer(uint32_t id, uint16_t flags)
+{
+    if (!m_pendingFetches.AddFetch(id, Simulator::Now()))
+    {
+        m_suppressed++;
+        NS_LOG_LOGIC("Packet with id " << id << " already requested to the content server");
+        return false;
+    }
+    PendingFetch* fetch = m_pendingFetches.Find(id);
+    fetch->flags = flags;
+    requestPacketToContentServer(id, flags);
+    armFetchTimer(id, *fetch);
+    return true;
+}
+
+bool
+UdpCacheServer::findSibling(uint32_t id, uint32_t first, uint32_t& sibling) const
+{
+    for (uint32_t i = first; i < m_siblingSummaries.size(); i++)
+    {
+        if (m_siblingSummaries[i].Contains(id))
+        {
+            sibling = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+UdpCacheServer::fetchFromSibling(uint32_t id, uint32_t sibling)
+{
+    if (!m_pendingFetches.AddFetch(id, Simulator::Now()))
+    {
+        m_suppressed++;
+        return false;
+    }
+    requestToSibling(id, sibling, *m_pendingFetches.Find(id));
+    return true;
+}
+
+void
+UdpCacheServer::requestToSibling(uint32_t id, uint32_t sibling, PendingFetch& fetch)
+{
+    CacheProtocolHeader header;
+    header.SetMessageType(CacheProtocolHeader::REQUEST);
+    header.SetRole(CacheProtocolHeader::CACHE);
+    header.SetFlags(CacheProtocolHeader::SIBLING);
+    header.SetObjectId(id);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    sendDatagram(m_socket_siblings, packet, m_siblings[sibling]);
+    m_siblingFetches[id] = sibling;
+    m_siblingQueries++;
+    armFetchTimer(id, fetch);
+    NS_LOG_LOGIC("Packet with id " << id << " requested to sibling " << sibling);
+}
+
+void
+UdpCacheServer::fallBackToContentServer(uint32_t id, PendingFetch& fetch)
+{
+    // the origin RTT is measured from here
+    fetch.start = Simulator::Now();
+    requestPacketToContentServer(id);
+    armFetchTimer(id, fetch);
+}
+
+void
+UdpCacheServer::sendSummary()
+{
+    m_summary.Export(m_summaryBits);
+    m_summaryBits.Serialize(m_summaryBuffer);
+    CacheProtocolHeader header;
+    header.SetMessageType(CacheProtocolHeader::SUMMARY);
+    header.SetRole(CacheProtocolHeader::CACHE);
+    header.SetObjectId(m_summary.GetItems());
+    // a summary that does not fit a UDP datagram goes in chunks
+    uint32_t headers = header.GetSerializedSize() + CacheSegmentHeader().GetSerializedSize();
+    bool chunked = m_summaryBuffer.size() + header.GetSerializedSize() > MAX_UDP_PAYLOAD;
+    uint32_t chunkSize = chunked ? MAX_UDP_PAYLOAD - headers : m_summaryBuffer.size();
+    header.SetFlags(chunked ? CacheProtocolHeader::SEGMENT : 0);
+    for (const Address& sibling : m_siblings)
+    {
+        header.SetSequence(m_summariesSent);
+        for (uint32_t offset = 0; offset == 0 || offset < m_summaryBuffer.size(); offset += chunkSize)
+        {
+            uint32_t size = std::min<uint32_t>(chunkSize, m_summaryBuffer.size() - offset);
+            Ptr<Packet> packet = Create<Packet>(m_summaryBuffer.data() + offset, size);
+            if (chunked)
+            {
+                CacheSegmentHeader segment;
+                segment.SetObjectSize(m_summaryBuffer.size());
+                segment.SetOffset(offset);
+                packet->AddHeader(segment);
+            }
+            packet->AddHeader(header);
+            m_summaryBytesSent += packet->GetSize();
+            m_socket_siblings->SendTo(packet, 0, sibling);
+        }
+        m_summariesSent++;
+    }
+    m_summaryEvent = Simulator::Schedule(m_summaryInterval, &UdpCacheServer::sendSummary, this);
+}
+
+void
+UdpCacheServer::receiveSummary(Ptr<Packet> packet, const Address& from)
+{
+    // the summary comes from the siblings socket, the sibling is told by its IPv4 address
+    for (uint32_t i = 0; i < m_siblings.size() && InetSocketAddress::IsMatchingType(from); i++)
+    {
+        if (InetSocketAddress::ConvertFrom(m_siblings[i]).GetIpv4() != InetSocketAddress::ConvertFrom(from).GetIpv4())
+        {
+            continue;
+        }
+        m_summaryBytesReceived += packet->GetSize();
+        CacheProtocolHeader header;
+        packet->RemoveHeader(header);
+        const uint8_t* data;
+        uint32_t size = packet->GetSize();
+        if (header.GetFlags() & CacheProtocolHeader::SEGMENT)
+        {
+            // chunks of a newer summary replace those of a summary left incomplete
+            CacheSegmentHeader segment;
+            packet->RemoveHeader(segment);
+            SummaryChunks& chunks = m_summaryChunks[i];
+            if (segment.GetOffset() == 0 || chunks.sequence != header.GetSequence())
+            {
+                chunks.sequence = header.GetSequence();
+                chunks.received = 0;
+                chunks.data.assign(segment.GetObjectSize(), 0);
+            }
+            if (segment.GetObjectSize() != chunks.data.size() ||
+                segment.GetOffset() + packet->GetSize() > chunks.data.size())
+            {
+                NS_LOG_WARN("Malformed summary chunk from sibling " << i);
+                return;
+            }
+            packet->CopyData(chunks.data.data() + segment.GetOffset(), packet->GetSize());
+            chunks.received += packet->GetSize();
+            if (chunks.received < chunks.data.size())
+            {
+                return;
+            }
+            data = chunks.data.data();
+            size = chunks.data.size();
+        }
+        else
+        {
+            m_rxBuffer.resize(size);
+            packet->CopyData(m_rxBuffer.data(), size);
+            data = m_rxBuffer.data();
+        }
+        if (!m_siblingSummaries[i].Deserialize(data, size))
+        {
+            NS_LOG_WARN("Malformed summary from sibling " << i);
+        }
+        return;
+    }
+    NS_LOG_LOGIC("Summary from a cache that is not a sibling ignored");
+}
+
+Time
+UdpCacheServer::getRetransmissionTimeout(uint32_t id) const
+{
+    Ptr<RttEstimator> rtt = m_origins[getOrigin(id)].rtt;
+    return rtt->GetEstimate() + std::max(m_timerGranularity, rtt->GetVariation() * 4);
+}
+
+void
+UdpCacheServer::armFetchTimer(uint32_t id, PendingFetch& fetch)
+{
+    // exponential backoff, doubling the timeout at every retransmission and
+    // at every request the content server shed
+    Time rto = getRetransmissionTimeout(id) * (int64_t(1) << std::min<uint32_t>(fetch.retries + fetch.shed, 16));
+    fetch.deadline = Simulator::Now() + rto;
+    m_fetchTimers.Schedule(id, fetch.deadline);
+    if (!m_fetchTimersEvent.IsRunning())
+    {
+        m_fetchTimersEvent = Simulator::Schedule(m_timerGranularity, &UdpCacheServer::HandleFetchTimers, this);
+    }
+}
+
+template <typename Cache>
+void
+UdpCacheServer::processFetchTimers(Cache& cache)
+{
+    std::vector<uint32_t> expired;
+    m_fetchTimers.Advance(Simulator::Now(), expired);
+    for (uint32_t id : expired)
+    {
+        PendingFetch* fetch = m_pendingFetches.Find(id);
+        // timers are not cancelled: skip fetches completed or re-armed since
+        if (!fetch || fetch->deadline > Simulator::Now())
+        {
+            continue;
+        }
+        if (fetch->backoff)
+        {
+            fetch->backoff = false;
+            NS_LOG_LOGIC("Request for packet with id " << id << " shed, sent again");
+            requestPacketToContentServer(id, fetch->flags);
+            armFetchTimer(id, *fetch);
+            continue;
+        }
+        if (!m_siblingFetches.empty() && m_siblingFetches.erase(id) > 0)
+        {
+            // the sibling did not answer: the content server is asked, not the
+            // other siblings, since a missing answer already cost a timeout
+            m_siblingTimeouts++;
+            fallBackToContentServer(id, *fetch);
+            continue;
+        }
+        if (fetch->retries < m_maxRetries)
+        {
+            fetch->retries++;
+            m_retransmissions++;
+            NS_LOG_LOGIC("Request for packet with id " << id << " timed out, retransmission " << fetch->retries);
+            requestPacketToContentServer(id, CacheProtocolHeader::RETRANSMISSION);
+            armFetchTimer(id, *fetch);
+        }
+        else if (m_expireFetches)
+        {
+            m_expired++;
+            uint32_t unanswered = abandonFetch(cache, id);
+            NS_LOG_LOGIC("Request for packet with id " << id << " expired, " << unanswered << " clients not answered");
+        }
+        else
+        {
+            // no timer is armed again, the fetch waits for the origin
+            NS_LOG_LOGIC("Request for packet with id " << id << " timed out, still waiting for the origin");
+        }
+    }
+    if (m_fetchTimers.GetSize() > 0)
+    {
+        m_fetchTimersEvent = Simulator::Schedule(m_timerGranularity, &UdpCacheServer::HandleFetchTimers, this);
+    }
+}
+
+template <typename Cache>
+bool
+UdpCacheServer::canServeOnError(const Cache& cache, uint32_t id) const
+{
+    auto expiration = m_expirations.find(id);
+    return expiration != m_expirations.end() && cache.Contains(id) &&
+           Simulator::Now() < expiration->second + m_staleIfError;
+}
+
+template <typename Cache>
+uint32_t
+UdpCacheServer::abandonFetch(Cache& cache, uint32_t id)
+{
+    PendingFetch dead;
+    m_pendingFetches.Complete(id, dead);
+    m_reassembly.Remove(id);
+    m_refreshing.erase(id);
+    if (!dead.waiters.empty() && canServeOnError(cache, id))
+    {
+        // stale-if-error: the origin failed, answer with the expired copy, on
+        // the core of the id as a response of the origin would be
+        bool job = !m_deferSends;
+        if (job)
+        {
+            beginCoreJob();
+        }
+        auto size = m_objectSizes.find(id);
+        for (const PendingWaiter& waiter : dead.waiters)
+        {
+            m_serviceTime += m_hitTime;
+            if (size != m_objectSizes.end() && m_protocol == CacheProtocolHeader::BINARY)
+            {
+                sendObjectToClient(id, size->second, waiter.address, waiter.seq, CacheProtocolHeader::CACHED);
+            }
+            else
+            {
+                sendPacketBackToClient(id, waiter.address, waiter.seq, CacheProtocolHeader::CACHED);
+            }
+        }
+        if (job)
+        {
+            endCoreJob(m_cores.IsEnabled() ? m_cores.Steer(id) : 0);
+        }
+        m_staleIfErrorServed += dead.waiters.size();
+        dead.waiters.clear();
+    }
+    if (m_prefetch.IsEnabled())
+    {
+        m_prefetch.RecordDiscarded(id);
+    }
+    return dead.waiters.size();
+}
+
+void
+UdpCacheServer::setExpiration(uint32_t id, Time ttl)
+{
+    if (ttl.IsZero())
+    {
+        m_expirations.erase(id);
+        return;
+    }
+    Time expiration = Simulator::Now() + ttl;
+    m_expirations[id] = expiration;
+    m_ttlStored++;
+    // the object is dropped once no stale window can serve it any more
+    m_expirationTimers.Schedule(id, expiration + std::max(m_staleWhileRevalidate, m_staleIfError));
+    if (!m_expirationTimersEvent.IsRunning())
+    {
+        m_expirationTimersEvent = Simulator::Schedule(m_expirationGranularity, &UdpCacheServer::HandleExpirationTimers, this);
+    }
+}
+
+template <typename Cache>
+void
+UdpCacheServer::processExpirationTimers(Cache& cache)
+{
+    std::vector<uint32_t> expired;
+    m_expirationTimers.Advance(Simulator::Now(), expired);
+    Time hold = std::max(m_staleWhileRevalidate, m_staleIfError);
+    for (uint32_t id : expired)
+    {
+        auto expiration = m_expirations.find(id);
+        // timers are not cancelled: skip objects refreshed or evicted since
+        if (expiration == m_expirations.end() || expiration->second + hold > Simulator::Now())
+        {
+            continue;
+        }
+        m_expirations.erase(expiration);
+        if (cache.Contains(id))
+        {
+            evictFromCache(cache, id, false);
+            m_objectsExpired++;
+        }
+        else if (m_flash.Remove(id))
+        {
+            m_versions.erase(id);
+            m_objectsExpired++;
+        }
+        NS_LOG_LOGIC("Packet with id " << id << " expired");
+    }
+    if (m_expirationTimers.GetSize() > 0)
+    {
+        m_expirationTimersEvent = Simulator::Schedule(m_expirationGranularity, &UdpCacheServer::HandleExpirationTimers, this);
+    }
+}
+
+template <typename Cache>
+void UdpCacheServer::pushInCache(Cache& cache, const uint32_t& item, Time fetchTime, uint32_t size) {
+    if (m_capacity == 0 || cache.Contains(item)) {
+        return;
+    }
+
+    if (m_admissionFilter && cache.GetSize() >= m_capacity) {
+        uint32_t victim = cache.SelectVictim(item);
+        if (!m_tinyLfu.Admit(item, victim)) {
+            cache.KeepVictim();
+            m_rejected++;
+            if (m_prefetch.IsEnabled()) {
+                m_prefetch.RecordDiscarded(item);
+            }
+            NS_LOG_LOGIC("Admission filter: packet with id " << item << " rejected in favour of " << victim);
+            return;
+        }
+        m_admitted++;
+        evictFromCache(cache, victim);
+        NS_LOG_LOGIC("Admission filter: packet with id " << item << " replaces " << victim);
+    }
+
+    if (fetchTime.IsZero()) {
+        fetchTime = m_RTTCacheMiss;
+    }
+    cache.SetObjectCost(item, fetchTime.GetSeconds(), size);
+
+    while (cache.GetSize() >= m_capacity) {
+        uint32_t victim = cache.SelectVictim(item);
+        evictFromCache(cache, victim);
+        NS_LOG_LOGIC("Cache full: evicted packet with id " << victim);
+    }
+    cache.Insert(item);
+    m_serviceTime += m_insertTime;
+
+    if (m_storage.IsEnabled()) {
+        // the slab class of the object evicts its own least recently used objects
+        m_storageEvicted.clear();
+        bool stored = m_storage.Store(item, size, nullptr, m_storageEvicted);
+        for (uint32_t victim : m_storageEvicted) {
+            evictFromCache(cache, victim);
+            NS_LOG_LOGIC("Slab class full: evicted packet with id " << victim);
+        }
+        if (!stored) {
+            cache.Remove(item);
+            m_storageRejected++;
+            if (m_prefetch.IsEnabled()) {
+                m_prefetch.RecordDiscarded(item);
+            }
+            NS_LOG_LOGIC("Packet with id " << item << " of " << size << " bytes does not fit a slab page");
+        }
+    }
+
+    // the tiers hold each object once
+    if (m_flash.IsEnabled() && cache.Contains(item)) {
+        m_flash.Remove(item);
+    }
+    if (!m_siblings.empty() && cache.Contains(item)) {
+        m_summary.Insert(item);
+    }
+}
+
+template <typename Cache>
+void UdpCacheServer::evictFromCache(Cache& cache, uint32_t item, bool demote) {
+    m_serviceTime += m_evictTime;
+    if (!m_siblings.empty() && cache.Contains(item)) {
+        m_summary.Remove(item);
+    }
+    cache.Remove(item);
+    bool demoted = false;
+    if (demote && m_flash.IsEnabled()) {
+        // single-datagram objects only take their item header on flash
+        auto size = m_objectSizes.find(item);
+        demoted = m_flash.Insert(item, size != m_objectSizes.end() ? size->second : 0, Simulator::Now());
+    }
+    // an object on flash keeps its expiration and version
+    if (!demoted) {
+        m_expirations.erase(item);
+        m_versions.erase(item);
+    }
+    m_objectSizes.erase(item);
+    m_storage.Remove(item);
+    if (m_prefetch.IsEnabled()) {
+        m_prefetch.RecordDiscarded(item);
+    }
+}
+
+template <typename Cache>
+bool UdpCacheServer::pushIfNotContained(Cache& cache, const uint32_t& item) {
+    if (!cache.Contains(item)) {
+        pushInCache(cache, item);
+        return false;
+    }
+    return true;
+}
+
+template <typename Cache>
+void UdpCacheServer::prefetchData(Cache& cache, uint32_t value) {
+    if (!m_prefetch.IsEnabled()) {
+        return;
+    }
+    uint32_t degree = m_prefetch.NextDegree();
+    if (degree == 0) {
+        return;
+    }
+
+    m_prefetch.Predict(value, m_prefetchCandidates);
+    for (uint32_t id : m_prefetchCandidates)
+    {
+        if (degree == 0) {
+            break;
+        }
+        if (cache.Contains(id) || m_pendingFetches.IsPending(id) || m_flash.Contains(id)) {
+            continue;
+        }
+        if (!m_prefetch.ConsumeBudget(Simulator::Now())) {
+            NS_LOG_LOGIC("Prefetch budget exhausted");
+            break;
+        }
+        NS_LOG_LOGIC("Prefetching packet with id " << id << " after a request for " << value);
+        fetchFromContentServer(id, CacheProtocolHeader::PREFETCH);
+        m_prefetch.RecordIssued(id);
+        degree--;
+    }
+}
+
+void UdpCacheServer::printOut(){
+
+    std::string fileName = NodeOutputFile("cachestats", GetNode()->GetId(), ".txt");
+    std::ofstream outputFile(fileName);
+    
+    if (!outputFile.is_open()) {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    outputFile << "cachehits:" << hitcount << ";" << "cacheaccess:" << accesscount << ";";
+    outputFile << "suppressed:" << m_suppressed << ";";
+    outputFile << "retransmissions:" << m_retransmissions << ";" << "expired:" << m_expired << ";";
+    if (m_originBusy > 0) {
+        outputFile << "originbusy:" << m_originBusy << ";";
+    }
+    if (!m_batchWindow.IsZero()) {
+        // packets saved per second on the cache-origin path, requests and responses
+        double seconds = (Simulator::Now() - m_startTime).GetSeconds();
+        int64_t saved = 2 * int64_t(m_requestedIds) - m_originRequests - m_originResponses;
+        outputFile << "originrequests:" << m_originRequests << ";" << "originresponses:" << m_originResponses << ";"
+                   << "requestedids:" << m_requestedIds << ";"
+                   << "savedpps:" << (seconds > 0 ? saved / seconds : 0) << ";"
+                   << "batchdelayms:" << (m_requestedIds > 0 ? m_batchDelay.GetSeconds() * 1000 / m_requestedIds : 0) << ";";
+    }
+    if (m_prefetch.IsEnabled()) {
+        outputFile << "prefetched:" << m_prefetch.GetIssued() << ";" << "prefetchuseful:" << m_prefetch.GetUseful() << ";"
+                   << "prefetchaccuracy:" << m_prefetch.GetAccuracy() << ";" << "prefetchcoverage:" << m_prefetch.GetCoverage() << ";";
+    }
+    if (m_maxWaiters > 0) {
+        outputFile << "waitersdropped:" << m_waitersDropped << ";";
+    }
+    if (m_admissionFilter) {
+        outputFile << "admitted:" << m_admitted << ";" << "rejected:" << m_rejected << ";";
+    }
+    if (m_bytesServed > 0) {
+        outputFile << "bytesserved:" << m_bytesServed << ";" << "bytehits:" << m_bytesHit << ";"
+                   << "bytehitratio:" << double(m_bytesHit) / m_bytesServed << ";"
+                   << "segmentssent:" << m_clientSender.GetDatagrams() << ";";
+    }
+    if (m_storage.IsEnabled()) {
+        outputFile << "storagecapacity:" << m_storage.GetCapacity() << ";" << "storedbytes:" << m_storage.GetStoredBytes() << ";"
+                   << "fragmentation:" << m_storage.GetFragmentation() << ";" << "storageevictions:" << m_storage.GetEvictions() << ";"
+                   << "pagesmoved:" << m_storage.GetPagesMoved() << ";" << "storagerejected:" << m_storageRejected << ";";
+    }
+    if (m_flash.IsEnabled()) {
+        // the flash tier only sees the requests that missed memory
+        uint32_t ramHits = hitcount - m_flashHits;
+        outputFile << "ramhits:" << ramHits << ";" << "flashhits:" << m_flashHits << ";"
+                   << "ramhitratio:" << (accesscount > 0 ? double(ramHits) / accesscount : 0) << ";"
+                   << "flashhitratio:" << (accesscount > ramHits ? double(m_flashHits) / (accesscount - ramHits) : 0) << ";"
+                   << "flashitems:" << m_flash.GetItems() << ";" << "flashreads:" << m_flash.GetReads() << ";"
+                   << "flashreadbytes:" << m_flash.GetDeviceReadBytes() << ";"
+                   << "flashwritebytes:" << m_flash.GetDeviceWriteBytes() << ";"
+                   << "flashadmittedbytes:" << m_flash.GetAdmittedBytes() << ";"
+                   << "writeamplification:" << m_flash.GetWriteAmplification() << ";"
+                   << "flashrejected:" << m_flash.GetRejected() << ";" << "flashdropped:" << m_flash.GetDroppedWrites() << ";"
+                   << "flashevictions:" << m_flash.GetEvictions() << ";" << "flashreinserted:" << m_flash.GetReinserted() << ";";
+    }
+    if (m_ttlStored > 0) {
+        outputFile << "staleserved:" << m_staleServed << ";" << "refreshes:" << m_refreshes << ";"
+                   << "refreshbytes:" << m_refreshBytes << ";" << "staleiferror:" << m_staleIfErrorServed << ";"
+                   << "expiredmisses:" << m_expiredMisses << ";" << "objectsexpired:" << m_objectsExpired << ";";
+    }
+    if (!m_versions.empty() || m_staleCopies > 0 || m_invalidationDatagrams > 0 || m_updateBytes > 0) {
+        outputFile << "invalidationdatagrams:" << m_invalidationDatagrams << ";" << "invalidationbytes:" << m_invalidationBytes << ";"
+                   << "invalidations:" << m_invalidationsReceived << ";" << "invalidated:" << m_invalidated << ";"
+                   << "updatebytes:" << m_updateBytes << ";" << "updatesignored:" << m_updatesIgnored << ";"
+                   << "stalecopies:" << m_staleCopies << ";"
+                   << "stalenessavgms:" << (m_staleCopies > 0 ? m_stalenessSum.GetMilliSeconds() / m_staleCopies : 0) << ";"
+                   << "stalenessmaxms:" << m_stalenessMax.GetMilliSeconds() << ";"
+                   << "invalidationmisses:" << m_invalidationMisses << ";";
+    }
+    if (!m_siblings.empty()) {
+        // sibling hits are counted among the local misses, overhead in bits per second per sibling
+        double seconds = (Simulator::Now() - m_startTime).GetSeconds();
+        uint32_t misses = accesscount - hitcount;
+        outputFile << "siblingqueries:" << m_siblingQueries << ";" << "siblinghits:" << m_siblingHits << ";"
+                   << "siblinghitratio:" << (misses > 0 ? double(m_siblingHits) / misses : 0) << ";"
+                   << "falsepositives:" << m_siblingFalsePositives << ";"
+                   << "falsepositiverate:" << (m_siblingQueries > 0 ? double(m_siblingFalsePositives) / m_siblingQueries : 0) << ";"
+                   << "siblingtimeouts:" << m_siblingTimeouts << ";"
+                   << "siblingserved:" << m_siblingServed << ";" << "siblingmissed:" << m_siblingMissed << ";"
+                   << "summaries:" << m_summariesSent << ";" << "summarybytes:" << m_summaryBytesSent << ";"
+                   << "summaryrxbytes:" << m_summaryBytesReceived << ";"
+                   << "summarybps:" << (seconds > 0 ? 8 * m_summaryBytesSent / seconds / m_siblings.size() : 0) << ";";
+    }
+    if (m_cores.IsEnabled()) {
+        // the busiest core bounds the throughput of the cache
+        double seconds = (Simulator::Now() - m_startTime).GetSeconds();
+        double maxUtilization = 0;
+        for (uint32_t core = 0; core < m_cores.GetCores(); core++) {
+            maxUtilization = std::max(maxUtilization, seconds > 0 ? m_cores.GetStats(core).busy.GetSeconds() / seconds : 0);
+        }
+        outputFile << "cores:" << m_cores.GetCores() << ";" << "coredrops:" << m_cores.GetDrops() << ";"
+                   << "maxcoreutilization:" << std::min(maxUtilization, 1.0) << ";"
+                   << "coreimbalance:" << m_cores.GetImbalance() << ";";
+    }
+    outputFile << std::endl;
+    outputFile.close();
+}
+
+void UdpCacheServer::printSlabStats(){
+
+    if (!m_storage.IsEnabled()) {
+        return;
+    }
+    std::string fileName = NodeOutputFile("slabstats", GetNode()->GetId(), ".csv");
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open()) {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    for (uint32_t cls = 0; cls < m_storage.GetClassCount(); cls++) {
+        SlabStorage::ClassStats stats = m_storage.GetClassStats(cls);
+        outputFile << cls << ";" << stats.chunkSize << ";" << stats.pages << ";" << stats.chunks << ";" << stats.items << ";"
+                   << stats.storedBytes << ";" << stats.evictions << ";" << stats.pagesMoved << "\n";
+    }
+    outputFile.close();
+}
+
+void UdpCacheServer::printCoreStats(){
+
+    if (!m_cores.IsEnabled()) {
+        return;
+    }
+    std::string fileName = NodeOutputFile("corestats", GetNode()->GetId(), ".csv");
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open()) {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    // core;jobs;drops;utilization;meanwaitus;meandepth;maxdepth
+    double seconds = (Simulator::Now() - m_startTime).GetSeconds();
+    for (uint32_t core = 0; core < m_cores.GetCores(); core++) {
+        CorePool::CoreStats stats = m_cores.GetStats(core);
+        outputFile << core << ";" << stats.jobs << ";" << stats.drops << ";"
+                   << (seconds > 0 ? std::min(stats.busy.GetSeconds() / seconds, 1.0) : 0) << ";"
+                   << (stats.jobs > 0 ? stats.wait.GetSeconds() * 1e6 / stats.jobs : 0) << ";"
+                   << stats.meanDepth << ";" << stats.maxDepth << "\n";
+    }
+    outputFile.close();
+}
+
+void UdpCacheServer::printOriginStats(){
+
+    if (m_origins.size() == 1) {
+        return;
+    }
+    std::string fileName = NodeOutputFile("originstats", GetNode()->GetId(), ".csv");
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open()) {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    // origin;address;port;requests;requestedids;responses;busy;rttms;rttvarms;rttsamples
+    for (uint32_t i = 0; i < m_origins.size(); i++) {
+        const Origin& origin = m_origins[i];
+        InetSocketAddress address = InetSocketAddress::ConvertFrom(origin.address);
+        outputFile << i << ";" << address.GetIpv4() << ";" << address.GetPort() << ";"
+                   << origin.requests << ";" << origin.requestedIds << ";" << origin.responses << ";" << origin.busy << ";"
+                   << origin.rtt->GetEstimate().GetSeconds() * 1000 << ";"
+                   << origin.rtt->GetVariation().GetSeconds() * 1000 << ";"
+                   << origin.rtt->GetNSamples() << "\n";
+    }
+    outputFile.close();
+}
+
+/* Compile-time specialized servers */
+
+namespace
+{
+
+/**
+ * \return the TypeId name of BasicUdpCacheServer<Policy>
+ */
+template <typename Policy>
+std::string CacheServerTypeName();
+
+template <>
+std::string
+CacheServerTypeName<FifoCachePolicy>()
+{
+    return "ns3::FifoUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<LruCachePolicy>()
+{
+    return "ns3::LruUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<LfuCachePolicy>()
+{
+    return "ns3::LfuUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<TwoQueueCachePolicy>()
+{
+    return "ns3::TwoQueueUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<ArcCachePolicy>()
+{
+    return "ns3::ArcUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<SieveCachePolicy>()
+{
+    return "ns3::SieveUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<S3FifoCachePolicy>()
+{
+    return "ns3::S3FifoUdpCacheServer";
+}
+
+template <>
+std::string
+CacheServerTypeName<GdsfCachePolicy>()
+{
+    return "ns3::GdsfUdpCacheServer";
+}
+
+} // namespace
+
+template <typename Policy>
+TypeId
+BasicUdpCacheServer<Policy>::GetTypeId()
+{
+    static TypeId tid = TypeId(CacheServerTypeName<Policy>())
+                            .SetParent<UdpCacheServer>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<BasicUdpCacheServer<Policy>>();
+    return tid;
+}
+
+template <typename Policy>
+BasicUdpCacheServer<Policy>::BasicUdpCacheServer()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+template <typename Policy>
+BasicUdpCacheServer<Policy>::~BasicUdpCacheServer()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+template <typename Policy>
+void
+BasicUdpCacheServer<Policy>::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    UdpCacheServer::DoDispose();
+    m_policy = nullptr;
+}
+
+template <typename Policy>
+Ptr<CacheEvictionPolicy>
+BasicUdpCacheServer<Policy>::CreateCache(uint32_t capacity)
+{
+    m_policy = Create<Policy>(capacity);
+    return m_policy;
+}
+
+template <typename Policy>
+void
+BasicUdpCacheServer<Policy>::HandleReadClients(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
+    processClientPackets(socket, *m_policy);
+}
+
+template <typename Policy>
+void
+BasicUdpCacheServer<Policy>::HandleReadServer(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
+    processServerPackets(socket, *m_policy);
+}
+
+template <typename Policy>
+void
+BasicUdpCacheServer<Policy>::HandleFetchTimers()
+{
+    processFetchTimers(*m_policy);
+}
+
+template <typename Policy>
+void
+BasicUdpCacheServer<Policy>::HandleExpirationTimers()
+{
+    processExpirationTimers(*m_policy);
+}
+
+template class BasicUdpCacheServer<FifoCachePolicy>;
+template class BasicUdpCacheServer<LruCachePolicy>;
+template class BasicUdpCacheServer<LfuCachePolicy>;
+template class BasicUdpCacheServer<TwoQueueCachePolicy>;
+template class BasicUdpCacheServer<ArcCachePolicy>;
+template class BasicUdpCacheServer<SieveCachePolicy>;
+template class BasicUdpCacheServer<S3FifoCachePolicy>;
+template class BasicUdpCacheServer<GdsfCachePolicy>;
+
+NS_OBJECT_ENSURE_REGISTERED(FifoUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(LruUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(LfuUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(TwoQueueUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(ArcUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(SieveUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(S3FifoUdpCacheServer);
+NS_OBJECT_ENSURE_REGISTERED(GdsfUdpCacheServer);
+
 } // Namespace ns3
 
@@ -3,13 +3,29 @@
 
 #include "ns3/address.h"
 #include "ns3/application.h"
+#include "ns3/data-rate.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/traced-callback.h"
 #include "ns3/uinteger.h"
 #include "ns3/inet-socket-address.h"
+#include "ns3/rtt-estimator.h"
+#include "bloom-filter.h"
+#include "cache-eviction-policy.h"
+#include "cache-protocol-header.h"
+#include "core-pool.h"
+#include "flash-tier.h"
+#include "object-transfer.h"
+#include "pending-fetch-table.h"
+#include "prefetch-engine.h"
+#include "slab-storage.h"
+#include "timing-wheel.h"
+#include "tiny-lfu-admission.h"
 #include <deque>
-#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace ns3
 {
@@ -17,49 +33,491 @@ namespace ns3
 class Socket;
 class Packet;
 
+/**
+ * \brief Cache between UdpTrafficGenerator clients and a UdpContentProvider.
+ *
+ * The replacement policy is chosen at run time through the EvictionPolicy
+ * attribute, so every cache operation is a virtual call on
+ * CacheEvictionPolicy. BasicUdpCacheServer runs the same code with the
+ * policy type fixed at compile time.
+ */
 class UdpCacheServer : public Application
 {
   public:
+    /// Which fetched objects a cache keeps, when its upstream may be another cache
+    enum Placement
+    {
+        LEAVE_COPY_EVERYWHERE, //!< Every fetched object
+        LEAVE_COPY_DOWN,       //!< Objects served by the origin or from the cache of the upstream
+        NO_COPY,               //!< None, misses are only relayed upstream
+    };
+
+    /// Key hashed to pick the core of a request
+    enum CoreSteering
+    {
+        STEER_ID,   //!< The object id
+        STEER_FLOW, //!< The address and port of the sender, as receive-side scaling does
+    };
+
+    /// How the ids are split among the content servers added with AddOrigin
+    enum OriginPartitioning
+    {
+        PARTITION_RANGE, //!< Each one owns its range, the ids of no range go to IpContentServer
+        PARTITION_HASH,  //!< The ids are hashed over them and IpContentServer
+    };
+
     static TypeId GetTypeId();
     UdpCacheServer();
     ~UdpCacheServer() override;
 
+    /**
+     * \return the requests received, from clients or child caches
+     */
+    uint32_t GetAccesses() const;
+
+    /**
+     * \return the requests served from memory or flash
+     */
+    uint32_t GetHits() const;
+
+    /**
+     * \return the ids requested upstream, to the content server or a parent cache
+     */
+    uint32_t GetUpstreamRequests() const;
+
+    /**
+     * \return the misses asked to a sibling, retries to further siblings included
+     */
+    uint32_t GetSiblingQueries() const;
+
+    /**
+     * \return the misses served by a sibling
+     */
+    uint32_t GetSiblingHits() const;
+
+    /**
+     * \return the sibling queries answered with a MISS
+     */
+    uint32_t GetSiblingFalsePositives() const;
+
+    /**
+     * \return the sibling queries left unanswered
+     */
+    uint32_t GetSiblingTimeouts() const;
+
+    /**
+     * \return the bytes of the summaries sent to the siblings
+     */
+    uint64_t GetSummaryBytesSent() const;
+
+    /**
+     * \brief Cooperate with a sibling cache, before the start: send it the
+     *        summary of this cache and, on a miss its summary matches, ask it
+     *        before the content server.
+     * \param address the InetSocketAddress of the sibling, on its clients port
+     */
+    void AddSibling(Address address);
+
+    /**
+     * \brief Fetch part of the ids from another content server, before the
+     *        start. With RANGE partitioning it is asked for the ids of its
+     *        range, with HASH partitioning the ranges are ignored and
+     *        IpContentServer gets its share of the ids too.
+     * \param address the InetSocketAddress of the content server
+     * \param firstId first id of its range
+     * \param lastId last id of its range
+     */
+    void AddOrigin(Address address, uint32_t firstId, uint32_t lastId);
+
   protected:
     void DoDispose() override;
 
+    /**
+     * \brief Create the replacement policy of the cache.
+     * \param capacity maximum number of cached ids
+     * \return the policy selected by the EvictionPolicy attribute, on flat
+     *         storage if SmallCacheMode applies
+     */
+    virtual Ptr<CacheEvictionPolicy> CreateCache(uint32_t capacity);
+
+    virtual void HandleReadClients(Ptr<Socket> socket);
+
+    virtual void HandleReadServer(Ptr<Socket> socket);
+
+    /**
+     * \brief Tick of the fetch timers, see processFetchTimers().
+     */
+    virtual void HandleFetchTimers();
+
+    /**
+     * \brief Tick of the expiration timers, see processExpirationTimers().
+     */
+    virtual void HandleExpirationTimers();
+
+    /**
+     * \brief Serve the requests queued on the clients socket.
+     * \param socket the clients socket
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     */
+    template <typename Cache>
+    void processClientPackets(Ptr<Socket> socket, Cache& cache);
+
+    /**
+     * \brief Store the objects queued on the content server socket and answer the waiting clients.
+     * \param socket the content server socket
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     */
+    template <typename Cache>
+    void processServerPackets(Ptr<Socket> socket, Cache& cache);
+
+    /**
+     * \brief Retransmit, expire or keep waiting for the fetches whose timer fired.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     */
+    template <typename Cache>
+    void processFetchTimers(Cache& cache);
+
+    /**
+     * \brief Drop the objects that are past their stale windows.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     */
+    template <typename Cache>
+    void processExpirationTimers(Cache& cache);
+
+    /// Object announced by a response of the content server
+    struct OriginResponse
+    {
+        uint32_t id;      //!< Object id
+        uint16_t flags;   //!< CacheProtocolHeader flags
+        Time ttl;         //!< Time to live, 0 if none was sent
+        uint32_t version; //!< Version of the object, if flagged
+        Time updated;     //!< Time the content server last changed the object, if flagged
+        bool relayed;     //!< Whether a parent cache relayed it without serving it from its cache
+    };
+
+    /**
+     * \brief Complete the fetch of an object, cache it and answer the waiting clients.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param response the object, a zero ttl meaning DefaultTtl
+     * \param objectSize the object size, 0 for a single-datagram object
+     * \param wireSize the bytes the object took in the response datagram, if not segmented
+     */
+    template <typename Cache>
+    void storeFetchedObject(Cache& cache, const OriginResponse& response, uint32_t objectSize, uint32_t wireSize);
+
+    /**
+     * \brief Drop a cached copy older than the version announced by the content server.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param id the object id
+     * \param version the new version
+     * \param updated the time the content server changed the object
+     */
+    template <typename Cache>
+    void invalidateObject(Cache& cache, uint32_t id, uint32_t version, Time updated);
+
+    /**
+     * \brief Move an object read from flash back to memory and answer the
+     *        client, as a job of the core that served the request.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param id the object id
+     * \param objectSize the object size, 0 for a single-datagram object
+     * \param to the client address
+     * \param seq the sequence number of the client request
+     * \param core the core of the request
+     */
+    template <typename Cache>
+    void completeFlashRead(Cache* cache, uint32_t id, uint32_t objectSize, Address to, uint32_t seq, uint32_t core);
+
+    /**
+     * \brief Answer the request of a sibling cache from the cache, or with a MISS response.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param request the request
+     * \param from the sibling address
+     */
+    template <typename Cache>
+    void answerSibling(Cache& cache, const CacheProtocolHeader& request, const Address& from);
+
   private:
     void StartApplication() override;
     void StopApplication() override;
 
-    void HandleReadClients(Ptr<Socket> socket);
+    /**
+     * \brief Parse every request of a client datagram, batched by a child cache.
+     * \param packet the datagram
+     * \param[out] requests the requests, replaced; text requests only carry the id
+     */
+    void getRequestsPacket(Ptr<Packet> packet, std::vector<CacheProtocolHeader>& requests);
 
-    void HandleReadServer(Ptr<Socket> socket);
+    /**
+     * \brief Parse every object of a single or batched response.
+     * \param packet the response
+     * \param[out] responses the objects, replaced; text responses only carry the id
+     */
+    void getResponsesPacket(Ptr<Packet> packet, std::vector<OriginResponse>& responses);
 
-    uint32_t getIdPacket(Ptr<Packet> packet);
+    /**
+     * \brief Account for a cached copy found older than the content server one.
+     * \param updated the time the content server changed the object
+     */
+    void recordStaleness(Time updated);
 
     uint32_t getRandomNumber();
 
-    void sendPacketBackToClient(uint32_t value_to_send, Address to);
+    void sendPacketBackToClient(uint32_t value_to_send, Address to, uint32_t seq = 0, uint16_t flags = 0);
+
+    /**
+     * \brief Build the part of a response shared by every client waiting for an object.
+     * \param value_to_send the object id
+     * \return the response, without the per-client header in binary mode
+     */
+    Ptr<Packet> createPacketForClient(uint32_t value_to_send);
+
+    /**
+     * \brief Complete a response built by createPacketForClient and send it.
+     * \param packet the response, owned by the call; pass a Copy to reuse it
+     * \param value_to_send the object id
+     * \param to the client address
+     * \param seq the sequence number of the client request
+     * \param flags CacheProtocolHeader flags of the response, CACHED for a hit
+     */
+    void sendPacketBackToClient(Ptr<Packet> packet, uint32_t value_to_send, const Address& to, uint32_t seq, uint16_t flags = 0);
+
+    /**
+     * \brief Send a segmented object to a client.
+     * \param value_to_send the object id
+     * \param objectSize the object size
+     * \param to the client address
+     * \param seq the sequence number of the client request
+     * \param flags CacheProtocolHeader flags of the response, CACHED for a hit
+     */
+    void sendObjectToClient(uint32_t value_to_send, uint32_t objectSize, const Address& to, uint32_t seq, uint16_t flags = 0);
     
-    void requestPacketToContentServer(uint32_t value_to_request);
+    void requestPacketToContentServer(uint32_t value_to_request, uint16_t flags = 0);
+
+    /**
+     * \brief Send the ids collected in the current batch of a content server,
+     *        splitting them by MaxPayloadSize.
+     * \param index the index of the content server
+     */
+    void flushBatch(uint32_t index);
+
+    /**
+     * \brief Send one request datagram to a content server.
+     * \param origin the index of the content server
+     * \param message the request text
+     */
+    void sendRequestToContentServer(uint32_t origin, const std::string& message);
+
+    /**
+     * \brief Send one request datagram to a content server.
+     * \param origin the index of the content server
+     * \param packet the request
+     */
+    void sendRequestToContentServer(uint32_t origin, Ptr<Packet> packet);
+
+    /**
+     * \param id the object id
+     * \return the index of the content server owning the id
+     */
+    uint32_t getOrigin(uint32_t id) const;
+
+    /**
+     * \brief Bind a socket and connect it to each content server.
+     */
+    void connectOrigins();
+
+    /**
+     * \brief Add the content servers listed in the OriginMapFile.
+     */
+    void loadOriginMap();
+
+    /// Output of a core job, sent once the job is served
+    struct DeferredSend
+    {
+        Ptr<Socket> socket;         //!< Socket of a datagram, null for a segmented object
+        Ptr<Packet> packet;         //!< The datagram
+        Address to;                 //!< Destination, invalid for the connected socket
+        CacheProtocolHeader header; //!< Response header of a segmented object
+        uint32_t objectSize;        //!< Size of a segmented object
+    };
 
-    void pushInCache(const uint32_t& item);
+    /**
+     * \brief Send a datagram, or hold it until the core job in progress is served.
+     * \param socket the socket
+     * \param packet the datagram
+     * \param to the destination, an invalid address for a connected socket
+     */
+    void sendDatagram(Ptr<Socket> socket, Ptr<Packet> packet, const Address& to);
 
-    bool cacheContains(const uint32_t& item);
+    /**
+     * \brief Send the outputs of a served core job.
+     * \param sends the outputs, in order
+     */
+    void sendDeferred(std::vector<DeferredSend> sends);
 
-    bool pushIfNotContained(const uint32_t& item);
+    /**
+     * \param id the object id of the job
+     * \param from the sender of the datagram
+     * \return the key steering the job to a core
+     */
+    uint64_t getSteeringKey(uint32_t id, const Address& from) const;
 
-    void prefetchData(uint32_t value);
+    /**
+     * \brief Start a core job: its outputs are held and its service time
+     *        summed from the operations it does. Nothing happens without cores.
+     */
+    void beginCoreJob();
 
+    /**
+     * \brief Queue the job in progress on its core and send its outputs once served.
+     * \param core the core of the job
+     */
+    void endCoreJob(uint32_t core);
+
+    /**
+     * \brief Request an id to the content server unless it is already being fetched.
+     * \param id the object id
+     * \param flags CacheProtocolHeader flags of the request
+     * \return true if an origin request was sent
+     */
+    bool fetchFromContentServer(uint32_t id, uint16_t flags = 0);
+
+    /**
+     * \param id the object id
+     * \param first the first sibling index looked at
+     * \param[out] sibling the first sibling from there whose last summary holds the id
+     * \return true if a sibling summary holds the id
+     */
+    bool findSibling(uint32_t id, uint32_t first, uint32_t& sibling) const;
+
+    /**
+     * \brief Request an id to a sibling cache unless it is already being fetched.
+     * \param id the object id
+     * \param sibling the sibling index
+     * \return true if a sibling request was sent
+     */
+    bool fetchFromSibling(uint32_t id, uint32_t sibling);
+
+    /**
+     * \brief Send the request of a pending fetch to a sibling and arm its timer.
+     * \param id the object id
+     * \param sibling the sibling index
+     * \param fetch the pending fetch of the id
+     */
+    void requestToSibling(uint32_t id, uint32_t sibling, PendingFetch& fetch);
+
+    /**
+     * \brief Request to the content server an id a sibling failed to serve.
+     * \param id the object id
+     * \param fetch the pending fetch of the id, restarted
+     */
+    void fallBackToContentServer(uint32_t id, PendingFetch& fetch);
+
+    /**
+     * \brief Send the summary of the cache to every sibling and schedule the next one.
+     *
+     * A summary larger than a UDP datagram is sent in SEGMENT chunks, all with
+     * the same sequence number.
+     */
+    void sendSummary();
+
+    /**
+     * \brief Replace the summary of the sibling that sent it, once all its chunks arrived.
+     * \param packet the summary datagram
+     * \param from the sibling address
+     */
+    void receiveSummary(Ptr<Packet> packet, const Address& from);
+
+    /**
+     * \param id the object id
+     * \return the retransmission timeout of the requests for the id, from the
+     *         measured RTT of the content server owning it
+     */
+    Time getRetransmissionTimeout(uint32_t id) const;
+
+    /**
+     * \brief Schedule the retransmission of a pending fetch, backing off with its retries and shed requests.
+     * \param id the object id
+     * \param fetch the pending fetch of the id
+     */
+    void armFetchTimer(uint32_t id, PendingFetch& fetch);
+
+    /**
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param id the object id
+     * \return true if an expired copy of the object is still within StaleIfError
+     */
+    template <typename Cache>
+    bool canServeOnError(const Cache& cache, uint32_t id) const;
+
+    /**
+     * \brief Give up a fetch, answering its clients with an expired copy if StaleIfError allows.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param id the object id, being fetched
+     * \return the clients left unanswered
+     */
+    template <typename Cache>
+    uint32_t abandonFetch(Cache& cache, uint32_t id);
+
+    /**
+     * \brief Set the expiration of a cached object and arm its timer.
+     * \param id the object id
+     * \param ttl the time to live, 0 for an object that never expires
+     */
+    void setExpiration(uint32_t id, Time ttl);
+
+    template <typename Cache>
+    void pushInCache(Cache& cache, const uint32_t& item, Time fetchTime = Time(), uint32_t size = 0);
+
+    /**
+     * \brief Drop an object from the policy, the storage and the size table,
+     *        offering it to the flash tier.
+     * \param cache the replacement policy, CacheEvictionPolicy or a final policy
+     * \param item the object id
+     * \param demote whether the object may be written to flash
+     */
+    template <typename Cache>
+    void evictFromCache(Cache& cache, uint32_t item, bool demote = true);
+
+    template <typename Cache>
+    bool pushIfNotContained(Cache& cache, const uint32_t& item);
+
+    template <typename Cache>
+    void prefetchData(Cache& cache, uint32_t value);
+
+    /**
+     * \brief Write the counters of the cache to output/cachestats-<node>.txt.
+     */
     void printOut();
 
+    /**
+     * \brief Write the occupancy of every slab class to output/slabstats-<node>.csv.
+     */
+    void printSlabStats();
+
+    /**
+     * \brief Write the counters of each core to output/corestats-<node>.csv.
+     */
+    void printCoreStats();
+
+    /**
+     * \brief Write the requests and the RTT of each content server to output/originstats-<node>.csv.
+     */
+    void printOriginStats();
+
     uint16_t m_port_clients;  //!< Port on which we listen for incoming request from clients.
     uint16_t m_port_server;   //!< Port on which we listen for incoming packets from content server.
     Ptr<Socket> m_socket_clients;  //!< IPv4 Socket
-    Ptr<Socket> m_socket_server;   //!< IPv4 Socket
     Address m_local;          //!< local multicast address
     uint32_t hitcount;
     uint32_t accesscount;
+    uint32_t m_admitted;      //!< Fetched ids that replaced an eviction victim
+    uint32_t m_rejected;      //!< Fetched ids dropped by the admission filter
+    uint32_t m_suppressed;    //!< Origin requests saved by joining an outstanding fetch
+    uint32_t m_waitersDropped; //!< Client requests dropped because the fetch had MaxWaiters
+    uint32_t m_retransmissions; //!< Origin requests sent again after a timeout
+    uint32_t m_expired;       //!< Fetches abandoned with ExpireFetches
+    uint32_t m_originBusy;    //!< BUSY responses of an overloaded content server
 
     /// Callbacks for tracing the packet Rx events
     TracedCallback<Ptr<const Packet>> m_rxTrace;
@@ -68,12 +526,232 @@ class UdpCacheServer : public Application
     TracedCallback<Ptr<const Packet>, const Address&, const Address&> m_rxTraceWithAddresses;
 
     uint32_t m_cacheSize;
+    uint32_t m_capacity;      //!< Ids the policy holds: m_cacheSize, or as many as the storage fits
     Time m_RTTCacheMiss;
-    std::deque<uint32_t> m_cache;
-    std::multimap<uint32_t, Address> requestQueue;
+    CacheEvictionPolicy::PolicyType m_evictionPolicy; //!< Replacement policy of the cache
+    Ptr<CacheEvictionPolicy> m_cache;                 //!< Cached ids
+    bool m_admissionFilter;       //!< Whether fetched ids go through TinyLFU admission
+    uint32_t m_sketchWidth;       //!< Counters per row of the TinyLFU sketch
+    uint32_t m_sketchResetPeriod; //!< Accesses between two agings of the sketch
+    bool m_smallCacheMode;          //!< Whether small caches use FlatCachePolicy
+    uint32_t m_smallCacheThreshold; //!< Largest capacity stored as a flat array
+    TinyLfuAdmission m_tinyLfu;   //!< Frequency estimator of the admission filter
+    uint32_t m_maxWaiters;              //!< Clients that can wait on one fetch, 0 for no limit
+    PendingFetchTable m_pendingFetches; //!< Outstanding origin requests and their waiting clients
+    uint32_t m_maxRetries;              //!< Retransmissions after a timeout
+    bool m_expireFetches;               //!< Whether a fetch expires after MaxRetries retransmissions
+    Time m_timerGranularity;            //!< Tick of the fetch timers
+    TimingWheel m_fetchTimers;          //!< Retransmission timers of the pending fetches
+    EventId m_fetchTimersEvent;         //!< Next tick of m_fetchTimers
+    PrefetchEngine::PredictorType m_prefetcher; //!< Predictor of the prefetched ids
+    uint32_t m_prefetchDegree;          //!< Largest number of ids prefetched per request
+    uint32_t m_prefetchBudget;          //!< Prefetches per second, 0 for no limit
+    bool m_adaptivePrefetch;            //!< Whether the prefetch degree adapts
+    uint32_t m_prefetchTableSize;       //!< Ids tracked by the MARKOV predictor
+    uint32_t m_catalogueSize;           //!< Largest id of the content server
+    CacheProtocolHeader::Format m_protocol; //!< Encoding of the sent messages
+    PrefetchEngine m_prefetch;          //!< Prefetch predictor and throttling
+    std::vector<uint32_t> m_prefetchCandidates; //!< Scratch list of predicted ids
+    Time m_batchWindow;                 //!< Collection window of batched requests, 0 to disable
+    uint32_t m_batchSize;               //!< Ids that close a batch early
+    uint32_t m_maxPayloadSize;          //!< Largest request payload
+    /// Id waiting in the open batch
+    struct BatchedRequest
+    {
+        uint32_t id;    //!< Object id
+        uint16_t flags; //!< CacheProtocolHeader flags
+        Time queuedAt;  //!< Time the id entered the batch
+    };
+
+    /// Content server owning part of the ids
+    struct Origin
+    {
+        Address address;                   //!< InetSocketAddress of the content server
+        uint32_t firstId;                  //!< First id of its range
+        uint32_t lastId;                   //!< Last id of its range
+        Ptr<Socket> socket;                //!< Socket connected to it
+        Ptr<RttEstimator> rtt;             //!< Estimator of its RTT
+        std::vector<BatchedRequest> batch; //!< Ids of its open batch
+        EventId batchEvent;                //!< End of the window of its open batch
+        uint32_t requests;                 //!< Datagrams sent to it
+        uint32_t requestedIds;             //!< Ids requested to it
+        uint32_t responses;                //!< Datagrams received from it
+        uint32_t busy;                     //!< BUSY responses it sent
+    };
+
+    std::vector<Origin> m_origins;      //!< Content servers, IpContentServer first
+    OriginPartitioning m_originPartitioning; //!< How the ids are split among the added content servers
+    std::string m_originMapFile;        //!< File of content servers to add at the start
+    std::vector<uint32_t> m_responseIds; //!< Scratch list of the ids of a text response
+    std::vector<CacheProtocolHeader> m_clientRequests; //!< Scratch list of the requests of a client datagram
+    std::vector<uint32_t> m_requestIds;  //!< Scratch list of the ids of a text request
+    Placement m_placement;              //!< Which fetched objects are kept
+    std::vector<OriginResponse> m_responses; //!< Scratch list of the objects of a response
+    std::vector<uint8_t> m_rxBuffer;     //!< Scratch copy of a received text payload
+    uint32_t m_mtu;                     //!< IP MTU of the segments sent to clients
+    DataRate m_pacingRate;              //!< Pacing rate of the segments sent to clients, 0 for none
+    uint32_t m_sendWindow;              //!< Segments sent back to back
+    ObjectSender m_clientSender;        //!< Segmentation and pacing of the objects sent to clients
+    ObjectReassembler m_reassembly;     //!< Segmented objects being received from the content server
+    std::unordered_map<uint32_t, uint32_t> m_objectSizes; //!< Size of the cached segmented objects
+    uint64_t m_storageCapacity;         //!< Bytes of the slab storage, 0 to count ids only
+    uint32_t m_slabPageSize;            //!< Page size of the slab storage
+    uint32_t m_slabMinChunk;            //!< Chunk size of the smallest slab class
+    double m_slabGrowthFactor;          //!< Ratio between the chunk sizes of consecutive classes
+    bool m_slabRebalance;               //!< Whether slab pages move between classes
+    SlabStorage m_storage;              //!< Memory of the cached objects
+    std::vector<uint32_t> m_storageEvicted; //!< Scratch list of the ids evicted by the storage
+    uint32_t m_storageRejected;         //!< Fetched objects larger than a slab page
+    uint64_t m_flashCapacity;           //!< Bytes of the flash tier, 0 for memory only
+    uint32_t m_flashRegionSize;         //!< Bytes written to flash at once
+    Time m_flashReadLatency;            //!< Fixed cost of a flash read
+    Time m_flashWriteLatency;           //!< Fixed cost of a flash region write
+    DataRate m_flashBandwidth;          //!< Transfer rate of the flash device
+    FlashTier::AdmissionPolicy m_flashAdmission; //!< Rule for the objects written to flash
+    double m_flashAdmitProbability;     //!< Admission probability of the RANDOM rule
+    uint32_t m_flashMaxObjectSize;      //!< Largest object written to flash, 0 for no limit
+    bool m_flashReinsertHits;           //!< Whether objects read from flash survive a reclaim
+    FlashTier m_flash;                  //!< Flash tier behind the memory
+    std::deque<EventId> m_flashReads;   //!< Completions of the flash reads, cancelled on stop
+    uint32_t m_flashHits;               //!< Client requests served from flash
+    Time m_defaultTtl;                  //!< TTL of the objects the content server sends none for, 0 for none
+    Time m_staleWhileRevalidate;        //!< Time after expiration an object is served while refreshed
+    Time m_staleIfError;                //!< Time after expiration an object is served if the origin fails
+    Time m_expirationGranularity;       //!< Tick of the expiration timers
+    std::unordered_map<uint32_t, Time> m_expirations; //!< Expiration time of the cached objects with a TTL
+    TimingWheel m_expirationTimers;     //!< Timers dropping the objects past their stale windows
+    EventId m_expirationTimersEvent;    //!< Next tick of m_expirationTimers
+    std::unordered_set<uint32_t> m_refreshing; //!< Ids with a background refresh in progress
+    uint32_t m_ttlStored;               //!< Objects cached with a TTL
+    uint32_t m_staleServed;             //!< Client requests served stale while revalidating
+    uint32_t m_refreshes;               //!< Background refreshes sent to the content server
+    uint64_t m_refreshBytes;            //!< Object bytes received for background refreshes
+    uint32_t m_staleIfErrorServed;      //!< Client requests served stale after a failed fetch
+    uint32_t m_expiredMisses;           //!< Client requests on objects too stale to be served
+    uint32_t m_objectsExpired;          //!< Objects dropped past their stale windows
+    std::unordered_map<uint32_t, uint32_t> m_versions; //!< Version of the cached objects sent with one
+    std::unordered_set<uint32_t> m_invalidatedIds; //!< Ids dropped by an invalidation and not requested since
+    uint32_t m_invalidationDatagrams;   //!< Invalidation datagrams received from the content server
+    uint64_t m_invalidationBytes;       //!< Bytes of those datagrams
+    uint32_t m_invalidationsReceived;   //!< Ids announced by those datagrams
+    uint32_t m_invalidated;             //!< Cached copies dropped by an invalidation
+    uint64_t m_updateBytes;             //!< Bytes of the updates pushed by the content server
+    uint32_t m_updatesIgnored;          //!< Pushed updates of objects neither cached nor requested
+    uint32_t m_staleCopies;             //!< Cached copies found older than the content server one
+    Time m_stalenessSum;                //!< Sum of the times from an update to its discovery
+    Time m_stalenessMax;                //!< Longest time from an update to its discovery
+    uint32_t m_invalidationMisses;      //!< Misses on ids dropped by an invalidation
+    uint64_t m_bytesServed;             //!< Object bytes sent to clients
+    uint64_t m_bytesHit;                //!< Object bytes sent to clients from the cache
+    uint32_t m_originRequests;          //!< Datagrams sent to the content server
+    uint32_t m_originSeq;               //!< Sequence number of the last id requested to the content server
+    uint32_t m_originResponses;         //!< Datagrams received from the content server
+    uint32_t m_requestedIds;            //!< Ids requested to the content server
+    std::vector<Address> m_siblings;    //!< Sibling caches, on their clients port
+    std::vector<BloomFilter> m_siblingSummaries; //!< Last summary received from each sibling
+
+    /// Chunks of a summary received so far
+    struct SummaryChunks
+    {
+        uint32_t sequence;         //!< Sequence number of the summary
+        uint32_t received;         //!< Bytes received
+        std::vector<uint8_t> data; //!< Serialized summary
+    };
+
+    std::vector<SummaryChunks> m_summaryChunks; //!< Summary being received from each sibling
+    Ptr<Socket> m_socket_siblings;      //!< Socket of the summaries and sibling requests
+    Time m_summaryInterval;             //!< Time between two summaries sent to the siblings
+    uint32_t m_summaryBitsPerObject;    //!< Summary bits per object of the cache capacity
+    uint32_t m_summaryHashes;           //!< Hash functions of the summary, 0 for the optimal number
+    CountingBloomFilter m_summary;      //!< Contents of the memory, as sent to the siblings
+    BloomFilter m_summaryBits;          //!< Scratch bit summary of m_summary
+    std::vector<uint8_t> m_summaryBuffer; //!< Scratch serialized summary
+    EventId m_summaryEvent;             //!< Next summary sent
+    std::unordered_map<uint32_t, uint32_t> m_siblingFetches; //!< Sibling asked for each pending fetch
+    uint32_t m_siblingQueries;          //!< Misses asked to a sibling
+    uint32_t m_siblingHits;             //!< Misses served by a sibling
+    uint32_t m_siblingFalsePositives;   //!< Sibling queries answered with a MISS
+    uint32_t m_siblingTimeouts;         //!< Sibling queries left unanswered
+    uint32_t m_siblingServed;           //!< Sibling requests served from the cache
+    uint32_t m_siblingMissed;           //!< Sibling requests answered with a MISS
+    uint32_t m_summariesSent;           //!< Summary datagrams sent
+    uint64_t m_summaryBytesSent;        //!< Bytes of those datagrams
+    uint64_t m_summaryBytesReceived;    //!< Bytes of the summaries received
+    uint32_t m_coreCount;               //!< Worker cores, 0 for instant service
+    uint32_t m_coreQueueSize;           //!< Jobs a core holds, the one in service included
+    CoreSteering m_coreSteering;        //!< Key picking the core of a request
+    Time m_parseTime;                   //!< Service time of every job
+    Time m_hitTime;                     //!< Service time of a hit
+    Time m_missTime;                    //!< Service time of a miss
+    Time m_insertTime;                  //!< Service time of an insertion in the cache
+    Time m_evictTime;                   //!< Service time of an eviction
+    CorePool m_cores;                   //!< Queues of the worker cores
+    bool m_deferSends;                  //!< Whether a core job is in progress
+    Time m_serviceTime;                 //!< Service time of the core job in progress
+    std::vector<DeferredSend> m_deferredSends; //!< Outputs of the core job in progress
+    std::deque<EventId> m_coreSends;    //!< Outputs of the jobs queued on the cores, cancelled on stop
+    Time m_batchDelay;                  //!< Sum of the time ids waited in a batch
+    Time m_startTime;                   //!< Start of the application
     Address contentServerAddress;
 };
 
+/**
+ * \brief UdpCacheServer with its replacement policy fixed at compile time.
+ *
+ * The packet and timer handlers are instantiated for the concrete, final
+ * Policy, so lookups and evictions are direct calls that the compiler can
+ * inline instead of virtual calls through CacheEvictionPolicy. Each
+ * instantiation is registered as its own TypeId (e.g. ns3::LruUdpCacheServer).
+ *
+ * The policy is the template argument: the EvictionPolicy attribute is
+ * ignored, and so is SmallCacheMode, since a flat array would bring back the
+ * runtime dispatch this class removes. A small FIFO, LRU or LFU cache is
+ * therefore faster as a plain UdpCacheServer in SmallCacheMode.
+ */
+template <typename Policy>
+class BasicUdpCacheServer : public UdpCacheServer
+{
+  public:
+    static TypeId GetTypeId();
+    BasicUdpCacheServer();
+    ~BasicUdpCacheServer() override;
+
+  protected:
+    void DoDispose() override;
+    /**
+     * \brief Create the Policy cache, whatever EvictionPolicy and SmallCacheMode say.
+     * \param capacity maximum number of cached ids
+     * \return the cache, also kept as the final type for the handlers
+     */
+    Ptr<CacheEvictionPolicy> CreateCache(uint32_t capacity) override;
+    void HandleReadClients(Ptr<Socket> socket) override;
+    void HandleReadServer(Ptr<Socket> socket) override;
+    void HandleFetchTimers() override;
+    void HandleExpirationTimers() override;
+
+  private:
+    Ptr<Policy> m_policy; //!< The cache, same object as the one seen through CacheEvictionPolicy
+};
+
+typedef BasicUdpCacheServer<FifoCachePolicy> FifoUdpCacheServer;
+typedef BasicUdpCacheServer<LruCachePolicy> LruUdpCacheServer;
+typedef BasicUdpCacheServer<LfuCachePolicy> LfuUdpCacheServer;
+typedef BasicUdpCacheServer<TwoQueueCachePolicy> TwoQueueUdpCacheServer;
+typedef BasicUdpCacheServer<ArcCachePolicy> ArcUdpCacheServer;
+typedef BasicUdpCacheServer<SieveCachePolicy> SieveUdpCacheServer;
+typedef BasicUdpCacheServer<S3FifoCachePolicy> S3FifoUdpCacheServer;
+typedef BasicUdpCacheServer<GdsfCachePolicy> GdsfUdpCacheServer;
+
+// Instantiated once, in udp-cache-server.cc
+extern template class BasicUdpCacheServer<FifoCachePolicy>;
+extern template class BasicUdpCacheServer<LruCachePolicy>;
+extern template class BasicUdpCacheServer<LfuCachePolicy>;
+extern template class BasicUdpCacheServer<TwoQueueCachePolicy>;
+extern template class BasicUdpCacheServer<ArcCachePolicy>;
+extern template class BasicUdpCacheServer<SieveCachePolicy>;
+extern template class BasicUdpCacheServer<S3FifoCachePolicy>;
+extern template class BasicUdpCacheServer<GdsfCachePolicy>;
+
 } // namespace ns3
 
 #endif /* UDP_CACHE_SERVER_H */
@@ -1,21 +1,30 @@
 #include "udp-content-provider.h"
+#include "output-file.h"
 
 #include "ns3/address-utils.h"
+#include "ns3/data-rate.h"
+#include "ns3/enum.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
+#include "ns3/pointer.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/socket.h"
+#include "ns3/string.h"
 #include "ns3/udp-socket.h"
 #include "ns3/uinteger.h"
 
-#include <regex>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
 
 namespace ns3
 {
@@ -37,6 +46,112 @@ UdpContentProvider::GetTypeId()
                           UintegerValue(15),
                           MakeUintegerAccessor(&UdpContentProvider::m_port),
                           MakeUintegerChecker<uint16_t>())
+            .AddAttribute("MaxPayloadSize",
+                          "Largest payload of a batched response, in bytes",
+                          UintegerValue(1472),
+                          MakeUintegerAccessor(&UdpContentProvider::m_maxPayloadSize),
+                          MakeUintegerChecker<uint32_t>(64))
+            .AddAttribute("Protocol",
+                          "Encoding of the responses sent to the cache",
+                          EnumValue(CacheProtocolHeader::BINARY),
+                          MakeEnumAccessor(&UdpContentProvider::m_protocol),
+                          MakeEnumChecker(CacheProtocolHeader::TEXT, "TEXT",
+                                          CacheProtocolHeader::BINARY, "BINARY"))
+            .AddAttribute("ObjectSize",
+                          "Distribution of the object sizes in bytes, drawn once per id; "
+                          "0 answers with a single datagram",
+                          StringValue("ns3::ConstantRandomVariable[Constant=0]"),
+                          MakePointerAccessor(&UdpContentProvider::m_objectSize),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("ObjectTtl",
+                          "Distribution of the object TTLs in seconds, drawn once per id and "
+                          "sent with the responses; 0 leaves the TTL to the cache",
+                          StringValue("ns3::ConstantRandomVariable[Constant=0]"),
+                          MakePointerAccessor(&UdpContentProvider::m_objectTtl),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("UpdateInterval",
+                          "Time between two updates of an object, in seconds, e.g. an exponential "
+                          "for Poisson updates; 0 means objects never change",
+                          StringValue("ns3::ConstantRandomVariable[Constant=0]"),
+                          MakePointerAccessor(&UdpContentProvider::m_updateInterval),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("UpdateId",
+                          "Id of the object changed by each update, rounded",
+                          StringValue("ns3::UniformRandomVariable[Min=1|Max=100]"),
+                          MakePointerAccessor(&UdpContentProvider::m_updateId),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("InvalidationMode",
+                          "How the caches that sent requests learn that an object changed",
+                          EnumValue(UdpContentProvider::NO_INVALIDATION),
+                          MakeEnumAccessor(&UdpContentProvider::m_invalidationMode),
+                          MakeEnumChecker(UdpContentProvider::NO_INVALIDATION, "NONE",
+                                          UdpContentProvider::INVALIDATE, "INVALIDATE",
+                                          UdpContentProvider::UPDATE, "UPDATE"))
+            .AddAttribute("InvalidationWindow",
+                          "Time during which updated ids are collected into batched invalidations "
+                          "(0 means one message per update)",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UdpContentProvider::m_invalidationWindow),
+                          MakeTimeChecker())
+            .AddAttribute("CatalogueFile",
+                          "File with one \"id size [ttl]\" line per object, the TTL in seconds, "
+                          "overriding ObjectSize and ObjectTtl for the listed ids",
+                          StringValue(""),
+                          MakeStringAccessor(&UdpContentProvider::m_catalogueFile),
+                          MakeStringChecker())
+            .AddAttribute("Mtu",
+                          "IP MTU of the path to the cache, every segment of an object fits in it",
+                          UintegerValue(1400),
+                          MakeUintegerAccessor(&UdpContentProvider::m_mtu),
+                          MakeUintegerChecker<uint32_t>(64))
+            .AddAttribute("PacingRate",
+                          "Rate at which the segments of the objects are sent, 0 for no pacing",
+                          DataRateValue(DataRate("0bps")),
+                          MakeDataRateAccessor(&UdpContentProvider::m_pacingRate),
+                          MakeDataRateChecker())
+            .AddAttribute("SendWindow",
+                          "Segments that can be sent back to back when pacing",
+                          UintegerValue(4),
+                          MakeUintegerAccessor(&UdpContentProvider::m_sendWindow),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("MaxConcurrency",
+                          "Requests the backend serves at once, each for a BackendLatency draw "
+                          "(0 means every request is answered at once, without limit); the "
+                          "queue wait adds to the fetch times of the caches, whose "
+                          "retransmission timeout then tracks the backend queueing",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UdpContentProvider::m_maxConcurrency),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("QueueSize",
+                          "Requests waiting for a free backend slot; beyond, requests are shed "
+                          "with a BUSY response and the cache sends them again after a backoff",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&UdpContentProvider::m_queueSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("QueueDiscipline",
+                          "Order of the queued requests: arrival order, or client misses before "
+                          "prefetches and refreshes, which are also shed first",
+                          EnumValue(UdpContentProvider::FIFO),
+                          MakeEnumAccessor(&UdpContentProvider::m_queueDiscipline),
+                          MakeEnumChecker(UdpContentProvider::FIFO, "FIFO",
+                                          UdpContentProvider::PRIORITY, "PRIORITY"))
+            .AddAttribute("BackendLatency",
+                          "Time the backend takes per request, in seconds, e.g. a lognormal",
+                          StringValue("ns3::ConstantRandomVariable[Constant=0]"),
+                          MakePointerAccessor(&UdpContentProvider::m_backendLatency),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("BackendLatencyFile",
+                          "File with one measured backend latency in seconds per line, "
+                          "replacing BackendLatency with their empirical distribution",
+                          StringValue(""),
+                          MakeStringAccessor(&UdpContentProvider::m_backendLatencyFile),
+                          MakeStringChecker())
+            .AddAttribute("StatsInterval",
+                          "Time between two samples of the backend load in output/originload-<node>.csv "
+                          "(0 means no samples)",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&UdpContentProvider::m_statsInterval),
+                          MakeTimeChecker())
             .AddTraceSource("Rx",
                             "A packet has been received",
                             MakeTraceSourceAccessor(&UdpContentProvider::m_rxTrace),
@@ -51,6 +166,9 @@ UdpContentProvider::GetTypeId()
 UdpContentProvider::UdpContentProvider()
 {
     NS_LOG_FUNCTION(this);
+    // read by the path statistics, also before the start
+    m_requestedIds = 0;
+    m_backendStream = -1;
 }
 
 UdpContentProvider::~UdpContentProvider()
@@ -59,6 +177,21 @@ UdpContentProvider::~UdpContentProvider()
     m_socket = nullptr;
 }
 
+uint32_t
+UdpContentProvider::GetRequests() const
+{
+    return m_requestedIds;
+}
+
+int64_t
+UdpContentProvider::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_backendStream = stream;
+    m_backendLatency->SetStream(stream);
+    return 1;
+}
+
 void
 UdpContentProvider::DoDispose()
 {
@@ -83,6 +216,44 @@ UdpContentProvider::StartApplication()
     }
 
     m_socket->SetRecvCallback(MakeCallback(&UdpContentProvider::HandleRead, this));
+    m_sender.Configure(m_socket, m_mtu, m_pacingRate, m_sendWindow);
+    loadCatalogue();
+
+    if (m_invalidationMode != NO_INVALIDATION && m_protocol == CacheProtocolHeader::TEXT)
+    {
+        NS_FATAL_ERROR("Invalidations need the BINARY protocol");
+    }
+    m_versions.clear();
+    m_caches.clear();
+    m_changed.clear();
+    m_updating = false;
+    m_updates = 0;
+    m_invalidations = 0;
+    m_invalidationDatagrams = 0;
+    m_pushedUpdates = 0;
+    m_requestedIds = 0;
+    scheduleUpdate();
+
+    m_queue.clear();
+    m_backgroundQueue.clear();
+    m_active = 0;
+    m_started = 0;
+    m_served = 0;
+    m_shed = 0;
+    m_queueDelay = Time();
+    m_queueDelayMax = Time();
+    m_busySeconds = 0;
+    m_startTime = Simulator::Now();
+    m_lastBusyChange = Simulator::Now();
+    m_loadSamples.clear();
+    if (m_maxConcurrency > 0)
+    {
+        loadBackendLatency();
+        if (m_statsInterval.IsStrictlyPositive())
+        {
+            m_statsEvent = Simulator::Schedule(m_statsInterval, &UdpContentProvider::sampleLoad, this);
+        }
+    }
 }
 
 void
@@ -95,6 +266,26 @@ UdpContentProvider::StopApplication()
         m_socket->Close();
         m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
+    m_sender.Stop();
+    Simulator::Cancel(m_updateEvent);
+    Simulator::Cancel(m_invalidationEvent);
+    Simulator::Cancel(m_statsEvent);
+    for (EventId& completion : m_backendEvents)
+    {
+        Simulator::Cancel(completion);
+    }
+    m_backendEvents.clear();
+    if (m_updating || m_maxConcurrency > 0)
+    {
+        updateBusyTime();
+        printOut();
+    }
+    if (!m_loadSamples.empty())
+    {
+        printLoad();
+    }
+    m_queue.clear();
+    m_backgroundQueue.clear();
 }
 
 void
@@ -121,11 +312,39 @@ UdpContentProvider::HandleRead(Ptr<Socket> socket)
         packet->RemoveAllPacketTags();
         packet->RemoveAllByteTags();
 
-        uint32_t value_from_pkt = getIdPacket(packet);
+        // a cache registers for invalidations by sending requests
+        if (m_invalidationMode != NO_INVALIDATION &&
+            std::find(m_caches.begin(), m_caches.end(), from) == m_caches.end())
+        {
+            m_caches.push_back(from);
+        }
+
+        getRequestsPacket(packet, m_requests);
+        m_requestedIds += m_requests.size();
 
-        NS_LOG_LOGIC("Serve the request of packet with id: " << value_from_pkt);
-        
-        sendPacketBackToCache(value_from_pkt, from);
+        // with a backend model, every id of a batch is a request of its own
+        if (m_maxConcurrency > 0)
+        {
+            for (const CacheProtocolHeader& request : m_requests)
+            {
+                admitRequest(request, from);
+            }
+            continue;
+        }
+
+        if (m_requests.size() > 1 || (m_protocol == CacheProtocolHeader::BINARY && !m_requests.empty()))
+        {
+            NS_LOG_LOGIC("Serve the request of " << m_requests.size() << " packets");
+            sendBatchBackToCache(m_requests, from);
+        }
+        else
+        {
+            uint32_t value_from_pkt = m_requests.empty() ? 0 : m_requests.front().GetObjectId();
+
+            NS_LOG_LOGIC("Serve the request of packet with id: " << value_from_pkt);
+
+            sendPacketBackToCache(value_from_pkt, from);
+        }
 
         if (InetSocketAddress::IsMatchingType(from))
         {
@@ -140,21 +359,425 @@ UdpContentProvider::HandleRead(Ptr<Socket> socket)
 uint32_t
 UdpContentProvider::getIdPacket(Ptr<Packet> packet)
 {
-    uint8_t* buffer = new uint8_t[packet->GetSize()];
-    packet->CopyData(buffer, packet->GetSize());
-    std::string payload = std::string(reinterpret_cast<char*>(buffer), packet->GetSize());
-    std::regex six_digit_number_regex(R"(\b\d{1,6}\b)");
+    return CacheProtocolHeader::ReadTextId(packet, m_rxBuffer);
+}
+
+void
+UdpContentProvider::loadCatalogue()
+{
+    m_objectSizes.clear();
+    m_objectTtls.clear();
+    if (m_catalogueFile.empty())
+    {
+        return;
+    }
+
+    std::ifstream catalogue(m_catalogueFile);
+    if (!catalogue.is_open())
+    {
+        NS_FATAL_ERROR("Failed to open catalogue file " << m_catalogueFile);
+    }
+    std::string line;
+    while (std::getline(catalogue, line))
+    {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        uint32_t id;
+        uint32_t size;
+        double ttl;
+        if (fields >> id >> size)
+        {
+            m_objectSizes[id] = size;
+            if (fields >> ttl)
+            {
+                m_objectTtls[id] = Seconds(std::max(0.0, ttl));
+            }
+        }
+    }
+    NS_LOG_INFO("Read the size of " << m_objectSizes.size() << " objects from " << m_catalogueFile);
+}
+
+uint32_t
+UdpContentProvider::getObjectSize(uint32_t id)
+{
+    auto it = m_objectSizes.find(id);
+    if (it != m_objectSizes.end())
+    {
+        return it->second;
+    }
+    double size = std::max(0.0, std::round(m_objectSize->GetValue()));
+    return m_objectSizes[id] = static_cast<uint32_t>(std::min<double>(size, UINT32_MAX));
+}
+
+uint16_t
+UdpContentProvider::getResponseFlags(uint32_t id)
+{
+    uint16_t flags = 0;
+    if (!getObjectTtl(id).IsZero())
+    {
+        flags |= CacheProtocolHeader::TTL;
+    }
+    if (m_updating)
+    {
+        flags |= CacheProtocolHeader::VERSION;
+    }
+    return flags;
+}
+
+void
+UdpContentProvider::addResponseOptions(Ptr<Packet> packet, const CacheProtocolHeader& response)
+{
+    uint32_t id = static_cast<uint32_t>(response.GetObjectId());
+    // prepended, so the version goes first to end up after the TTL
+    if (response.GetFlags() & CacheProtocolHeader::VERSION)
+    {
+        CacheVersionHeader version;
+        auto it = m_versions.find(id);
+        if (it != m_versions.end())
+        {
+            version.SetVersion(it->second.version);
+            version.SetUpdated(it->second.updated);
+        }
+        packet->AddHeader(version);
+    }
+    if (response.GetFlags() & CacheProtocolHeader::TTL)
+    {
+        CacheTtlHeader ttl;
+        ttl.SetTtl(getObjectTtl(id));
+        packet->AddHeader(ttl);
+    }
+}
+
+void
+UdpContentProvider::scheduleUpdate()
+{
+    double interval = m_updateInterval->GetValue();
+    if (interval <= 0)
+    {
+        return;
+    }
+    m_updating = true;
+    m_updateEvent = Simulator::Schedule(Seconds(interval), &UdpContentProvider::updateObject, this);
+}
+
+void
+UdpContentProvider::updateObject()
+{
+    uint32_t id = static_cast<uint32_t>(std::max(1.0, std::round(m_updateId->GetValue())));
+    ObjectVersion& version = m_versions[id];
+    version.version++;
+    version.updated = Simulator::Now();
+    m_updates++;
+    NS_LOG_LOGIC("Object " << id << " updated to version " << version.version);
+
+    if (m_invalidationMode != NO_INVALIDATION && !m_caches.empty() &&
+        std::find(m_changed.begin(), m_changed.end(), id) == m_changed.end())
+    {
+        m_changed.push_back(id);
+        if (m_invalidationWindow.IsZero())
+        {
+            flushInvalidations();
+        }
+        else if (m_changed.size() == 1)
+        {
+            m_invalidationEvent = Simulator::Schedule(m_invalidationWindow, &UdpContentProvider::flushInvalidations, this);
+        }
+    }
+    scheduleUpdate();
+}
+
+void
+UdpContentProvider::flushInvalidations()
+{
+    Simulator::Cancel(m_invalidationEvent);
+    for (const Address& cache : m_caches)
+    {
+        if (m_invalidationMode == UPDATE)
+        {
+            // pushed as unsolicited responses, segmented like any other
+            m_pushed.clear();
+            CacheProtocolHeader update;
+            update.SetFlags(CacheProtocolHeader::UPDATE);
+            for (uint32_t id : m_changed)
+            {
+                update.SetObjectId(id);
+                m_pushed.push_back(update);
+            }
+            sendBatchBackToCache(m_pushed, cache);
+            m_pushedUpdates += m_pushed.size();
+            continue;
+        }
+
+        CacheProtocolHeader header;
+        header.SetMessageType(CacheProtocolHeader::INVALIDATE);
+        header.SetRole(CacheProtocolHeader::SERVER);
+        CacheVersionHeader version;
+        uint32_t entrySize = header.GetSerializedSize() + version.GetSerializedSize();
+        uint32_t perPacket = std::max<uint32_t>(1, m_maxPayloadSize / entrySize);
+        for (uint32_t first = 0; first < m_changed.size(); first += perPacket)
+        {
+            uint32_t last = std::min<uint32_t>(first + perPacket, m_changed.size());
+            Ptr<Packet> packet = Create<Packet>();
+            // headers are prepended, add them backwards to keep the update order
+            for (uint32_t i = last; i-- > first;)
+            {
+                const ObjectVersion& current = m_versions[m_changed[i]];
+                version.SetVersion(current.version);
+                version.SetUpdated(current.updated);
+                header.SetObjectId(m_changed[i]);
+                packet->AddHeader(version);
+                packet->AddHeader(header);
+            }
+            m_socket->SendTo(packet, 0, cache);
+            m_invalidationDatagrams++;
+        }
+        m_invalidations += m_changed.size();
+    }
+    m_changed.clear();
+}
+
+void
+UdpContentProvider::printOut()
+{
+    std::string fileName = NodeOutputFile("originstats", GetNode()->GetId(), ".txt");
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    outputFile << "updates:" << m_updates << ";" << "caches:" << m_caches.size() << ";"
+               << "invalidations:" << m_invalidations << ";" << "invalidationdatagrams:" << m_invalidationDatagrams << ";"
+               << "pushedupdates:" << m_pushedUpdates << ";" << "requests:" << m_requestedIds << ";";
+    if (m_maxConcurrency > 0)
+    {
+        double seconds = (Simulator::Now() - m_startTime).GetSeconds();
+        outputFile << "served:" << m_served << ";" << "shed:" << m_shed << ";"
+                   << "shedrate:" << (m_requestedIds > 0 ? double(m_shed) / m_requestedIds : 0) << ";"
+                   << "utilization:" << (seconds > 0 ? m_busySeconds / (seconds * m_maxConcurrency) : 0) << ";"
+                   << "queuedelayavgms:" << (m_started > 0 ? m_queueDelay.GetSeconds() * 1000 / m_started : 0) << ";"
+                   << "queuedelaymaxms:" << m_queueDelayMax.GetSeconds() * 1000 << ";";
+    }
+    outputFile << std::endl;
+    outputFile.close();
+}
+
+void
+UdpContentProvider::admitRequest(const CacheProtocolHeader& request, const Address& from)
+{
+    BackendRequest job{request, from, Simulator::Now()};
+    if (m_active < m_maxConcurrency)
+    {
+        startRequest(job);
+        return;
+    }
+    bool background = m_queueDiscipline == PRIORITY &&
+                      (request.GetFlags() & (CacheProtocolHeader::PREFETCH | CacheProtocolHeader::REFRESH));
+    if (m_queue.size() + m_backgroundQueue.size() < m_queueSize)
+    {
+        (background ? m_backgroundQueue : m_queue).push_back(job);
+        return;
+    }
+    // a full queue makes room for a client miss by shedding the newest background request
+    if (!background && !m_backgroundQueue.empty())
+    {
+        shedRequest(m_backgroundQueue.back());
+        m_backgroundQueue.pop_back();
+        m_queue.push_back(job);
+        return;
+    }
+    shedRequest(job);
+}
+
+void
+UdpContentProvider::startRequest(const BackendRequest& job)
+{
+    updateBusyTime();
+    m_active++;
+    m_started++;
+    Time wait = Simulator::Now() - job.arrivedAt;
+    m_queueDelay += wait;
+    m_queueDelayMax = std::max(m_queueDelayMax, wait);
+    // completed requests are dropped from the front
+    while (!m_backendEvents.empty() && !m_backendEvents.front().IsRunning())
+    {
+        m_backendEvents.pop_front();
+    }
+    Time latency = Seconds(std::max(0.0, m_backendLatency->GetValue()));
+    m_backendEvents.push_back(Simulator::Schedule(latency, &UdpContentProvider::completeRequest, this, job));
+}
 
-    std::smatch matches;
-    if (std::regex_search(payload, matches, six_digit_number_regex))
+void
+UdpContentProvider::completeRequest(BackendRequest job)
+{
+    updateBusyTime();
+    m_active--;
+    m_served++;
+    if (m_protocol == CacheProtocolHeader::BINARY)
     {
-        std::string id = matches[0];
-        return static_cast<uint32_t>(std::stoul(id));
+        m_completed.assign(1, job.request);
+        sendBatchBackToCache(m_completed, job.from);
     }
     else
     {
-        // handle whenever the id is not found
-        return 0;
+        sendPacketBackToCache(static_cast<uint32_t>(job.request.GetObjectId()), job.from);
+    }
+
+    std::deque<BackendRequest>& queue = m_queue.empty() ? m_backgroundQueue : m_queue;
+    if (!queue.empty())
+    {
+        BackendRequest next = queue.front();
+        queue.pop_front();
+        startRequest(next);
+    }
+}
+
+void
+UdpContentProvider::shedRequest(const BackendRequest& job)
+{
+    m_shed++;
+    NS_LOG_LOGIC("Backend overloaded, request for id " << job.request.GetObjectId() << " shed");
+    if (m_protocol != CacheProtocolHeader::BINARY)
+    {
+        uint32_t id = static_cast<uint32_t>(job.request.GetObjectId());
+        m_socket->SendTo(CacheProtocolHeader::CreateTextPacket("server", "busy", id), 0, job.from);
+        return;
+    }
+    CacheProtocolHeader response = job.request;
+    response.SetMessageType(CacheProtocolHeader::RESPONSE);
+    response.SetRole(CacheProtocolHeader::SERVER);
+    response.SetFlags(CacheProtocolHeader::BUSY);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(response);
+    m_socket->SendTo(packet, 0, job.from);
+}
+
+void
+UdpContentProvider::updateBusyTime()
+{
+    m_busySeconds += m_active * (Simulator::Now() - m_lastBusyChange).GetSeconds();
+    m_lastBusyChange = Simulator::Now();
+}
+
+void
+UdpContentProvider::loadBackendLatency()
+{
+    if (m_backendLatencyFile.empty())
+    {
+        return;
+    }
+
+    std::ifstream file(m_backendLatencyFile);
+    if (!file.is_open())
+    {
+        NS_FATAL_ERROR("Failed to open backend latency file " << m_backendLatencyFile);
+    }
+    std::vector<double> latencies;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        double latency;
+        if (fields >> latency)
+        {
+            latencies.push_back(std::max(0.0, latency));
+        }
+    }
+    if (latencies.empty())
+    {
+        NS_FATAL_ERROR("No latency in backend latency file " << m_backendLatencyFile);
+    }
+    // each measured latency is drawn with the same probability
+    std::sort(latencies.begin(), latencies.end());
+    Ptr<EmpiricalRandomVariable> empirical = CreateObject<EmpiricalRandomVariable>();
+    for (uint32_t i = 0; i < latencies.size(); i++)
+    {
+        empirical->CDF(latencies[i], double(i + 1) / latencies.size());
+    }
+    if (m_backendStream >= 0)
+    {
+        empirical->SetStream(m_backendStream);
+    }
+    m_backendLatency = empirical;
+    NS_LOG_INFO("Read " << latencies.size() << " backend latencies from " << m_backendLatencyFile);
+}
+
+void
+UdpContentProvider::sampleLoad()
+{
+    updateBusyTime();
+    m_loadSamples.push_back({Simulator::Now(),
+                             m_requestedIds,
+                             m_started,
+                             m_served,
+                             m_shed,
+                             m_queueDelay,
+                             m_busySeconds,
+                             static_cast<uint32_t>(m_queue.size() + m_backgroundQueue.size())});
+    m_statsEvent = Simulator::Schedule(m_statsInterval, &UdpContentProvider::sampleLoad, this);
+}
+
+void
+UdpContentProvider::printLoad()
+{
+    std::string fileName = NodeOutputFile("originload", GetNode()->GetId(), ".csv");
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    // time;requests;served;shed;shedrate;utilization;queuedelayms;queued, per interval
+    LoadSample last{m_startTime, 0, 0, 0, 0, Time(), 0, 0};
+    for (const LoadSample& sample : m_loadSamples)
+    {
+        uint32_t requests = sample.requests - last.requests;
+        uint32_t started = sample.started - last.started;
+        uint32_t shed = sample.shed - last.shed;
+        double seconds = (sample.at - last.at).GetSeconds();
+        outputFile << sample.at.GetSeconds() << ";" << requests << ";" << sample.served - last.served << ";" << shed << ";"
+                   << (requests > 0 ? double(shed) / requests : 0) << ";"
+                   << (seconds > 0 ? (sample.busySeconds - last.busySeconds) / (seconds * m_maxConcurrency) : 0) << ";"
+                   << (started > 0 ? (sample.queueDelay - last.queueDelay).GetSeconds() * 1000 / started : 0) << ";"
+                   << sample.queued << "\n";
+        last = sample;
+    }
+    outputFile.close();
+}
+
+Time
+UdpContentProvider::getObjectTtl(uint32_t id)
+{
+    auto it = m_objectTtls.find(id);
+    if (it != m_objectTtls.end())
+    {
+        return it->second;
+    }
+    return m_objectTtls[id] = Seconds(std::max(0.0, m_objectTtl->GetValue()));
+}
+
+void
+UdpContentProvider::getRequestsPacket(Ptr<Packet> packet, std::vector<CacheProtocolHeader>& requests)
+{
+    requests.clear();
+    CacheProtocolHeader header;
+    if (CacheProtocolHeader::IsBinary(packet))
+    {
+        Ptr<Packet> copy = packet->Copy();
+        while (copy->GetSize() >= header.GetSerializedSize())
+        {
+            copy->RemoveHeader(header);
+            requests.push_back(header);
+        }
+        return;
+    }
+
+    CacheProtocolHeader::ReadTextIds(packet, m_rxBuffer, m_requestIds);
+    for (uint32_t id : m_requestIds)
+    {
+        header.SetObjectId(id);
+        requests.push_back(header);
     }
 }
 
@@ -166,15 +789,93 @@ UdpContentProvider::getRandomNumber(){
 
 void UdpContentProvider::sendPacketBackToCache(uint32_t value_to_send, Address to){
 
-    std::string message = "{ \"sender\": \"server\", \"type\": \"response\", \"id\": " + std::to_string(value_to_send) + " }";
-    uint32_t dataSize = message.size() + 1;
-    uint8_t* m_data = new uint8_t[dataSize];
+    Ptr<Packet> packet = CacheProtocolHeader::CreateTextPacket("server", "response", value_to_send);
+    m_socket->SendTo(packet, 0, to);
+}
 
-    memcpy(m_data, message.c_str(), dataSize);
+void UdpContentProvider::sendBatchBackToCache(const std::vector<CacheProtocolHeader>& requests, Address to){
 
-    Ptr<Packet> packet = Create<Packet>(m_data, dataSize);
-    m_socket->SendTo(packet, 0, to);
+    if (m_protocol == CacheProtocolHeader::BINARY)
+    {
+        // objects with a size are segmented, the others share datagrams
+        m_unsized.clear();
+        for (const CacheProtocolHeader& request : requests)
+        {
+            CacheProtocolHeader response = request;
+            response.SetMessageType(CacheProtocolHeader::RESPONSE);
+            response.SetRole(CacheProtocolHeader::SERVER);
+            uint32_t objectSize = getObjectSize(request.GetObjectId());
+            response.SetFlags(request.GetFlags() | getResponseFlags(request.GetObjectId()));
+            if (objectSize > 0)
+            {
+                Ptr<Packet> options;
+                if (response.GetFlags() & (CacheProtocolHeader::TTL | CacheProtocolHeader::VERSION))
+                {
+                    options = Create<Packet>();
+                    addResponseOptions(options, response);
+                }
+                m_sender.Send(response, objectSize, to, options);
+            }
+            else
+            {
+                m_unsized.push_back(response);
+            }
+        }
+
+        uint32_t headerSize = CacheProtocolHeader().GetSerializedSize();
+        uint32_t ttlSize = CacheTtlHeader().GetSerializedSize();
+        uint32_t versionSize = CacheVersionHeader().GetSerializedSize();
+        for (uint32_t first = 0; first < m_unsized.size();)
+        {
+            // entries with optional headers take more bytes, fill the payload greedily
+            uint32_t last = first;
+            uint32_t bytes = 0;
+            while (last < m_unsized.size())
+            {
+                uint16_t flags = m_unsized[last].GetFlags();
+                uint32_t entry = headerSize + (flags & CacheProtocolHeader::TTL ? ttlSize : 0) +
+                                 (flags & CacheProtocolHeader::VERSION ? versionSize : 0);
+                if (last > first && bytes + entry > m_maxPayloadSize)
+                {
+                    break;
+                }
+                bytes += entry;
+                last++;
+            }
+            Ptr<Packet> packet = Create<Packet>();
+            // headers are prepended, add them backwards to keep the request order
+            for (uint32_t i = last; i-- > first;)
+            {
+                addResponseOptions(packet, m_unsized[i]);
+                packet->AddHeader(m_unsized[i]);
+            }
+            m_socket->SendTo(packet, 0, to);
+            first = last;
+        }
+        return;
+    }
+
+    const std::string head = "{ \"sender\": \"server\", \"type\": \"response\", \"ids\": [";
+    const std::string tail = "] }";
+    std::string message = head;
+    for (const CacheProtocolHeader& request : requests)
+    {
+        std::string id = std::to_string(request.GetObjectId());
+        // the response, null terminator included, must fit in one datagram
+        if (message.size() > head.size() && message.size() + id.size() + 2 + tail.size() + 1 > m_maxPayloadSize)
+        {
+            message += tail;
+            m_socket->SendTo(Create<Packet>(reinterpret_cast<const uint8_t*>(message.c_str()), message.size() + 1), 0, to);
+            message = head;
+        }
+        if (message.size() > head.size())
+        {
+            message += ", ";
+        }
+        message += id;
+    }
+    message += tail;
+    m_socket->SendTo(Create<Packet>(reinterpret_cast<const uint8_t*>(message.c_str()), message.size() + 1), 0, to);
 }
 
 } // Namespace ns3
-
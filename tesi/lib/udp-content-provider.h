@@ -1,26 +1,66 @@
 #ifndef UDP_CONTENT_PROVIDER_H
 #define UDP_CONTENT_PROVIDER_H
 
+#include "cache-protocol-header.h"
+#include "object-transfer.h"
+
 #include "ns3/address.h"
 #include "ns3/application.h"
+#include "ns3/data-rate.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/traced-callback.h"
 #include "ns3/uinteger.h"
 
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace ns3
 {
 
 class Socket;
 class Packet;
+class RandomVariableStream;
 
 class UdpContentProvider : public Application
 {
   public:
+    /// How the caches learn that an object changed
+    enum InvalidationMode
+    {
+        NO_INVALIDATION, //!< Caches only learn it when their copy expires
+        INVALIDATE,      //!< Caches are told to drop their copy
+        UPDATE,          //!< Caches are sent the new version
+    };
+
+    /// Order in which the queued requests reach the backend
+    enum QueueDiscipline
+    {
+        FIFO,     //!< Arrival order
+        PRIORITY, //!< Client misses before prefetches and refreshes, which are shed first
+    };
+
     static TypeId GetTypeId();
     UdpContentProvider();
     ~UdpContentProvider() override;
 
+    /**
+     * \return the ids requested so far, the load of the origin
+     */
+    uint32_t GetRequests() const;
+
+    /**
+     * \brief Fix the random stream of the backend latencies, for reproducible runs.
+     *
+     * The stream also applies to the distribution read from BackendLatencyFile.
+     *
+     * \param stream the first stream index
+     * \return the number of streams used
+     */
+    int64_t AssignStreams(int64_t stream);
+
   protected:
     void DoDispose() override;
 
@@ -30,15 +70,208 @@ class UdpContentProvider : public Application
 
     void HandleRead(Ptr<Socket> socket);
 
+    /**
+     * \brief Read the objects of CatalogueFile, one "id size [ttl]" line each.
+     */
+    void loadCatalogue();
+
+    /**
+     * \brief Size of an object: from the catalogue, else drawn once from ObjectSize.
+     * \param id the object id
+     * \return the size in bytes, 0 for a single-datagram response
+     */
+    uint32_t getObjectSize(uint32_t id);
+
+    /**
+     * \brief Time to live of an object: from the catalogue, else drawn once from ObjectTtl.
+     * \param id the object id
+     * \return the TTL sent to the cache, 0 to send none
+     */
+    Time getObjectTtl(uint32_t id);
+
+    /**
+     * \param id the object id
+     * \return the TTL and VERSION flags of the responses carrying the object
+     */
+    uint16_t getResponseFlags(uint32_t id);
+
+    /**
+     * \brief Prepend the optional headers announced by the flags of a response.
+     * \param packet the packet, the optional headers are prepended to it
+     * \param response the response header, not added
+     */
+    void addResponseOptions(Ptr<Packet> packet, const CacheProtocolHeader& response);
+
+    /**
+     * \brief Schedule the next update, unless updates are disabled.
+     */
+    void scheduleUpdate();
+
+    /**
+     * \brief Change an object drawn from UpdateId and queue its invalidation.
+     */
+    void updateObject();
+
+    /**
+     * \brief Send the invalidations or updates collected in the current window to every cache.
+     */
+    void flushInvalidations();
+
+    /**
+     * \brief Write the update and invalidation counters to output/originstats-<node>.txt.
+     */
+    void printOut();
+
+    /// Request held by the backend, running or queued
+    struct BackendRequest
+    {
+        CacheProtocolHeader request; //!< The request
+        Address from;                //!< The cache that sent it
+        Time arrivedAt;              //!< Time it was received
+    };
+
+    /// Backend counters at the end of a StatsInterval, since the start
+    struct LoadSample
+    {
+        Time at;             //!< End of the interval
+        uint32_t requests;   //!< Ids requested
+        uint32_t started;    //!< Requests that reached the backend
+        uint32_t served;     //!< Requests answered
+        uint32_t shed;       //!< Requests answered busy
+        Time queueDelay;     //!< Time the started requests waited in the queue
+        double busySeconds;  //!< Backend slots in use, integrated over time
+        uint32_t queued;     //!< Requests queued at the end of the interval
+    };
+
+    /**
+     * \brief Start a request on the backend, queue it, or shed it when the queue is full.
+     * \param request the request
+     * \param from the cache that sent it
+     */
+    void admitRequest(const CacheProtocolHeader& request, const Address& from);
+
+    /**
+     * \brief Run a request on a free backend slot for a BackendLatency draw.
+     * \param job the request
+     */
+    void startRequest(const BackendRequest& job);
+
+    /**
+     * \brief Answer a request the backend completed and start the next queued one.
+     * \param job the request
+     */
+    void completeRequest(BackendRequest job);
+
+    /**
+     * \brief Answer a request with a BUSY response, a "busy" message for text requests.
+     * \param job the request
+     */
+    void shedRequest(const BackendRequest& job);
+
+    /**
+     * \brief Account for the backend slots in use since the last change.
+     */
+    void updateBusyTime();
+
+    /**
+     * \brief Read BackendLatencyFile, one latency in seconds per line, as an empirical distribution.
+     */
+    void loadBackendLatency();
+
+    /**
+     * \brief Record the backend counters and schedule the next sample.
+     */
+    void sampleLoad();
+
+    /**
+     * \brief Write the backend load of every StatsInterval to output/originload-<node>.csv.
+     */
+    void printLoad();
+
     uint32_t getIdPacket(Ptr<Packet> packet);
 
+    /**
+     * \brief Parse every request of a single or batched datagram.
+     * \param packet the datagram
+     * \param[out] requests the requests, replaced; text requests only carry the id
+     */
+    void getRequestsPacket(Ptr<Packet> packet, std::vector<CacheProtocolHeader>& requests);
+
     uint32_t getRandomNumber();
 
     void sendPacketBackToCache(uint32_t value_to_send, Address to);
 
+    /**
+     * \brief Answer a batched request with as few responses as MaxPayloadSize allows.
+     * \param requests the requests
+     * \param to the cache address
+     */
+    void sendBatchBackToCache(const std::vector<CacheProtocolHeader>& requests, Address to);
+
     uint16_t m_port;       //!< Port on which we listen for incoming packets.
     Ptr<Socket> m_socket;  //!< IPv4 Socket
     Address m_local;       //!< local multicast address
+    uint32_t m_maxPayloadSize; //!< Largest response payload
+    std::vector<CacheProtocolHeader> m_requests; //!< Scratch list of the requests of a datagram
+    std::vector<uint32_t> m_requestIds;          //!< Scratch list of the ids of a text request
+    std::vector<uint8_t> m_rxBuffer;             //!< Scratch copy of a received text payload
+    CacheProtocolHeader::Format m_protocol; //!< Encoding of the responses
+    std::vector<CacheProtocolHeader> m_unsized; //!< Scratch list of the responses without object bytes
+    Ptr<RandomVariableStream> m_objectSize; //!< Distribution of the object sizes
+    std::string m_catalogueFile;            //!< File with the size of each id, empty for none
+    std::unordered_map<uint32_t, uint32_t> m_objectSizes; //!< Size of every id served so far
+    Ptr<RandomVariableStream> m_objectTtl;  //!< Distribution of the object TTLs, in seconds
+    std::unordered_map<uint32_t, Time> m_objectTtls; //!< TTL of every id served so far
+    uint32_t m_mtu;                         //!< IP MTU of the segments
+    DataRate m_pacingRate;                  //!< Pacing rate of the segments, 0 for none
+    uint32_t m_sendWindow;                  //!< Segments sent back to back
+    ObjectSender m_sender;                  //!< Segmentation and pacing of the objects
+
+    /// Current version of an object
+    struct ObjectVersion
+    {
+        uint32_t version; //!< Updates of the object so far
+        Time updated;     //!< Time of the last update
+    };
+
+    Ptr<RandomVariableStream> m_updateInterval; //!< Time between two updates, in seconds
+    Ptr<RandomVariableStream> m_updateId;       //!< Id changed by each update
+    InvalidationMode m_invalidationMode;        //!< How the caches learn about updates
+    Time m_invalidationWindow;                  //!< Collection window of the invalidations, 0 to send each at once
+    bool m_updating;                            //!< Whether objects change, so responses carry a version
+    std::unordered_map<uint32_t, ObjectVersion> m_versions; //!< Version of every updated id
+    std::vector<Address> m_caches;              //!< Caches that sent a request, receiving the invalidations
+    std::vector<uint32_t> m_changed;            //!< Ids updated in the current window
+    std::vector<CacheProtocolHeader> m_pushed;  //!< Scratch list of the pushed updates
+    EventId m_updateEvent;                      //!< Next update
+    EventId m_invalidationEvent;                //!< End of the current invalidation window
+    uint32_t m_updates;                         //!< Updates so far
+    uint32_t m_invalidations;                   //!< Invalidations sent, one per id and cache
+    uint32_t m_invalidationDatagrams;           //!< Datagrams carrying invalidations
+    uint32_t m_pushedUpdates;                   //!< Updates pushed, one per id and cache
+    uint32_t m_requestedIds;                    //!< Ids requested so far
+    uint32_t m_maxConcurrency;                  //!< Requests the backend runs at once, 0 to answer at once
+    uint32_t m_queueSize;                       //!< Requests waiting for the backend before shedding
+    QueueDiscipline m_queueDiscipline;          //!< Order of the queued requests
+    Ptr<RandomVariableStream> m_backendLatency; //!< Time the backend takes per request, in seconds
+    std::string m_backendLatencyFile;           //!< File of measured latencies, empty for BackendLatency
+    int64_t m_backendStream;                    //!< Stream of the backend latencies, -1 if not assigned
+    Time m_statsInterval;                       //!< Time between two load samples, 0 for none
+    std::deque<BackendRequest> m_queue;         //!< Queued requests, client misses under PRIORITY
+    std::deque<BackendRequest> m_backgroundQueue; //!< Queued prefetches and refreshes under PRIORITY
+    uint32_t m_active;                          //!< Requests running on the backend
+    std::deque<EventId> m_backendEvents;        //!< Completions of the running requests, cancelled on stop
+    std::vector<CacheProtocolHeader> m_completed; //!< Scratch list of the request answered
+    uint32_t m_started;                         //!< Requests that reached the backend
+    uint32_t m_served;                          //!< Requests answered by the backend
+    uint32_t m_shed;                            //!< Requests answered busy
+    Time m_queueDelay;                          //!< Time the started requests waited in the queue
+    Time m_queueDelayMax;                       //!< Longest wait in the queue
+    double m_busySeconds;                       //!< Backend slots in use, integrated over time
+    Time m_lastBusyChange;                      //!< Last change of the slots in use
+    Time m_startTime;                           //!< Start of the application
+    std::vector<LoadSample> m_loadSamples;      //!< Backend counters at the end of every StatsInterval
+    EventId m_statsEvent;                       //!< Next load sample
 
     /// Callbacks for tracing the packet Rx events
     TracedCallback<Ptr<const Packet>> m_rxTrace;
@@ -0,0 +1,427 @@
+#include "udp-router-cache.h"
+
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/uinteger.h"
+
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("UdpRouterCache");
+
+NS_OBJECT_ENSURE_REGISTERED(OnPathInterceptor);
+NS_OBJECT_ENSURE_REGISTERED(UdpRouterCache);
+
+TypeId
+OnPathInterceptor::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::OnPathInterceptor")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<OnPathInterceptor>();
+    return tid;
+}
+
+void
+OnPathInterceptor::SetHandler(Handler handler)
+{
+    m_handler = handler;
+}
+
+Ptr<Ipv4Route>
+OnPathInterceptor::RouteOutput(Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif, Socket::SocketErrno& sockerr)
+{
+    // left to the next protocols of the list
+    sockerr = Socket::ERROR_NOROUTETOHOST;
+    return nullptr;
+}
+
+bool
+OnPathInterceptor::RouteInput(Ptr<const Packet> p,
+                              const Ipv4Header& header,
+                              Ptr<const NetDevice> idev,
+                              const UnicastForwardCallback& ucb,
+                              const MulticastForwardCallback& mcb,
+                              const LocalDeliverCallback& lcb,
+                              const ErrorCallback& ecb)
+{
+    return !m_handler.IsNull() && header.GetProtocol() == UdpL4Protocol::PROT_NUMBER && m_handler(p, header);
+}
+
+void
+OnPathInterceptor::NotifyInterfaceUp(uint32_t interface)
+{
+}
+
+void
+OnPathInterceptor::NotifyInterfaceDown(uint32_t interface)
+{
+}
+
+void
+OnPathInterceptor::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+OnPathInterceptor::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+OnPathInterceptor::SetIpv4(Ptr<Ipv4> ipv4)
+{
+}
+
+void
+OnPathInterceptor::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+}
+
+TypeId
+UdpRouterCache::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::UdpRouterCache")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<UdpRouterCache>()
+            .AddAttribute("CacheSize",
+                          "Size of the cache",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&UdpRouterCache::m_cacheSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("EvictionPolicy",
+                          "Replacement policy used when the cache is full",
+                          EnumValue(CacheEvictionPolicy::LRU),
+                          MakeEnumAccessor(&UdpRouterCache::m_evictionPolicy),
+                          MakeEnumChecker(CacheEvictionPolicy::FIFO, "FIFO",
+                                          CacheEvictionPolicy::LRU, "LRU",
+                                          CacheEvictionPolicy::LFU, "LFU",
+                                          CacheEvictionPolicy::TWO_Q, "2Q",
+                                          CacheEvictionPolicy::ARC, "ARC",
+                                          CacheEvictionPolicy::SIEVE, "SIEVE",
+                                          CacheEvictionPolicy::S3_FIFO, "S3-FIFO",
+                                          CacheEvictionPolicy::GDSF, "GDSF"))
+            .AddAttribute("Placement",
+                          "Which routers on the path of a response keep a copy: all, the one "
+                          "below the node that served it, or each with the ProbCache probability",
+                          EnumValue(UdpRouterCache::LEAVE_COPY_EVERYWHERE),
+                          MakeEnumAccessor(&UdpRouterCache::m_placement),
+                          MakeEnumChecker(UdpRouterCache::LEAVE_COPY_EVERYWHERE, "LCE",
+                                          UdpRouterCache::LEAVE_COPY_DOWN, "LCD",
+                                          UdpRouterCache::PROB_CACHE, "PROBCACHE"))
+            .AddAttribute("TargetWindow",
+                          "Copies of an object ProbCache aims at on a path (T_tw), "
+                          "lower values cache more",
+                          DoubleValue(10),
+                          MakeDoubleAccessor(&UdpRouterCache::m_targetWindow),
+                          MakeDoubleChecker<double>(1))
+            .AddAttribute("ContentPort",
+                          "Port of the content server, only its requests and responses are cached",
+                          UintegerValue(15),
+                          MakeUintegerAccessor(&UdpRouterCache::m_contentPort),
+                          MakeUintegerChecker<uint16_t>())
+            .AddAttribute("RequestTimeout",
+                          "Time the hops of a forwarded request are kept for the ProbCache "
+                          "placement of its response; requests left unanswered are forgotten after it",
+                          TimeValue(Seconds(2)),
+                          MakeTimeAccessor(&UdpRouterCache::m_requestTimeout),
+                          MakeTimeChecker());
+    return tid;
+}
+
+UdpRouterCache::UdpRouterCache()
+    : m_initialTtl(64),
+      m_requests(0),
+      m_hits(0),
+      m_hitHops(0),
+      m_responses(0),
+      m_placed(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+UdpRouterCache::~UdpRouterCache()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+UdpRouterCache::GetRequests() const
+{
+    return m_requests;
+}
+
+uint32_t
+UdpRouterCache::GetHits() const
+{
+    return m_hits;
+}
+
+uint64_t
+UdpRouterCache::GetHitHops() const
+{
+    return m_hitHops;
+}
+
+uint32_t
+UdpRouterCache::GetPlaced() const
+{
+    return m_placed;
+}
+
+void
+UdpRouterCache::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_interceptor)
+    {
+        m_interceptor->SetHandler(MakeNullCallback<bool, Ptr<const Packet>, const Ipv4Header&>());
+    }
+    m_interceptor = nullptr;
+    m_ipv4 = nullptr;
+    m_cache = nullptr;
+    m_random = nullptr;
+    Application::DoDispose();
+}
+
+void
+UdpRouterCache::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+    m_requests = 0;
+    m_hits = 0;
+    m_hitHops = 0;
+    m_responses = 0;
+    m_placed = 0;
+    m_expirations.clear();
+    m_requestHops.clear();
+    m_requestDeadlines.clear();
+    m_cache = CacheEvictionPolicy::CreatePolicy(m_evictionPolicy, m_cacheSize);
+
+    m_ipv4 = GetNode()->GetObject<Ipv4>();
+    if (!m_ipv4)
+    {
+        NS_FATAL_ERROR("Router cache on a node without IPv4");
+    }
+    // the senders are assumed to use the same TTL as this router
+    UintegerValue ttl;
+    m_ipv4->GetAttribute("DefaultTtl", ttl);
+    m_initialTtl = static_cast<uint8_t>(ttl.Get());
+
+    if (!m_interceptor)
+    {
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(m_ipv4->GetRoutingProtocol());
+        if (!list)
+        {
+            NS_FATAL_ERROR("Router cache needs an Ipv4ListRouting, as installed by InternetStackHelper");
+        }
+        m_interceptor = CreateObject<OnPathInterceptor>();
+        // asked before static and global routing for every forwarded datagram
+        list->AddRoutingProtocol(m_interceptor, std::numeric_limits<int16_t>::max());
+    }
+    m_interceptor->SetHandler(MakeCallback(&UdpRouterCache::intercept, this));
+}
+
+void
+UdpRouterCache::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+    // the hook stays in the list, letting everything through
+    if (m_interceptor)
+    {
+        m_interceptor->SetHandler(MakeNullCallback<bool, Ptr<const Packet>, const Ipv4Header&>());
+    }
+}
+
+bool
+UdpRouterCache::intercept(Ptr<const Packet> packet, const Ipv4Header& ip)
+{
+    UdpHeader udp;
+    CacheProtocolHeader header;
+    // fragments of larger datagrams are not looked into
+    if (ip.GetFragmentOffset() != 0 || !ip.IsLastFragment() ||
+        packet->GetSize() < udp.GetSerializedSize() + header.GetSerializedSize())
+    {
+        return false;
+    }
+    Ptr<Packet> copy = packet->Copy();
+    copy->RemoveHeader(udp);
+    if ((udp.GetDestinationPort() != m_contentPort && udp.GetSourcePort() != m_contentPort) ||
+        !CacheProtocolHeader::IsBinary(copy))
+    {
+        return false;
+    }
+    copy->RemoveHeader(header);
+    uint32_t id = static_cast<uint32_t>(header.GetObjectId());
+    uint32_t hops = getHops(ip);
+    expireRequests();
+
+    if (header.GetMessageType() == CacheProtocolHeader::REQUEST && udp.GetDestinationPort() == m_contentPort)
+    {
+        // batched requests go on to the content server whole
+        if (copy->GetSize() > 0)
+        {
+            return false;
+        }
+        m_requests++;
+        bool hit = m_cache->Lookup(id);
+        auto expiration = m_expirations.find(id);
+        if (hit && expiration != m_expirations.end() && expiration->second <= Simulator::Now())
+        {
+            m_cache->Remove(id);
+            m_expirations.erase(expiration);
+            hit = false;
+        }
+        if (!hit)
+        {
+            Time deadline = Simulator::Now() + m_requestTimeout;
+            m_requestHops[id] = ForwardedRequest{hops, deadline};
+            m_requestDeadlines.emplace_back(id, deadline);
+            return false;
+        }
+        m_hits++;
+        m_hitHops += hops;
+        answerRequest(header, udp, ip);
+        NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " router cache hit for id " << id << ", "
+                               << hops << " links from the client");
+        return true;
+    }
+
+    if (header.GetMessageType() != CacheProtocolHeader::RESPONSE || udp.GetSourcePort() != m_contentPort)
+    {
+        return false;
+    }
+    if (header.GetFlags() & (CacheProtocolHeader::SEGMENT | CacheProtocolHeader::MISS | CacheProtocolHeader::BUSY))
+    {
+        // the request is answered, with nothing this router stores
+        m_requestHops.erase(id);
+        return false;
+    }
+    m_responses++;
+    Time ttl;
+    if (header.GetFlags() & CacheProtocolHeader::TTL)
+    {
+        CacheTtlHeader ttlHeader;
+        copy->RemoveHeader(ttlHeader);
+        ttl = ttlHeader.GetTtl();
+    }
+    if (header.GetFlags() & CacheProtocolHeader::VERSION)
+    {
+        CacheVersionHeader version;
+        copy->RemoveHeader(version);
+    }
+    // the objects of a batched response are left to the cache that asked for them
+    bool place = copy->GetSize() == 0 && shouldPlace(id, hops);
+    m_requestHops.erase(id);
+    if (!place)
+    {
+        return false;
+    }
+    if (!m_cache->Contains(id))
+    {
+        uint32_t evicted;
+        if (m_cache->Push(id, &evicted))
+        {
+            m_expirations.erase(evicted);
+        }
+        m_placed++;
+    }
+    if (ttl.IsStrictlyPositive())
+    {
+        m_expirations[id] = Simulator::Now() + ttl;
+    }
+    else
+    {
+        m_expirations.erase(id);
+    }
+    return false;
+}
+
+void
+UdpRouterCache::answerRequest(const CacheProtocolHeader& request, const UdpHeader& udp, const Ipv4Header& ip)
+{
+    CacheProtocolHeader header;
+    header.SetMessageType(CacheProtocolHeader::RESPONSE);
+    header.SetRole(CacheProtocolHeader::CACHE);
+    header.SetFlags(CacheProtocolHeader::CACHED);
+    header.SetSequence(request.GetSequence());
+    header.SetObjectId(request.GetObjectId());
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+
+    // sent in the name of the content server, which the client socket is connected to
+    UdpHeader response;
+    response.SetSourcePort(udp.GetDestinationPort());
+    response.SetDestinationPort(udp.GetSourcePort());
+    if (Node::ChecksumEnabled())
+    {
+        response.EnableChecksums();
+        response.InitializeChecksum(ip.GetDestination(), ip.GetSource(), UdpL4Protocol::PROT_NUMBER);
+    }
+    packet->AddHeader(response);
+    m_ipv4->Send(packet, ip.GetDestination(), ip.GetSource(), UdpL4Protocol::PROT_NUMBER, nullptr);
+}
+
+bool
+UdpRouterCache::shouldPlace(uint32_t id, uint32_t hops)
+{
+    switch (m_placement)
+    {
+    case LEAVE_COPY_EVERYWHERE:
+        return true;
+    case LEAVE_COPY_DOWN:
+        return hops == 1;
+    case PROB_CACHE: {
+        // c links between client and server, x = hops of them behind this router;
+        // the c - x routers left towards the client, this one included, share
+        // TargetWindow copies, and the copies lean towards the client by x / c
+        auto request = m_requestHops.find(id);
+        if (request == m_requestHops.end())
+        {
+            return false;
+        }
+        double c = request->second.hops + hops;
+        double timesIn = request->second.hops / m_targetWindow;
+        return m_random->GetValue() < timesIn * hops / c;
+    }
+    }
+    return false;
+}
+
+void
+UdpRouterCache::expireRequests()
+{
+    // an id forwarded again keeps the deadline of its last request
+    while (!m_requestDeadlines.empty() && m_requestDeadlines.front().second <= Simulator::Now())
+    {
+        auto request = m_requestHops.find(m_requestDeadlines.front().first);
+        if (request != m_requestHops.end() && request->second.deadline <= Simulator::Now())
+        {
+            m_requestHops.erase(request);
+        }
+        m_requestDeadlines.pop_front();
+    }
+}
+
+uint32_t
+UdpRouterCache::getHops(const Ipv4Header& ip) const
+{
+    // the TTL is decremented after the routing decision
+    return ip.GetTtl() <= m_initialTtl ? m_initialTtl - ip.GetTtl() + 1 : 1;
+}
+
+} // namespace ns3
@@ -0,0 +1,193 @@
+#ifndef UDP_ROUTER_CACHE_H
+#define UDP_ROUTER_CACHE_H
+
+#include "cache-eviction-policy.h"
+#include "cache-protocol-header.h"
+
+#include "ns3/application.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <deque>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+namespace ns3
+{
+
+class Ipv4;
+class Packet;
+class UdpHeader;
+
+/**
+ * \brief Routing protocol put first in the Ipv4ListRouting of a router,
+ *        handing every datagram the router forwards to a UdpRouterCache.
+ *
+ * It never routes anything itself: when the handler returns false the
+ * datagram goes on to the other protocols of the list and is forwarded as
+ * usual, when it returns true the datagram is consumed.
+ */
+class OnPathInterceptor : public Ipv4RoutingProtocol
+{
+  public:
+    /// Handler of a forwarded datagram, true if it consumed it
+    typedef Callback<bool, Ptr<const Packet>, const Ipv4Header&> Handler;
+
+    static TypeId GetTypeId();
+
+    /**
+     * \param handler the handler, a null callback to let everything through
+     */
+    void SetHandler(Handler handler);
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override;
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t interface) override;
+    void NotifyInterfaceDown(uint32_t interface) override;
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void SetIpv4(Ptr<Ipv4> ipv4) override;
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const override;
+
+  private:
+    Handler m_handler; //!< Handler of the forwarded datagrams
+};
+
+/**
+ * \brief Cache running on a router, answering the requests it forwards.
+ *
+ * In the style of in-network caching for information-centric networks, the
+ * cache sits on the path between the clients and the content server: every
+ * single-id request for the content server crossing the router is looked
+ * up, and a hit is answered on the spot with the address of the content
+ * server as source, so the client sees an ordinary response, while a miss is
+ * forwarded unchanged. Single-datagram responses coming back are stored
+ * according to the Placement:
+ *  - leave-copy-everywhere stores every object crossing the router;
+ *  - leave-copy-down only stores it one hop below the node that served it,
+ *    the content server or another router cache;
+ *  - ProbCache (Psaras et al.) stores it with a probability growing with the
+ *    caches left towards the client and with the distance from the server.
+ * Distances are counted in links from the IP TTL, the senders using the
+ * DefaultTtl of the router. Segmented objects, batched requests and
+ * invalidations are forwarded untouched.
+ */
+class UdpRouterCache : public Application
+{
+  public:
+    /// Which routers on the path of a response keep a copy
+    enum Placement
+    {
+        LEAVE_COPY_EVERYWHERE, //!< Every router
+        LEAVE_COPY_DOWN,       //!< The router one hop below the node that served it
+        PROB_CACHE,            //!< Each router with the ProbCache probability
+    };
+
+    static TypeId GetTypeId();
+    UdpRouterCache();
+    ~UdpRouterCache() override;
+
+    /**
+     * \return the requests for the content server that crossed the router
+     */
+    uint32_t GetRequests() const;
+
+    /**
+     * \return the requests answered from the cache
+     */
+    uint32_t GetHits() const;
+
+    /**
+     * \return the links between the clients and the router, summed over the hits
+     */
+    uint64_t GetHitHops() const;
+
+    /**
+     * \return the objects stored
+     */
+    uint32_t GetPlaced() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    /**
+     * \brief Look into a datagram forwarded by the router.
+     * \param packet the datagram, from its UDP header
+     * \param ip its IP header
+     * \return true if it was answered from the cache and must be dropped
+     */
+    bool intercept(Ptr<const Packet> packet, const Ipv4Header& ip);
+
+    /**
+     * \brief Answer a request from the cache, in the name of the content server.
+     * \param request the request
+     * \param udp the UDP header of the request
+     * \param ip the IP header of the request
+     */
+    void answerRequest(const CacheProtocolHeader& request, const UdpHeader& udp, const Ipv4Header& ip);
+
+    /**
+     * \param id the object id
+     * \param hops links between the node that served the object and the router
+     * \return true if the Placement keeps a copy here
+     */
+    bool shouldPlace(uint32_t id, uint32_t hops);
+
+    /**
+     * \param ip the IP header of a datagram about to be forwarded
+     * \return the links it travelled, this router's included
+     */
+    uint32_t getHops(const Ipv4Header& ip) const;
+
+    /**
+     * \brief Forget the forwarded requests left unanswered for RequestTimeout.
+     */
+    void expireRequests();
+
+    /// Request forwarded to the content server, waiting for its response
+    struct ForwardedRequest
+    {
+        uint32_t hops; //!< Links from the client
+        Time deadline; //!< Time after which the request is forgotten
+    };
+
+    uint32_t m_cacheSize;                             //!< Ids the cache holds
+    CacheEvictionPolicy::PolicyType m_evictionPolicy; //!< Replacement policy of the cache
+    Placement m_placement;                            //!< Which responses are stored
+    double m_targetWindow;                            //!< ProbCache T_tw, in copies per path
+    uint16_t m_contentPort;                           //!< Port of the content server
+    Ptr<CacheEvictionPolicy> m_cache;                 //!< Cached ids
+    std::unordered_map<uint32_t, Time> m_expirations; //!< Expiration of the cached ids sent with a TTL
+    std::unordered_map<uint32_t, ForwardedRequest> m_requestHops; //!< Last forwarded request of each id
+    std::deque<std::pair<uint32_t, Time>> m_requestDeadlines; //!< Forwarded ids, by deadline
+    Time m_requestTimeout;                            //!< Time a forwarded request waits for its response
+    Ptr<OnPathInterceptor> m_interceptor;             //!< Hook in the routing of the node
+    Ptr<Ipv4> m_ipv4;                                 //!< IPv4 stack of the node
+    uint8_t m_initialTtl;                             //!< TTL the senders put in their datagrams
+    Ptr<UniformRandomVariable> m_random;              //!< Draws of the ProbCache placement
+    uint32_t m_requests;                              //!< Requests that crossed the router
+    uint32_t m_hits;                                  //!< Requests answered from the cache
+    uint64_t m_hitHops;                               //!< Links from the clients, summed over the hits
+    uint32_t m_responses;                             //!< Responses that crossed the router
+    uint32_t m_placed;                                //!< Objects stored
+};
+
+} // namespace ns3
+
+#endif /* UDP_ROUTER_CACHE_H */
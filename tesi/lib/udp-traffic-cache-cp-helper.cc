@@ -2,14 +2,104 @@
 #include "udp-cache-server.h"
 #include "udp-traffic-generator.h"
 #include "udp-content-provider.h"
+#include "udp-router-cache.h"
 
+#include "ns3/enum.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
 #include "ns3/names.h"
+#include "ns3/node-list.h"
+#include "ns3/packet.h"
 #include "ns3/uinteger.h"
 
+#include <fstream>
+#include <iostream>
+
 namespace ns3
 {
 
+namespace
+{
+
+/**
+ * \param address an IPv4 address
+ * \return the node owning the address, null if none
+ */
+Ptr<Node>
+FindNode(Ipv4Address address)
+{
+    for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); ++it)
+    {
+        Ptr<Ipv4> ipv4 = (*it)->GetObject<Ipv4>();
+        if (ipv4 && ipv4->GetInterfaceForAddress(address) >= 0)
+        {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * \param from the first node of the path
+ * \param to the destination address
+ * \return the links of the path the routing tables give, 0 if there is none
+ */
+uint32_t
+CountHops(Ptr<Node> from, Ipv4Address to)
+{
+    Ipv4Header header;
+    header.SetDestination(to);
+    header.SetProtocol(17);
+    Ptr<Node> node = from;
+    // a path longer than the TTL would never be travelled anyway
+    for (uint32_t hops = 0; hops < 255; hops++)
+    {
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        if (!ipv4 || ipv4->GetInterfaceForAddress(to) >= 0)
+        {
+            return ipv4 ? hops : 0;
+        }
+        Socket::SocketErrno error;
+        Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol()->RouteOutput(Create<Packet>(), header, nullptr, error);
+        if (!route)
+        {
+            return 0;
+        }
+        // a zero gateway means the destination is on the link
+        if (route->GetGateway() == Ipv4Address::GetZero())
+        {
+            return hops + 1;
+        }
+        node = FindNode(route->GetGateway());
+        if (!node)
+        {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \param address the remote of a client, with or without its port
+ * \return its IPv4 address
+ */
+Ipv4Address
+GetIpv4(const Address& address)
+{
+    if (InetSocketAddress::IsMatchingType(address))
+    {
+        return InetSocketAddress::ConvertFrom(address).GetIpv4();
+    }
+    return Ipv4Address::ConvertFrom(address);
+}
+
+} // namespace
+
 UdpCacheServerHelper::UdpCacheServerHelper(Address contentSever, uint16_t portContentServer, uint16_t portClients)
+    : m_portClients(portClients)
 {
     m_factory.SetTypeId(UdpCacheServer::GetTypeId());
     SetAttribute("PortClients", UintegerValue(portClients));
@@ -23,6 +113,12 @@ UdpCacheServerHelper::SetAttribute(std::string name, const AttributeValue& value
     m_factory.Set(name, value);
 }
 
+void
+UdpCacheServerHelper::SetTypeId(std::string typeId)
+{
+    m_factory.SetTypeId(typeId);
+}
+
 ApplicationContainer
 UdpCacheServerHelper::Install(Ptr<Node> node) const
 {
@@ -57,6 +153,194 @@ UdpCacheServerHelper::InstallPriv(Ptr<Node> node) const
     return app;
 }
 
+void
+UdpCacheServerHelper::SetLevelAttribute(uint32_t level, std::string name, const AttributeValue& value)
+{
+    m_levelAttributes.push_back({level, name, value.Copy()});
+}
+
+std::vector<ApplicationContainer>
+UdpCacheServerHelper::InstallHierarchy(const std::vector<NodeContainer>& levels, HierarchyMode mode) const
+{
+    std::vector<ApplicationContainer> apps(levels.size());
+    for (uint32_t level = 0; level < levels.size(); level++)
+    {
+        ObjectFactory factory = m_factory;
+        UdpCacheServer::Placement placement = UdpCacheServer::LEAVE_COPY_EVERYWHERE;
+        if (mode == LEAVE_COPY_DOWN)
+        {
+            placement = UdpCacheServer::LEAVE_COPY_DOWN;
+        }
+        else if (mode == EDGE_ONLY && level > 0)
+        {
+            placement = UdpCacheServer::NO_COPY;
+        }
+        factory.Set("Placement", EnumValue(placement));
+        for (const LevelAttribute& attribute : m_levelAttributes)
+        {
+            if (attribute.level == level)
+            {
+                factory.Set(attribute.name, *attribute.value);
+            }
+        }
+
+        const NodeContainer& nodes = levels[level];
+        for (uint32_t i = 0; i < nodes.GetN(); i++)
+        {
+            if (level + 1 < levels.size())
+            {
+                // contiguous groups of children share a parent
+                const NodeContainer& parents = levels[level + 1];
+                NS_ASSERT_MSG(parents.GetN() > 0, "Level " << level + 1 << " of the hierarchy has no node");
+                Ptr<Node> parent = parents.Get(uint64_t(i) * parents.GetN() / nodes.GetN());
+                Ptr<Ipv4> ipv4 = parent->GetObject<Ipv4>();
+                NS_ASSERT_MSG(ipv4 && ipv4->GetNInterfaces() > 1, "Parent cache node without an IPv4 address");
+                factory.Set("IpContentServer", AddressValue(ipv4->GetAddress(1, 0).GetLocal()));
+                factory.Set("PortContentServer", UintegerValue(m_portClients));
+            }
+            Ptr<Application> app = factory.Create<UdpCacheServer>();
+            nodes.Get(i)->AddApplication(app);
+            apps[level].Add(app);
+        }
+    }
+    return apps;
+}
+
+void
+UdpCacheServerHelper::ConnectSiblings(ApplicationContainer caches) const
+{
+    for (uint32_t i = 0; i < caches.GetN(); i++)
+    {
+        Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(caches.Get(i));
+        NS_ASSERT_MSG(cache, "Siblings must be UdpCacheServer applications");
+        for (uint32_t j = 0; j < caches.GetN(); j++)
+        {
+            if (j == i)
+            {
+                continue;
+            }
+            Ptr<Ipv4> ipv4 = caches.Get(j)->GetNode()->GetObject<Ipv4>();
+            NS_ASSERT_MSG(ipv4 && ipv4->GetNInterfaces() > 1, "Sibling cache node without an IPv4 address");
+            cache->AddSibling(InetSocketAddress(ipv4->GetAddress(1, 0).GetLocal(), m_portClients));
+        }
+    }
+}
+
+void
+UdpCacheServerHelper::ConnectOrigins(ApplicationContainer caches,
+                                     ApplicationContainer origins,
+                                     uint32_t catalogueSize) const
+{
+    NS_ASSERT_MSG(origins.GetN() > 0 && origins.GetN() <= catalogueSize,
+                  "Cannot split " << catalogueSize << " ids among " << origins.GetN() << " content servers");
+    for (uint32_t j = 0; j < origins.GetN(); j++)
+    {
+        NS_ASSERT_MSG(DynamicCast<UdpContentProvider>(origins.Get(j)), "Origins must be UdpContentProvider applications");
+        UintegerValue port;
+        origins.Get(j)->GetAttribute("Port", port);
+        Ptr<Ipv4> ipv4 = origins.Get(j)->GetNode()->GetObject<Ipv4>();
+        NS_ASSERT_MSG(ipv4 && ipv4->GetNInterfaces() > 1, "Content server node without an IPv4 address");
+        InetSocketAddress address(ipv4->GetAddress(1, 0).GetLocal(), static_cast<uint16_t>(port.Get()));
+        // ids are numbered from 1
+        uint32_t firstId = uint64_t(j) * catalogueSize / origins.GetN() + 1;
+        uint32_t lastId = uint64_t(j + 1) * catalogueSize / origins.GetN();
+        for (uint32_t i = 0; i < caches.GetN(); i++)
+        {
+            Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(caches.Get(i));
+            NS_ASSERT_MSG(cache, "Caches must be UdpCacheServer applications");
+            if (j == 0)
+            {
+                // the ids of no other range go to IpContentServer
+                cache->SetAttribute("IpContentServer", AddressValue(address));
+                cache->SetAttribute("PortContentServer", UintegerValue(address.GetPort()));
+            }
+            else
+            {
+                cache->AddOrigin(address, firstId, lastId);
+            }
+        }
+    }
+}
+
+void
+UdpCacheServerHelper::PrintHierarchyStats(const std::vector<ApplicationContainer>& levels, std::string fileName)
+{
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    uint64_t clientRequests = 0;
+    uint64_t originRequests = 0;
+    for (uint32_t level = 0; level < levels.size(); level++)
+    {
+        uint64_t accesses = 0;
+        uint64_t hits = 0;
+        uint64_t upstream = 0;
+        for (auto it = levels[level].Begin(); it != levels[level].End(); ++it)
+        {
+            Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(*it);
+            accesses += cache->GetAccesses();
+            hits += cache->GetHits();
+            upstream += cache->GetUpstreamRequests();
+        }
+        if (level == 0)
+        {
+            clientRequests = accesses;
+        }
+        // the last level is the one fetching from the content server
+        originRequests = upstream;
+        outputFile << "level:" << level << ";" << "caches:" << levels[level].GetN() << ";"
+                   << "accesses:" << accesses << ";" << "hits:" << hits << ";"
+                   << "hitratio:" << (accesses > 0 ? double(hits) / accesses : 0) << ";"
+                   << "upstreamrequests:" << upstream << ";" << std::endl;
+    }
+    outputFile << "clientrequests:" << clientRequests << ";" << "originrequests:" << originRequests << ";"
+               << "originoffload:" << (clientRequests > 0 ? 1 - double(originRequests) / clientRequests : 0) << ";"
+               << std::endl;
+    outputFile.close();
+}
+
+void
+UdpCacheServerHelper::PrintSiblingStats(ApplicationContainer caches, std::string fileName)
+{
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    uint64_t queries = 0;
+    uint64_t hits = 0;
+    uint64_t falsePositives = 0;
+    uint64_t timeouts = 0;
+    uint64_t summaryBytes = 0;
+    for (uint32_t i = 0; i < caches.GetN(); i++)
+    {
+        Ptr<UdpCacheServer> cache = DynamicCast<UdpCacheServer>(caches.Get(i));
+        NS_ASSERT_MSG(cache, "Siblings must be UdpCacheServer applications");
+        queries += cache->GetSiblingQueries();
+        hits += cache->GetSiblingHits();
+        falsePositives += cache->GetSiblingFalsePositives();
+        timeouts += cache->GetSiblingTimeouts();
+        summaryBytes += cache->GetSummaryBytesSent();
+        outputFile << "node:" << cache->GetNode()->GetId() << ";"
+                   << "siblingqueries:" << cache->GetSiblingQueries() << ";"
+                   << "siblinghits:" << cache->GetSiblingHits() << ";"
+                   << "falsepositives:" << cache->GetSiblingFalsePositives() << ";"
+                   << "siblingtimeouts:" << cache->GetSiblingTimeouts() << ";"
+                   << "summarybytes:" << cache->GetSummaryBytesSent() << ";" << std::endl;
+    }
+    outputFile << "caches:" << caches.GetN() << ";" << "siblingqueries:" << queries << ";"
+               << "siblinghits:" << hits << ";"
+               << "falsepositiverate:" << (queries > 0 ? double(falsePositives) / queries : 0) << ";"
+               << "siblingtimeouts:" << timeouts << ";" << "summarybytes:" << summaryBytes << ";" << std::endl;
+    outputFile.close();
+}
+
 UdpTrafficGeneratorHelper::UdpTrafficGeneratorHelper(Address address, uint16_t port)
 {
     m_factory.SetTypeId(UdpTrafficGenerator::GetTypeId());
@@ -163,4 +447,96 @@ UdpContentProviderHelper::InstallPriv(Ptr<Node> node) const
 }
 
 
+UdpRouterCacheHelper::UdpRouterCacheHelper(uint16_t contentPort)
+{
+    m_factory.SetTypeId(UdpRouterCache::GetTypeId());
+    SetAttribute("ContentPort", UintegerValue(contentPort));
+}
+
+void
+UdpRouterCacheHelper::SetAttribute(std::string name, const AttributeValue& value)
+{
+    m_factory.Set(name, value);
+}
+
+ApplicationContainer
+UdpRouterCacheHelper::Install(Ptr<Node> node) const
+{
+    return ApplicationContainer(InstallPriv(node));
+}
+
+ApplicationContainer
+UdpRouterCacheHelper::Install(NodeContainer c) const
+{
+    ApplicationContainer apps;
+    for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i)
+    {
+        apps.Add(InstallPriv(*i));
+    }
+
+    return apps;
+}
+
+Ptr<Application>
+UdpRouterCacheHelper::InstallPriv(Ptr<Node> node) const
+{
+    Ptr<Application> app = m_factory.Create<UdpRouterCache>();
+    node->AddApplication(app);
+
+    return app;
+}
+
+void
+UdpRouterCacheHelper::PrintPathStats(ApplicationContainer clients,
+                                     ApplicationContainer routers,
+                                     ApplicationContainer origin,
+                                     std::string fileName)
+{
+    std::ofstream outputFile(fileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening file " << fileName << std::endl;
+        return;
+    }
+    Ptr<Node> originNode = origin.Get(0)->GetNode();
+    Ipv4Address originAddress = originNode->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+
+    uint64_t sent = 0;
+    uint64_t hops = 0;
+    uint64_t shortestHops = 0;
+    for (uint32_t i = 0; i < clients.GetN(); i++)
+    {
+        Ptr<UdpTrafficGenerator> client = DynamicCast<UdpTrafficGenerator>(clients.Get(i));
+        uint32_t shortest = CountHops(client->GetNode(), originAddress);
+        // a dedicated cache relays its misses over the links to the content server
+        Ptr<Node> peer = FindNode(GetIpv4(client->GetRemote()));
+        uint32_t upstream = peer && peer != originNode ? CountHops(peer, originAddress) : 0;
+        uint64_t clientHops = client->GetResponseHops() + uint64_t(client->GetRelayed()) * upstream;
+        uint64_t clientShortest = uint64_t(client->GetReceived()) * shortest;
+        sent += client->GetSent();
+        hops += clientHops;
+        shortestHops += clientShortest;
+        outputFile << "client:" << i << ";" << "sent:" << client->GetSent() << ";"
+                   << "received:" << client->GetReceived() << ";" << "shortesthops:" << shortest << ";"
+                   << "relayed:" << client->GetRelayed() << ";" << "hops:" << clientHops << ";"
+                   << "stretch:" << (clientShortest > 0 ? double(clientHops) / clientShortest : 0) << ";"
+                   << std::endl;
+    }
+    for (uint32_t i = 0; i < routers.GetN(); i++)
+    {
+        Ptr<UdpRouterCache> router = DynamicCast<UdpRouterCache>(routers.Get(i));
+        outputFile << "router:" << router->GetNode()->GetId() << ";" << "requests:" << router->GetRequests() << ";"
+                   << "hits:" << router->GetHits() << ";"
+                   << "hitratio:" << (router->GetRequests() > 0 ? double(router->GetHits()) / router->GetRequests() : 0)
+                   << ";" << "hithops:" << router->GetHitHops() << ";" << "placed:" << router->GetPlaced() << ";"
+                   << std::endl;
+    }
+    uint32_t originRequests = DynamicCast<UdpContentProvider>(origin.Get(0))->GetRequests();
+    outputFile << "sent:" << sent << ";" << "originrequests:" << originRequests << ";"
+               << "originload:" << (sent > 0 ? double(originRequests) / sent : 0) << ";"
+               << "stretch:" << (shortestHops > 0 ? double(hops) / shortestHops : 0) << ";" << std::endl;
+    outputFile.close();
+}
+
 } // namespace ns3
@@ -8,6 +8,8 @@
 #include "ns3/object-factory.h"
 
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 namespace ns3
 {
@@ -15,6 +17,14 @@ namespace ns3
 class UdpCacheServerHelper
 {
   public:
+    /// Levels of a tree of caches that keep the objects they fetch
+    enum HierarchyMode
+    {
+        LEAVE_COPY_EVERYWHERE, //!< Every level on the path of a miss
+        LEAVE_COPY_DOWN,       //!< The level below the one that served the object
+        EDGE_ONLY,             //!< The edge level only, the others relay the misses
+    };
+
     /**
      * Create UdpCacheServerHelper which will make life easier for people trying
      * to set up simulations with echos.
@@ -31,6 +41,15 @@ class UdpCacheServerHelper
      */
     void SetAttribute(std::string name, const AttributeValue& value);
 
+    /**
+     * Select the type of the installed cache servers, e.g.
+     * "ns3::LruUdpCacheServer" for a server specialized at compile time
+     * for one eviction policy. The default is "ns3::UdpCacheServer".
+     *
+     * \param typeId the name of a TypeId derived from ns3::UdpCacheServer
+     */
+    void SetTypeId(std::string typeId);
+
     /**
      * Create a UdpCacheServerApplication on the specified Node.
      *
@@ -64,6 +83,79 @@ class UdpCacheServerHelper
      */
     ApplicationContainer Install(NodeContainer c) const;
 
+    /**
+     * Record an attribute to be set only on the caches of one level of a
+     * hierarchy, after the ones set with SetAttribute, e.g. its EvictionPolicy
+     * or CacheSize.
+     *
+     * \param level the level, 0 for the edge
+     * \param name the name of the attribute to set
+     * \param value the value of the attribute to set
+     */
+    void SetLevelAttribute(uint32_t level, std::string name, const AttributeValue& value);
+
+    /**
+     * Create a tree of caches. Clients are meant to send their requests to
+     * the first level; the caches of each level fetch from a cache of the
+     * level above, the nodes of a level being split into contiguous groups
+     * with one parent each, and the last level fetches from the content server
+     * of this helper. A parent is addressed by the first IPv4 address of its
+     * node, on the clients port.
+     *
+     * \param levels the nodes of each level, edge first
+     * \param mode the levels keeping the fetched objects
+     * \returns the applications created, one container per level
+     */
+    std::vector<ApplicationContainer> InstallHierarchy(const std::vector<NodeContainer>& levels,
+                                                       HierarchyMode mode) const;
+
+    /**
+     * Make every cache of a group a sibling of the others: they exchange
+     * summaries of their contents and ask each other on misses before the
+     * content server. A sibling is addressed by the first IPv4 address of its
+     * node, on the clients port. Call it before the caches start.
+     *
+     * \param caches the caches of the group, installed by this helper
+     */
+    void ConnectSiblings(ApplicationContainer caches) const;
+
+    /**
+     * Split the ids from 1 to catalogueSize among a fleet of content servers,
+     * in contiguous ranges of about the same size, and make every cache fetch
+     * each range from its owner. The first server of the fleet replaces the
+     * content server of this helper and owns the first range, so each server
+     * is asked once, under RANGE and HASH OriginPartitioning alike. A
+     * content server is addressed by the first IPv4 address of its node, on
+     * its Port. Call it before the caches start.
+     *
+     * \param caches the caches, installed by this helper
+     * \param origins the UdpContentProvider applications of the fleet,
+     *                e.g. installed by UdpContentProviderHelper on a NodeContainer
+     * \param catalogueSize the number of objects
+     */
+    void ConnectOrigins(ApplicationContainer caches, ApplicationContainer origins, uint32_t catalogueSize) const;
+
+    /**
+     * Write the hit ratio of each level of a hierarchy and the share of the
+     * client requests kept away from the content server, one line per level
+     * then a summary line. Call it after Simulator::Run.
+     *
+     * \param levels the applications returned by InstallHierarchy
+     * \param fileName the output file
+     */
+    static void PrintHierarchyStats(const std::vector<ApplicationContainer>& levels,
+                                    std::string fileName = "output/hierarchystats.txt");
+
+    /**
+     * Write the sibling counters of each cache of a group, one line per
+     * cache then a summary line, in a single file instead of the per-node
+     * cachestats. Call it after Simulator::Run.
+     *
+     * \param caches the caches connected by ConnectSiblings
+     * \param fileName the output file
+     */
+    static void PrintSiblingStats(ApplicationContainer caches, std::string fileName = "output/siblingstats.txt");
+
   private:
     /**
      * Install an ns3::UdpCacheServer on the node configured with all the
@@ -74,7 +166,17 @@ class UdpCacheServerHelper
      */
     Ptr<Application> InstallPriv(Ptr<Node> node) const;
 
+    /// Attribute of the caches of one level
+    struct LevelAttribute
+    {
+        uint32_t level;              //!< Level, 0 for the edge
+        std::string name;            //!< Attribute name
+        Ptr<AttributeValue> value;   //!< Attribute value
+    };
+
     ObjectFactory m_factory; //!< Object factory.
+    uint16_t m_portClients;  //!< Port the caches listen on for clients, and for child caches
+    std::vector<LevelAttribute> m_levelAttributes; //!< Attributes of single levels
 };
 
 /**
@@ -233,6 +335,75 @@ class UdpContentProviderHelper
     ObjectFactory m_factory; //!< Object factory.
 };
 
+/**
+ * \ingroup udpcache
+ * \brief Create UdpRouterCache applications on the routers between the clients and a content server
+ */
+class UdpRouterCacheHelper
+{
+  public:
+    /**
+     * \param contentPort the port of the content server whose traffic is cached
+     */
+    UdpRouterCacheHelper(uint16_t contentPort);
+
+    /**
+     * Record an attribute to be set in each Application after it is is created.
+     *
+     * \param name the name of the attribute to set
+     * \param value the value of the attribute to set
+     */
+    void SetAttribute(std::string name, const AttributeValue& value);
+
+    /**
+     * Create a UdpRouterCache on the specified Node, whose IPv4 routing must be
+     * an Ipv4ListRouting, as set up by the InternetStackHelper.
+     *
+     * \param node The node on which to create the Application.
+     *
+     * \returns An ApplicationContainer holding the Application created.
+     */
+    ApplicationContainer Install(Ptr<Node> node) const;
+
+    /**
+     * \param c The nodes on which to create the Applications.
+     *
+     * \returns The applications created, one Application per Node in the
+     *          NodeContainer.
+     */
+    ApplicationContainer Install(NodeContainer c) const;
+
+    /**
+     * Write the path stretch of every client, the hit ratio of every router
+     * cache and the share of the requests reaching the content server, one
+     * line each then a summary line. The stretch is the links travelled by
+     * the responses over the shortest path to the content server, a response
+     * relayed by a dedicated cache also counting the links between the cache
+     * and the content server. Call it after Simulator::Run.
+     *
+     * \param clients the UdpTrafficGenerator clients
+     * \param routers the UdpRouterCache applications, possibly none
+     * \param origin the UdpContentProvider
+     * \param fileName the output file
+     */
+    static void PrintPathStats(ApplicationContainer clients,
+                               ApplicationContainer routers,
+                               ApplicationContainer origin,
+                               std::string fileName = "output/pathstats.txt");
+
+  private:
+    /**
+     * Install an ns3::UdpRouterCache on the node configured with all the
+     * attributes set with SetAttribute.
+     *
+     * \param node The node on which an UdpRouterCache will be installed.
+     * \returns Ptr to the application installed.
+     */
+    Ptr<Application> InstallPriv(Ptr<Node> node) const;
+
+    ObjectFactory m_factory; //!< Object factory.
+};
+
 } // namespace ns3
 
 #endif /* UDP_TRAFFIC_CACHE_CP_HELPER_H */
@@ -3,7 +3,9 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv4.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
@@ -13,13 +15,14 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
 #include "ns3/seq-ts-header.h"
 
 #include <unordered_map>
 #include <fstream>
 #include <cstdlib>
 #include <cstdio>
-#include <regex>
 
 namespace ns3
 {
@@ -65,6 +68,43 @@ UdpTrafficGenerator::GetTypeId()
                           UintegerValue(50),
                           MakeUintegerAccessor(&UdpTrafficGenerator::normal_mean),
                           MakeUintegerChecker<uint32_t>())
+            .AddAttribute("Popularity",
+                          "Distribution of the requested ids: NORMAL, ZIPF or ZIPF_MANDELBROT over "
+                          "CatalogueSize ids, or FILE with the weights of PopularityFile",
+                          EnumValue(UdpTrafficGenerator::NORMAL),
+                          MakeEnumAccessor(&UdpTrafficGenerator::m_popularity),
+                          MakeEnumChecker(UdpTrafficGenerator::NORMAL, "NORMAL",
+                                          UdpTrafficGenerator::ZIPF, "ZIPF",
+                                          UdpTrafficGenerator::ZIPF_MANDELBROT, "ZIPF_MANDELBROT",
+                                          UdpTrafficGenerator::FILE_PMF, "FILE"))
+            .AddAttribute("CatalogueSize",
+                          "Number of ids of the Zipf distributions, from 1 to CatalogueSize, "
+                          "id 1 being the most popular",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&UdpTrafficGenerator::m_catalogueSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("ZipfExponent",
+                          "Exponent alpha of the Zipf distributions",
+                          DoubleValue(0.8),
+                          MakeDoubleAccessor(&UdpTrafficGenerator::m_zipfExponent),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MandelbrotShift",
+                          "Shift q of Zipf-Mandelbrot, flattening the head: id k has a "
+                          "probability proportional to 1 / (k + q)^alpha",
+                          DoubleValue(10),
+                          MakeDoubleAccessor(&UdpTrafficGenerator::m_mandelbrotShift),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("PopularityFile",
+                          "File with one \"id weight\" line per id, for the FILE popularity",
+                          StringValue(""),
+                          MakeStringAccessor(&UdpTrafficGenerator::m_popularityFile),
+                          MakeStringChecker())
+            .AddAttribute("Protocol",
+                          "Encoding of the requests sent to the cache",
+                          EnumValue(CacheProtocolHeader::BINARY),
+                          MakeEnumAccessor(&UdpTrafficGenerator::m_protocol),
+                          MakeEnumChecker(CacheProtocolHeader::TEXT, "TEXT",
+                                          CacheProtocolHeader::BINARY, "BINARY"))
             .AddTraceSource("Tx",
                             "A new packet is created and is sent",
                             MakeTraceSourceAccessor(&UdpTrafficGenerator::m_txTrace),
@@ -88,10 +128,12 @@ UdpTrafficGenerator::UdpTrafficGenerator()
 {
     NS_LOG_FUNCTION(this);
     m_sent = 0;
+    m_initialTtl = 64;
     m_socket = nullptr;
     m_sendEvent = EventId();
     m_data = nullptr;
     m_dataSize = 0;
+    m_idStream = CreateObject<UniformRandomVariable>();
 }
 
 UdpTrafficGenerator::~UdpTrafficGenerator()
@@ -134,12 +176,32 @@ UdpTrafficGenerator::StartApplication()
     NS_LOG_FUNCTION(this);
 
     random = CreateObject<NormalRandomVariable>();
+    if (m_popularity == ZIPF || m_popularity == ZIPF_MANDELBROT)
+    {
+        m_sampler.ConfigureZipf(m_catalogueSize, m_zipfExponent, m_popularity == ZIPF ? 0 : m_mandelbrotShift);
+    }
+    else if (m_popularity == FILE_PMF)
+    {
+        if (m_popularityFile.empty())
+        {
+            NS_FATAL_ERROR("The FILE popularity needs a PopularityFile");
+        }
+        m_sampler.ConfigureFile(m_popularityFile);
+    }
 
     if (!m_socket)
     {
         TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
         m_socket = Socket::CreateSocket(GetNode(), tid);
-        if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
+        if (m_ring)
+        {
+            // not connected: the responses come from every shard
+            if (m_socket->Bind() == -1)
+            {
+                NS_FATAL_ERROR("Failed to bind socket");
+            }
+        }
+        else if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
         {
             if (m_socket->Bind() == -1)
             {
@@ -164,6 +226,15 @@ UdpTrafficGenerator::StartApplication()
 
     m_socket->SetRecvCallback(MakeCallback(&UdpTrafficGenerator::HandleRead, this));
     m_socket->SetAllowBroadcast(true);
+    // the hops of each response are told by its TTL, the responders using the same default
+    m_socket->SetIpRecvTtl(true);
+    Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
+    if (ipv4)
+    {
+        UintegerValue ttl;
+        ipv4->GetAttribute("DefaultTtl", ttl);
+        m_initialTtl = static_cast<uint8_t>(ttl.Get());
+    }
     ScheduleTransmit(Seconds(0.));
 }
 
@@ -206,6 +277,66 @@ UdpTrafficGenerator::SetFill(std::string fill)
     m_size = dataSize;
 }
 
+void
+UdpTrafficGenerator::SetShardRing(Ptr<ConsistentHashRing> ring)
+{
+    NS_LOG_FUNCTION(this);
+    m_ring = ring;
+}
+
+Address
+UdpTrafficGenerator::GetRemote() const
+{
+    return m_peerAddress;
+}
+
+uint32_t
+UdpTrafficGenerator::GetSent() const
+{
+    return m_sent;
+}
+
+uint32_t
+UdpTrafficGenerator::GetReceived() const
+{
+    uint32_t received = 0;
+    for (const PacketInfo& info : packetList)
+    {
+        received += info.receivedAt != 0;
+    }
+    return received;
+}
+
+uint64_t
+UdpTrafficGenerator::GetResponseHops() const
+{
+    uint64_t hops = 0;
+    for (const PacketInfo& info : packetList)
+    {
+        hops += info.hops;
+    }
+    return hops;
+}
+
+uint32_t
+UdpTrafficGenerator::GetRelayed() const
+{
+    uint32_t relayed = 0;
+    for (const PacketInfo& info : packetList)
+    {
+        relayed += info.receivedAt != 0 && info.relayed;
+    }
+    return relayed;
+}
+
+int64_t
+UdpTrafficGenerator::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_idStream->SetStream(stream);
+    return 1;
+}
+
 void
 UdpTrafficGenerator::ScheduleTransmit(Time dt)
 {
@@ -221,9 +352,23 @@ UdpTrafficGenerator::Send()
     NS_ASSERT(m_sendEvent.IsExpired());
 
     uint32_t randomNumber = UdpTrafficGenerator::getRandomNumber();
-    std::string message = "{ \"sender\": \"client\", \"type\": \"request\", \"id\": " + std::to_string(randomNumber) + " }";
-    UdpTrafficGenerator::SetFill(message);
-    Ptr<Packet> p = Create<Packet>(m_data, m_dataSize);
+    Ptr<Packet> p;
+    if (m_protocol == CacheProtocolHeader::BINARY)
+    {
+        CacheProtocolHeader header;
+        header.SetMessageType(CacheProtocolHeader::REQUEST);
+        header.SetRole(CacheProtocolHeader::CLIENT);
+        header.SetSequence(m_sent + 1);
+        header.SetObjectId(randomNumber);
+        p = Create<Packet>();
+        p->AddHeader(header);
+        m_size = p->GetSize();
+    }
+    else
+    {
+        p = CacheProtocolHeader::CreateTextPacket("client", "request", randomNumber);
+        m_size = p->GetSize();
+    }
     
     Address localAddress;
     m_socket->GetSockName(localAddress);
@@ -238,7 +383,16 @@ UdpTrafficGenerator::Send()
             InetSocketAddress(Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
     }
 
-    if(m_socket->Send(p)==-1){
+    int sent;
+    if (m_ring && m_ring->GetShardCount() > 0)
+    {
+        sent = m_socket->SendTo(p, 0, m_ring->GetAddress(m_ring->GetShard(randomNumber)));
+    }
+    else
+    {
+        sent = m_socket->Send(p);
+    }
+    if(sent==-1){
         NS_LOG_INFO("ERRORE INVIO PACCHETTO");
     }
     ++m_sent;
@@ -246,9 +400,12 @@ UdpTrafficGenerator::Send()
     PacketInfo newP = {
         randomNumber,
         (uint64_t)Simulator::Now().ToInteger(Time::MS),
-        0
+        0,
+        0,
+        0,
+        false
     };
-    packetList[m_sent] = newP;
+    packetList.push_back(newP);
 
     if (Ipv4Address::IsMatchingType(m_peerAddress))
     {
@@ -289,16 +446,53 @@ UdpTrafficGenerator::HandleRead(Ptr<Socket> socket)
         socket->GetSockName(localAddress);
         m_rxTrace(packet);
         m_rxTraceWithAddresses(packet, from, localAddress);
+        SocketIpTtlTag ttl;
+        uint32_t hops = packet->RemovePacketTag(ttl) && ttl.GetTtl() <= m_initialTtl ? m_initialTtl - ttl.GetTtl() + 1 : 0;
+
+        if (CacheProtocolHeader::IsBinary(packet))
+        {
+            // the response echoes the sequence number, which indexes packetList
+            CacheProtocolHeader header;
+            packet->PeekHeader(header);
+            uint32_t seq = header.GetSequence();
+            // a shed request stays unanswered
+            if ((header.GetFlags() & CacheProtocolHeader::BUSY) || seq == 0 || seq > packetList.size() ||
+                packetList[seq - 1].id != header.GetObjectId() ||
+                packetList[seq - 1].receivedAt != 0)
+            {
+                continue;
+            }
+            if (header.GetFlags() & CacheProtocolHeader::SEGMENT)
+            {
+                // the object is received when its last missing segment arrives
+                Ptr<Packet> payload = packet->Copy();
+                CacheSegmentHeader segment;
+                payload->RemoveHeader(header);
+                payload->RemoveHeader(segment);
+                if (!m_reassembly.AddSegment(seq, segment.GetObjectSize(), segment.GetOffset(), payload->GetSize()))
+                {
+                    continue;
+                }
+                packetList[seq - 1].size = segment.GetObjectSize();
+            }
+            packetList[seq - 1].receivedAt = (uint64_t)Simulator::Now().ToInteger(Time::MS);
+            packetList[seq - 1].hops = hops;
+            packetList[seq - 1].relayed = header.GetRole() == CacheProtocolHeader::CACHE &&
+                                          !(header.GetFlags() & CacheProtocolHeader::CACHED);
+            continue;
+        }
 
         uint32_t value_from_pkt = getIdPacket(packet);
 
-        for (auto it = packetList.begin(); it != packetList.end(); it++)
+        // text responses carry no sequence number: match the oldest pending request for the id
+        for (PacketInfo& info : packetList)
         {
-            if (it->second.id == value_from_pkt && it->second.receivedAt == 0)
+            if (info.id == value_from_pkt && info.receivedAt == 0)
             {
-                it->second.receivedAt = (uint64_t)Simulator::Now().ToInteger(Time::MS);
+                info.receivedAt = (uint64_t)Simulator::Now().ToInteger(Time::MS);
+                info.hops = hops;
                 break;
-            }     
+            }
         }
     }
 }
@@ -306,26 +500,14 @@ UdpTrafficGenerator::HandleRead(Ptr<Socket> socket)
 uint32_t
 UdpTrafficGenerator::getIdPacket(Ptr<Packet> packet)
 {
-    uint8_t* buffer = new uint8_t[packet->GetSize()];
-    packet->CopyData(buffer, packet->GetSize());
-    std::string payload = std::string(reinterpret_cast<char*>(buffer), packet->GetSize());
-    std::regex six_digit_number_regex(R"(\b\d{1,6}\b)");
-
-    std::smatch matches;
-    if (std::regex_search(payload, matches, six_digit_number_regex))
-    {
-        std::string id = matches[0];
-        return static_cast<uint32_t>(std::stoul(id));
-    }
-    else
-    {
-        // handle whenever the id is not found
-        return 0;
-    }
+    return CacheProtocolHeader::ReadTextId(packet, m_rxBuffer);
 }
 
 uint32_t
 UdpTrafficGenerator::getRandomNumber(){
+    if (m_popularity != NORMAL) {
+        return m_sampler.Sample(m_idStream);
+    }
     return random->GetInteger(normal_mean,normal_variance,100);
 }
 
@@ -338,10 +520,9 @@ void UdpTrafficGenerator::printArrayToCSV(std::string filename) {
         return;
     }
     
-    for (const auto& pair : packetList) {
-        const uint32_t& key = pair.first;
-        const PacketInfo& value = pair.second;
-        outputFile << key << ";" << value.id << ";" << value.requestedAt << ";" << value.receivedAt << std::endl;
+    for (uint32_t i = 0; i < packetList.size(); i++) {
+        const PacketInfo& value = packetList[i];
+        outputFile << i + 1 << ";" << value.id << ";" << value.requestedAt << ";" << value.receivedAt << ";" << value.size << ";" << value.hops << "\n";
     }
     outputFile.close();
 }
@@ -1,6 +1,11 @@
 #ifndef UDP_TRAFFIC_GENERATOR_H
 #define UDP_TRAFFIC_GENERATOR_H
 
+#include "cache-protocol-header.h"
+#include "consistent-hash-ring.h"
+#include "object-transfer.h"
+#include "popularity-sampler.h"
+
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ipv4-address.h"
@@ -8,6 +13,7 @@
 #include "ns3/traced-callback.h"
 #include "ns3/random-variable-stream.h"
 #include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -18,6 +24,15 @@ class Packet;
 class UdpTrafficGenerator : public Application
 {
   public:
+    /// Distribution of the requested ids
+    enum Popularity
+    {
+        NORMAL,          //!< NormalMean and NormalVariance, at most 100 from the mean
+        ZIPF,            //!< Zipf over the ids from 1 to CatalogueSize
+        ZIPF_MANDELBROT, //!< Zipf-Mandelbrot over the ids from 1 to CatalogueSize
+        FILE_PMF,        //!< Weights of the PopularityFile
+    };
+
     /**
      * \brief Get the type ID.
      * \return the object TypeId
@@ -52,6 +67,44 @@ class UdpTrafficGenerator : public Application
      */
     void SetFill(std::string fill);
 
+    /**
+     * \brief Route every request to the shard owning its id instead of the remote peer.
+     * \param ring the ring of the cluster, shared with it; null to use the remote peer
+     */
+    void SetShardRing(Ptr<ConsistentHashRing> ring);
+
+    /**
+     * \return the remote peer, as set by SetRemote
+     */
+    Address GetRemote() const;
+
+    /**
+     * \return the requests sent so far
+     */
+    uint32_t GetSent() const;
+
+    /**
+     * \return the requests answered so far
+     */
+    uint32_t GetReceived() const;
+
+    /**
+     * \return the links travelled by the responses received so far, from their IP TTL
+     */
+    uint64_t GetResponseHops() const;
+
+    /**
+     * \return the responses a cache relayed from upstream instead of serving them from its contents
+     */
+    uint32_t GetRelayed() const;
+
+    /**
+     * \brief Fix the random stream of the requested ids, for reproducible runs.
+     * \param stream the first stream index
+     * \return the number of streams used
+     */
+    int64_t AssignStreams(int64_t stream);
+
   protected:
     void DoDispose() override;
 
@@ -96,21 +149,39 @@ class UdpTrafficGenerator : public Application
     uint32_t m_sent;       //!< Counter for sent packets
     Ptr<Socket> m_socket;  //!< Socket
     Address m_peerAddress; //!< Remote peer address
+    Ptr<ConsistentHashRing> m_ring; //!< Shards the requests are routed to, null for the remote peer
     uint16_t m_peerPort;   //!< Remote peer port
     EventId m_sendEvent;   //!< Event to send the next packet
 
     uint32_t normal_mean;
     uint32_t normal_variance;
+    Popularity m_popularity;        //!< Distribution of the requested ids
+    uint32_t m_catalogueSize;       //!< Ids of Zipf and Zipf-Mandelbrot
+    double m_zipfExponent;          //!< Zipf alpha
+    double m_mandelbrotShift;       //!< Zipf-Mandelbrot q
+    std::string m_popularityFile;   //!< File of "id weight" lines for FILE_PMF
+    PopularitySampler m_sampler;    //!< Sampler of the Zipf and file distributions
+    Ptr<UniformRandomVariable> m_idStream; //!< Uniforms of m_sampler
+
+    CacheProtocolHeader::Format m_protocol; //!< Encoding of the requests
+    uint8_t m_initialTtl;                   //!< IP TTL the responders send with
 
     struct PacketInfo {
       uint32_t id;
       uint64_t requestedAt;
-      uint64_t receivedAt;
+      uint64_t receivedAt; //!< Arrival of the response, or of the last segment of the object
+      uint32_t size;       //!< Object size, 0 for a single-datagram response
+      uint32_t hops;       //!< Links travelled by the response, 0 if unknown
+      bool relayed;        //!< Whether a cache relayed the response instead of serving it
     };
 
     Ptr<NormalRandomVariable> random;
 
-    std::unordered_map<uint32_t, PacketInfo> packetList;
+    /// Requests by sequence number: packet n is at index n - 1, without a per-request allocation
+    std::vector<PacketInfo> packetList;
+
+    std::vector<uint8_t> m_rxBuffer; //!< Scratch copy of a received text payload
+    ObjectReassembler m_reassembly;  //!< Segmented responses being received, by sequence number
 
     /// Callbacks for tracing the packet Tx events
     TracedCallback<Ptr<const Packet>> m_txTrace;
@@ -4,6 +4,7 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
 #include "lib/udp-traffic-cache-cp-helper.h"
+#include "lib/udp-traffic-generator.h"
 
 #include <fstream>
 
@@ -22,6 +23,33 @@ main(int argc, char* argv[])
   LogComponentEnable ("UdpCacheServerApplication", LOG_LEVEL_INFO);
 #endif
 
+    // none: clients ask the content server; dedicated: they ask the cache on node 5;
+    // onpath: they ask the content server and the routers 1, 2 and 4 cache on the path
+    std::string cacheMode = "none";
+    std::string placement = "LCE";
+    uint32_t cache_size = 20;
+    uint32_t origins = 1;
+    std::string popularity = "NORMAL";
+    double zipfExponent = 0.8;
+    uint32_t catalogueSize = 100;
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("cacheMode", "Caching: none, dedicated or onpath", cacheMode);
+    cmd.AddValue("placement", "Placement of the on-path caches: LCE, LCD or PROBCACHE", placement);
+    cmd.AddValue("cacheSize", "Cache size in ids", cache_size);
+    cmd.AddValue("origins", "Content servers sharing the catalogue in dedicated mode: 1, or 2 with node 2", origins);
+    cmd.AddValue("popularity", "Distribution of the requested ids: NORMAL, ZIPF or ZIPF_MANDELBROT", popularity);
+    cmd.AddValue("zipfExponent", "Exponent of the Zipf distributions", zipfExponent);
+    cmd.AddValue("catalogueSize", "Objects of the content servers, ids from 1 to catalogueSize", catalogueSize);
+    cmd.Parse(argc, argv);
+    if (cacheMode != "none" && cacheMode != "dedicated" && cacheMode != "onpath")
+    {
+        NS_FATAL_ERROR("Unknown cacheMode " << cacheMode);
+    }
+    if (origins != 1 && origins != 2)
+    {
+        NS_FATAL_ERROR("Unsupported number of origins " << origins);
+    }
+
     NS_LOG_INFO("Create nodes.");
     NodeContainer c;
     c.Create(6);
@@ -109,36 +137,67 @@ main(int argc, char* argv[])
 
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
-    //Address cacheAddress = Address(ipInterf45.GetAddress(1));
+    Address cacheAddress = Address(ipInterf45.GetAddress(1));
     Address contentServerAddress = Address(ipInterf23.GetAddress(1));
-    //NS_LOG_INFO("CACHE ADDRESS "<< ipInterf45.GetAddress(1));
+    NS_LOG_INFO("CACHE ADDRESS "<< ipInterf45.GetAddress(1));
     NS_LOG_INFO("CONTENT SERVER ADDRESS "<< ipInterf23.GetAddress(1));
 
     NS_LOG_INFO("Create Applications.");
     ApplicationContainer apps;
     uint16_t content_port = 15;
     UdpContentProviderHelper content_Server(content_port);
-    apps = content_Server.Install(nodeContainer_23.Get(1));
-    apps.Start(Seconds(0.0));
+    // updates, if enabled, change the objects of the whole catalogue
+    content_Server.SetAttribute("UpdateId",
+                                StringValue("ns3::UniformRandomVariable[Min=1|Max=" + std::to_string(catalogueSize) + "]"));
+    ApplicationContainer origin = content_Server.Install(nodeContainer_23.Get(1));
+    origin.Start(Seconds(0.0));
+
+    uint16_t port = 9; // well-known echo port number
+    if (cacheMode == "dedicated")
+    {
+        UdpCacheServerHelper cache(contentServerAddress, content_port, port);
+        cache.SetAttribute("CacheSize", UintegerValue(cache_size));
+        cache.SetAttribute("CatalogueSize", UintegerValue(catalogueSize));
+        apps = cache.Install(nodeContainer_45.Get(1));
+        if (origins == 2)
+        {
+            // node 2 serves the upper half of the catalogue
+            ApplicationContainer fleet = origin;
+            fleet.Add(content_Server.Install(c.Get(2)));
+            fleet.Get(1)->SetStartTime(Seconds(0.0));
+            cache.ConnectOrigins(apps, fleet, catalogueSize);
+        }
+        apps.Start(Seconds(1.0));
+    }
 
-    /* uint16_t port = 9; // well-known echo port number
-    uint32_t cache_size = 20;
-    UdpCacheServerHelper cache(contentServerAddress, content_port, port);
-    cache.SetAttribute("CacheSize", UintegerValue(cache_size));
-    apps = cache.Install(nodeContainer_45.Get(1));
-    apps.Start(Seconds(1.0)); */
+    ApplicationContainer routers;
+    if (cacheMode == "onpath")
+    {
+        UdpRouterCacheHelper routerCache(content_port);
+        routerCache.SetAttribute("CacheSize", UintegerValue(cache_size));
+        routerCache.SetAttribute("Placement", StringValue(placement));
+        routers.Add(routerCache.Install(c.Get(1)));
+        routers.Add(routerCache.Install(c.Get(2)));
+        routers.Add(routerCache.Install(c.Get(4)));
+        routers.Start(Seconds(1.0));
+    }
 
     uint32_t maxPacketCount = 100;
     Time interPacketInterval = MilliSeconds(49);
     uint32_t variance = 100;
     uint32_t mean = 50;
-    UdpTrafficGeneratorHelper client(contentServerAddress, content_port);
+    UdpTrafficGeneratorHelper client(cacheMode == "dedicated" ? cacheAddress : contentServerAddress,
+                                     cacheMode == "dedicated" ? port : content_port);
     client.SetAttribute("MaxPackets", UintegerValue(maxPacketCount));
     client.SetAttribute("Interval", TimeValue(interPacketInterval));
     client.SetAttribute("NormalVariance", UintegerValue(variance));
     client.SetAttribute("NormalMean", UintegerValue(mean));
-    apps = client.Install(nodeContainer_01.Get(0));
-    apps.Start(Seconds(2.0));
+    client.SetAttribute("Popularity", StringValue(popularity));
+    client.SetAttribute("ZipfExponent", DoubleValue(zipfExponent));
+    client.SetAttribute("CatalogueSize", UintegerValue(catalogueSize));
+    ApplicationContainer clients = client.Install(nodeContainer_01.Get(0));
+    DynamicCast<UdpTrafficGenerator>(clients.Get(0))->AssignStreams(1);
+    clients.Start(Seconds(2.0));
 
     //AsciiTraceHelper ascii;
     //csma.EnableAsciiAll(ascii.CreateFileStream("udp-echo.tr"));
@@ -148,6 +207,7 @@ main(int argc, char* argv[])
 
     NS_LOG_INFO("Run Simulation.");
     Simulator::Run();
+    UdpRouterCacheHelper::PrintPathStats(clients, routers, origin);
     Simulator::Destroy();
     NS_LOG_INFO("Done.");
 